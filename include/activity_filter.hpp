@@ -77,6 +77,15 @@ public:
         std::string const& p_substitution
     ) const;
 
+    /**
+     * @returns a pointer to a string such that the activities satisfying
+     * this filter are exactly that string and its subactivities, if this
+     * filter is known to be of that kind; otherwise returns null. This allows
+     * the matching activities to be looked up in an ActivityTrie, rather than
+     * each activity being tested in turn.
+     */
+    std::string const* subactivity_root() const;
+
 // virtual member functions
 private:
     virtual bool does_match(std::string const& p_str) const = 0;
@@ -86,6 +95,8 @@ private:
         std::string const& p_substitution
     ) const;
 
+    virtual std::string const* do_get_subactivity_root() const;
+
 };  // class ActivityFilter
 
 }  // namespace swx
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_activity_registry_hpp_1585054389609002
+#define GUARD_activity_registry_hpp_1585054389609002
+
+#include "activity_trie.hpp"
+#include "entries.hpp"
+#include "stint.hpp"
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace swx
+{
+
+/**
+ * An element of the activity table of a time log. An element with a
+ * reference count of zero is unused, and available to be reused for another
+ * activity. The name is immutable, and shared with each Stint of the
+ * activity; so that a Stint can be copied without copying the name, and can
+ * outlive the record (or the TimeLog) safely.
+ */
+struct ActivityRecord
+{
+    ActivityName name;
+
+    /// The number of entries with this activity.
+    Entries::Index reference_count;
+};
+
+/**
+ * Holds an ActivityRecord for each activity of a time log, indexed by
+ * ActivityId. A deque, rather than a vector, is used, so that references to
+ * activity records remain valid as activities are added.
+ */
+using ActivityTable = std::deque<ActivityRecord>;
+
+/**
+ * Maps each activity name in use to its ActivityId, being its position in an
+ * ActivityTable. Rather than holding a copy of each name in a node of its
+ * own, the registry is a single open-addressing hash table of (hash,
+ * ActivityId) slots, probed linearly, against the names in the activity
+ * table; so that a lookup allocates nothing, and registering an activity
+ * allocates nothing beyond the occasional growth of the table.
+ */
+class ActivityRegistry
+{
+// nested types
+public:
+    using ActivityId = ActivityTrie::ActivityId;
+    using size_type = std::vector<ActivityId>::size_type;
+
+private:
+    struct Slot
+    {
+        unsigned long long hash;
+        ActivityId activity_id;  // k_no_activity_id if the slot is empty
+    };
+
+// special member functions
+public:
+
+    /**
+     * @param p_activity_table the table in which registered activities are
+     *   looked up; must outlive the ActivityRegistry.
+     */
+    explicit ActivityRegistry(ActivityTable const& p_activity_table);
+
+    ActivityRegistry(ActivityRegistry const& rhs) = delete;
+    ActivityRegistry(ActivityRegistry&& rhs) = delete;
+    ActivityRegistry& operator=(ActivityRegistry const& rhs) = delete;
+    ActivityRegistry& operator=(ActivityRegistry&& rhs) = delete;
+    ~ActivityRegistry() = default;
+
+// ordinary member functions
+public:
+    size_type size() const;
+    bool empty() const;
+    void clear();
+
+    /**
+     * @returns true and sets \e p_activity_id if \e p_activity is
+     * registered; otherwise returns false.
+     */
+    bool find(std::string const& p_activity, ActivityId& p_activity_id) const;
+
+    bool contains(std::string const& p_activity) const;
+
+    /**
+     * Registers \e p_activity as having \e p_activity_id, by which it must be
+     * found in the activity table whenever it is looked up.
+     *
+     * @returns false, registering nothing, if \e p_activity is already
+     * registered.
+     */
+    bool insert(std::string const& p_activity, ActivityId p_activity_id);
+
+    /**
+     * Unregisters \e p_activity, which must be registered, and must still be
+     * in the activity table.
+     */
+    void erase(std::string const& p_activity);
+
+private:
+    static ActivityId const k_no_activity_id = static_cast<ActivityId>(-1);
+
+    static unsigned long long hash(std::string const& p_activity);
+
+    // Returns the index of the slot holding p_activity, or of the empty slot
+    // at which its probe sequence ends.
+    std::vector<Slot>::size_type probe(std::string const& p_activity) const;
+
+    void grow();
+
+// member variables
+private:
+    ActivityTable const& m_activity_table;
+    std::vector<Slot> m_slots;  // the number of slots is a power of two
+    size_type m_size = 0;
+
+};  // class ActivityRegistry
+
+}  // namespace swx
+
+#endif  // GUARD_activity_registry_hpp_1585054389609002
@@ -17,31 +17,46 @@
 #ifndef GUARD_activity_tree_hpp_4902535711835388
 #define GUARD_activity_tree_hpp_4902535711835388
 
-#include "activity_node.hpp"
-#include "activity_stats_fwd.hpp"
+#include "activity_stats.hpp"
+#include <cstddef>
 #include <functional>
 #include <map>
-#include <set>
 #include <ostream>
 #include <string>
+#include <vector>
 
 namespace swx
 {
 
+/**
+ * Represents a tree of nested activities, each node of which corresponds
+ * to a sequence of single-space-separated activity components, and holds
+ * the combined ActivityStats of the activities beneath it.
+ */
 class ActivityTree
 {
 // nested types
 private:
-    struct ActivityData
+    using NodeIndex = std::size_t;
+    using ComponentId = std::size_t;
+
+    /**
+     * The children of a node are held as a linked list, in ascending
+     * order of their components, via \e first_child and \e next_sibling.
+     */
+    struct Node
     {
-        explicit ActivityData
-        (   ActivityStats const& p_stats = ActivityStats(),
-            std::set<ActivityNode> const& p_children = std::set<ActivityNode>()
-        );
+        ComponentId component;
+        NodeIndex parent;
+        NodeIndex first_child;
+        NodeIndex last_child;
+        NodeIndex next_sibling;
+        std::size_t num_children;
         ActivityStats stats;
-        std::set<ActivityNode> children;
     };
 
+    class Builder;
+
 public:
     using PrintNode = std::function
     <   void
@@ -55,7 +70,23 @@ public:
 
 // special member functions
 public:
-    explicit ActivityTree(std::map<std::string, ActivityStats> const& p_stats);
+
+    /**
+     * Builds the tree in a single pass over the activities in
+     * \e p_stats, taken in ascending order of their components (which,
+     * unless an activity contains characters that sort before a space,
+     * is the order in which \e p_stats holds them).
+     *
+     * If \e p_depth_limit is not 0, the tree is built only as far as
+     * print will reach with a PrintNode that prints nodes only to a depth
+     * less than \e p_depth_limit: the nodes beneath a node that would be
+     * printed at depth <em>p_depth_limit - 1</em> are not built, and its
+     * stats are combined directly from the activities beneath it.
+     */
+    explicit ActivityTree
+    (   std::map<std::string, ActivityStats> const& p_stats,
+        unsigned int p_depth_limit = 0
+    );
     ActivityTree(ActivityTree const& rhs) = delete;
     ActivityTree(ActivityTree&& rhs) = delete;
     ActivityTree& operator=(ActivityTree const& rhs) = delete;
@@ -64,9 +95,11 @@ public:
 
 // ordinary member functions
 private:
+    NodeIndex add_child(NodeIndex p_parent, ComponentId p_component);
+
     void print
     (   std::ostream& p_os,
-        ActivityNode const& p_node,
+        NodeIndex p_node,
         std::string const& p_label,
         unsigned int p_depth,
         PrintNode const& p_print_node
@@ -76,8 +109,14 @@ public:
 
 // member variables
 private:
-    ActivityNode m_root;
-    std::map<ActivityNode, ActivityData> m_map;
+
+    // The distinct components of the activities, each held once, and
+    // referred to by its position.
+    std::vector<std::string> m_components;
+
+    // The nodes of the tree, in depth-first order, beginning with the
+    // root.
+    std::vector<Node> m_nodes;
 
 };  // class ActivityTree
 
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_activity_trie_hpp_4076567300872870
+#define GUARD_activity_trie_hpp_4076567300872870
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace swx
+{
+
+/**
+ * Maps activity names to numeric ids, organised as a tree of the
+ * single-space-separated components of the activities (as per ActivityNode),
+ * so that an activity and all its subactivities can be found together
+ * without examining every activity.
+ */
+class ActivityTrie
+{
+// nested types
+public:
+    using ActivityId = std::uint32_t;
+
+private:
+    using NodeIndex = std::vector<ActivityId>::size_type;
+
+    struct Node
+    {
+        std::unordered_map<std::string, NodeIndex> children;
+        ActivityId activity_id = 0;
+        bool has_activity = false;
+    };
+
+// special member functions
+public:
+    ActivityTrie();
+    ActivityTrie(ActivityTrie const& rhs) = delete;
+    ActivityTrie(ActivityTrie&& rhs) = delete;
+    ActivityTrie& operator=(ActivityTrie const& rhs) = delete;
+    ActivityTrie& operator=(ActivityTrie&& rhs) = delete;
+    ~ActivityTrie();
+
+// ordinary member functions
+public:
+    /**
+     * Records \e p_activity as having the id \e p_activity_id, replacing any
+     * id previously recorded for it.
+     */
+    void insert(std::string const& p_activity, ActivityId p_activity_id);
+
+    /**
+     * Forgets the id of \e p_activity, if any.
+     */
+    void erase(std::string const& p_activity);
+
+    void clear();
+
+    /**
+     * Appends to \e p_activity_ids the ids of \e p_activity and of each of
+     * its subactivities; that is, of each recorded activity that either is
+     * identical to \e p_activity or begins with \e p_activity followed by a
+     * space. The ids are appended in no particular order.
+     */
+    void find_subactivities
+    (   std::string const& p_activity,
+        std::vector<ActivityId>& p_activity_ids
+    ) const;
+
+private:
+    /**
+     * If there is a node for \e p_activity, sets \e p_node to its index and
+     * returns \e true; otherwise returns \e false. Does not create any nodes.
+     */
+    bool find_node(std::string const& p_activity, NodeIndex& p_node) const;
+
+// member variables
+private:
+    std::vector<Node> m_nodes;  // the first is the root, for the empty activity
+
+};  // class ActivityTrie
+
+}  // namespace swx
+
+#endif  // GUARD_activity_trie_hpp_4076567300872870
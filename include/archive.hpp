@@ -0,0 +1,92 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_archive_hpp_6419285730148826
+#define GUARD_archive_hpp_6419285730148826
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace swx
+{
+
+/**
+ * The entries of a part of the time log, in the form in which they are held
+ * in an archive.
+ *
+ * An archive is a compact binary encoding of these entries, used for closed
+ * segments of the log, which would otherwise be parsed from text every time
+ * they were loaded. It begins with a tag identifying it as an archive, and a
+ * byte recording whether the remainder has been compressed. The remainder
+ * consists of the activity names (each preceded by its length), then the
+ * number of entries, then for each entry the number of seconds since the
+ * previous entry (or since the epoch, for the first) and the position of its
+ * activity among the names. All numbers are variable-length, with seven bits
+ * to a byte, least significant first, so that the encoding does not depend
+ * on the platform.
+ */
+struct ArchivedEntries
+{
+    /// The names of the activities, each occurring once.
+    std::vector<std::string> activities;
+
+    /// The time of each entry, in seconds since the epoch, in ascending order.
+    std::vector<std::int64_t> seconds;
+
+    /// For each entry, the position of its activity in \e activities.
+    std::vector<std::uint32_t> activity_numbers;
+};
+
+/**
+ * @returns true if and only if the bytes in [\e p_begin, \e p_end) begin with
+ * the tag that identifies an archive.
+ */
+bool is_archive(char const* p_begin, char const* p_end);
+
+/**
+ * @returns true if and only if the bytes in [\e p_begin, \e p_end) are an
+ * archive whose contents have been compressed.
+ */
+bool is_compressed_archive(char const* p_begin, char const* p_end);
+
+/**
+ * @returns true if and only if this build of the application is able to
+ * compress and decompress archives.
+ */
+bool archive_compression_is_available();
+
+/**
+ * @returns an archive of \e p_entries, with its contents compressed if
+ * \e p_compress is true.
+ *
+ * @exception std::runtime_error if \e p_compress is true but compression is
+ * not available.
+ */
+std::string encode_archive(ArchivedEntries const& p_entries, bool p_compress);
+
+/**
+ * Populate \e p_entries from the archive in [\e p_begin, \e p_end), replacing
+ * their previous contents.
+ *
+ * @exception std::runtime_error if the bytes are not a valid archive, or if
+ * the archive is compressed but compression is not available.
+ */
+void decode_archive(char const* p_begin, char const* p_end, ArchivedEntries& p_entries);
+
+}  // namespace swx
+
+#endif  // GUARD_archive_hpp_6419285730148826
@@ -66,6 +66,8 @@ public:
     unsigned int formatted_buf_len() const;
     std::string editor() const;
     std::string path_to_log() const;
+    bool use_log_index() const;
+    std::string log_segments() const;
 
     /**
      * @returns a printable summary of configuration settings.
@@ -20,7 +20,6 @@
 #include "list_report_writer.hpp"
 #include "stint.hpp"
 #include <ostream>
-#include <vector>
 
 namespace swx
 {
@@ -29,10 +28,7 @@ class CsvListReportWriter: public ListReportWriter
 {
 // special member functions
 public:
-    CsvListReportWriter
-    (   std::vector<Stint> const& p_stints,
-        Options const& p_options
-    );
+    explicit CsvListReportWriter(Options const& p_options);
     CsvListReportWriter(CsvListReportWriter const& rhs) = delete;
     CsvListReportWriter(CsvListReportWriter&& rhs) = delete;
     CsvListReportWriter& operator=(CsvListReportWriter const& rhs) = delete;
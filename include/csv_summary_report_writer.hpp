@@ -18,12 +18,12 @@
 #define GUARD_csv_summary_report_writer_hpp_5020698078452003
 
 #include "activity_stats.hpp"
+#include "csv_row.hpp"
 #include "summary_report_writer.hpp"
 #include "stint.hpp"
 #include <map>
 #include <ostream>
 #include <string>
-#include <vector>
 
 namespace swx
 {
@@ -33,8 +33,7 @@ class CsvSummaryReportWriter: public SummaryReportWriter
 // special member functions
 public:
     CsvSummaryReportWriter
-    (   std::vector<Stint> const& p_stints,
-        Options const& p_options,
+    (   Options const& p_options,
         Flags::Type p_flags
     );
     CsvSummaryReportWriter(CsvSummaryReportWriter const& rhs) = delete;
@@ -50,6 +49,15 @@ private:
         std::map<std::string, ActivityStats> const& p_activity_stats_map
     ) override;
 
+    virtual void do_write_total
+    (   std::ostream& p_os,
+        ActivityStats const& p_total
+    ) override;
+
+// ordinary member functions
+private:
+    void add_time_info(CsvRow& p_row, ActivityStats const& p_info) const;
+
 };  // class CsvSummaryReportWriter
 
 }  // namespace swx
@@ -0,0 +1,181 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_entries_hpp_1280674708365676
+#define GUARD_entries_hpp_1280674708365676
+
+#include "activity_trie.hpp"
+#include "time_point.hpp"
+#include <cassert>
+#include <vector>
+
+namespace swx
+{
+
+/**
+ * The entries in the in-memory cache of the time log, each corresponding to
+ * a line in the log, and each consisting of a time (in seconds since the
+ * epoch) and the id of an activity. Rather than as a sequence of structs,
+ * the entries are stored as parallel columns of times and activities, so that
+ * a scan of one column does not drag the other through the cache.
+ *
+ * The entries are kept in ascending order of time by the caller; that is
+ * assumed, but not enforced, here.
+ */
+class Entries
+{
+// nested types
+public:
+    using ActivityId = ActivityTrie::ActivityId;
+    using Index = std::vector<EpochSeconds>::size_type;
+
+    /// The indices of the entries with a given activity, in ascending order.
+    using PostingList = std::vector<Index>;
+
+// special member functions
+public:
+    Entries() = default;
+    Entries(Entries const& rhs) = delete;
+    Entries(Entries&& rhs) = delete;
+    Entries& operator=(Entries const& rhs) = delete;
+    Entries& operator=(Entries&& rhs) = delete;
+    ~Entries() = default;
+
+// ordinary member functions
+public:
+    Index size() const;
+    bool empty() const;
+    EpochSeconds seconds(Index p_index) const;
+    TimePoint time_point(Index p_index) const;
+    ActivityId activity_id(Index p_index) const;
+    void push_back(ActivityId p_activity_id, EpochSeconds p_seconds);
+    void pop_back();
+    void truncate(Index p_size);
+    void set(Index p_index, ActivityId p_activity_id, EpochSeconds p_seconds);
+    void reserve(Index p_num);
+    void clear();
+
+    /**
+     * Exchanges the entries with those of \e p_other. Afterwards, neither
+     * has any entries counted as unmodified.
+     */
+    void swap(Entries& p_other);
+
+    /**
+     * Appends the entries of \e p_other from index \e p_begin onwards.
+     */
+    void append(Entries const& p_other, Index p_begin);
+
+    /**
+     * @returns the index of the first entry that is not earlier than
+     * \e p_seconds, or size() if there is no such entry.
+     */
+    Index lower_bound(EpochSeconds p_seconds) const;
+
+    /**
+     * @returns the index of the first entry that is later than \e p_seconds,
+     * or size() if there is no such entry.
+     */
+    Index upper_bound(EpochSeconds p_seconds) const;
+
+    /**
+     * @returns the PostingList for \e p_activity_id. The posting lists are
+     * built for all activities on first use, and discarded whenever the
+     * entries change.
+     */
+    PostingList const& postings(ActivityId p_activity_id);
+
+    /**
+     * @returns the total duration, in seconds, of the stints begun by the
+     * entries with \e p_activity_id that lie in the range [\e p_begin,
+     * \e p_end). This must not include the last entry, the stint of which is
+     * still open.
+     */
+    EpochSeconds activity_seconds
+    (   ActivityId p_activity_id,
+        Index p_begin,
+        Index p_end
+    );
+
+    /**
+     * @returns the number of leading entries that have been neither changed
+     * nor removed since \e mark_unmodified was last called. Entries appended
+     * since then are not counted.
+     */
+    Index num_unmodified() const;
+
+    void mark_unmodified();
+
+private:
+    void discard_postings();
+
+// member variables
+private:
+    std::vector<EpochSeconds> m_seconds;
+    std::vector<ActivityId> m_activity_ids;
+    std::vector<PostingList> m_postings;
+
+    // For each activity, either empty, or a running total of the durations
+    // of the stints in its posting list, starting from zero. These are built
+    // as needed, and discarded along with the postings.
+    std::vector<std::vector<EpochSeconds>> m_cumulative_seconds;
+    bool m_postings_valid = false;
+    Index m_num_unmodified = 0;
+
+};  // class Entries
+
+
+// INLINE MEMBER FUNCTION IMPLEMENTATIONS
+
+inline
+Entries::Index
+Entries::size() const
+{
+    assert (m_seconds.size() == m_activity_ids.size());
+    return m_seconds.size();
+}
+
+inline
+bool
+Entries::empty() const
+{
+    return m_seconds.empty();
+}
+
+inline
+EpochSeconds
+Entries::seconds(Index p_index) const
+{
+    return m_seconds[p_index];
+}
+
+inline
+TimePoint
+Entries::time_point(Index p_index) const
+{
+    return seconds_to_time_point(m_seconds[p_index]);
+}
+
+inline
+Entries::ActivityId
+Entries::activity_id(Index p_index) const
+{
+    return m_activity_ids[p_index];
+}
+
+}  // namespace swx
+
+#endif  // GUARD_entries_hpp_1280674708365676
@@ -27,6 +27,44 @@ namespace swx
  */
 bool file_exists_at(std::string const& p_filepath);
 
+/**
+ * Identifies a particular version of a file, by way of properties that will
+ * change if the file is modified, replaced or removed. Two signatures taken of
+ * the same path compare equal only if the file was (in all likelihood) left
+ * untouched in the meantime.
+ */
+struct FileSignature
+{
+    FileSignature();
+    bool exists;
+    unsigned long long device;
+    unsigned long long inode;
+    unsigned long long size;
+    long long modification_seconds;
+    long long modification_nanoseconds;
+};
+
+bool operator==(FileSignature const& lhs, FileSignature const& rhs);
+
+bool operator!=(FileSignature const& lhs, FileSignature const& rhs);
+
+/**
+ * @returns the current FileSignature of the file at \e p_filepath. If there
+ * is no file there, the returned signature will have \e exists set to \e false.
+ *
+ * @exception std::runtime_error if the file exists but cannot be examined.
+ */
+FileSignature file_signature(std::string const& p_filepath);
+
+/**
+ * Flushes the directory containing \e p_filepath through to the storage
+ * device, so that the creation or removal of a file at \e p_filepath is
+ * durable.
+ *
+ * @exception std::runtime_error if the changes cannot be flushed.
+ */
+void sync_directory_of(std::string const& p_filepath);
+
 }  // namespace swx
 
 #endif  // GUARD_file_utilties_hpp_21582711730889376
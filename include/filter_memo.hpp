@@ -0,0 +1,84 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_filter_memo_hpp_6115254403992632
+#define GUARD_filter_memo_hpp_6115254403992632
+
+#include "activity_filter_fwd.hpp"
+#include "activity_registry.hpp"
+#include "activity_trie.hpp"
+#include <vector>
+
+namespace swx
+{
+
+/**
+ * Remembers, for each activity in an ActivityTable, whether it is matched by
+ * a given ActivityFilter, so that during a scan of the entries of a time log
+ * the filter is applied only once per distinct activity, rather than once per
+ * entry. Must not outlive a change to the activity table.
+ */
+class FilterMemo
+{
+// nested types
+public:
+    using ActivityId = ActivityTrie::ActivityId;
+
+private:
+    enum class Result: unsigned char { unknown, no, yes };
+
+// special member functions
+public:
+
+    /**
+     * @param p_activity_table the activities to be matched, by ActivityId.
+     * @param p_activity_trie holds the activities in use in
+     *   \e p_activity_table, by their ActivityIds.
+     * @param p_activity_filter the filter to be applied.
+     */
+    FilterMemo
+    (   ActivityTable const& p_activity_table,
+        ActivityTrie const& p_activity_trie,
+        ActivityFilter const& p_activity_filter
+    );
+
+    FilterMemo(FilterMemo const& rhs) = delete;
+    FilterMemo(FilterMemo&& rhs) = delete;
+    FilterMemo& operator=(FilterMemo const& rhs) = delete;
+    FilterMemo& operator=(FilterMemo&& rhs) = delete;
+    ~FilterMemo() = default;
+
+// ordinary member functions
+public:
+    bool matches(ActivityId p_activity_id);
+
+    /**
+     * @returns the ids of all activities in use that match the filter.
+     */
+    std::vector<ActivityId> matching_activity_ids();
+
+// member variables
+private:
+    ActivityTable const& m_activity_table;
+    ActivityTrie const& m_activity_trie;
+    ActivityFilter const& m_activity_filter;
+    std::vector<Result> m_results;
+
+};  // class FilterMemo
+
+}  // namespace swx
+
+#endif  // GUARD_filter_memo_hpp_6115254403992632
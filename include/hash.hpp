@@ -0,0 +1,39 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_hash_hpp_3866102943851727
+#define GUARD_hash_hpp_3866102943851727
+
+namespace swx
+{
+
+/**
+ * @returns a 64-bit FNV-1a hash of the bytes in the range [\e p_begin, \e p_end),
+ * continuing from \e p_seed if provided (so that a hash can be accumulated over
+ * several ranges).
+ *
+ * This is intended for detecting accidental corruption or modification of
+ * data, and is not suitable for cryptographic purposes.
+ */
+unsigned long long hash_bytes
+(   char const* p_begin,
+    char const* p_end,
+    unsigned long long p_seed = 14695981039346656037ULL
+);
+
+}  // namespace swx
+
+#endif  // GUARD_hash_hpp_3866102943851727
@@ -21,7 +21,6 @@
 #include "stint_fwd.hpp"
 #include <ostream>
 #include <string>
-#include <vector>
 
 namespace swx
 {
@@ -30,10 +29,7 @@ class HumanListReportWriter: public ListReportWriter
 {
 // special member functions
 public:
-    HumanListReportWriter
-    (   std::vector<Stint> const& p_stints,
-        Options const& p_options
-    );
+    explicit HumanListReportWriter(Options const& p_options);
     HumanListReportWriter(HumanListReportWriter const& rhs) = delete;
     HumanListReportWriter(HumanListReportWriter&& rhs) = delete;
     HumanListReportWriter& operator=(HumanListReportWriter const& rhs) = delete;
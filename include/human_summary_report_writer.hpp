@@ -24,7 +24,6 @@
 #include <map>
 #include <ostream>
 #include <string>
-#include <vector>
 
 namespace swx
 {
@@ -34,8 +33,7 @@ class HumanSummaryReportWriter: public SummaryReportWriter
 // special member functions
 public:
     HumanSummaryReportWriter
-    (   std::vector<Stint> const& p_stints,
-        Options const& p_options,
+    (   Options const& p_options,
         Flags::Type p_flags
     );
     HumanSummaryReportWriter(HumanSummaryReportWriter const& rhs) = delete;
@@ -51,6 +49,11 @@ private:
         std::map<std::string, ActivityStats> const& p_activity_stats_map
     ) override;
 
+    virtual void do_write_total
+    (   std::ostream& p_os,
+        ActivityStats const& p_total
+    ) override;
+
 // ordinary member functions
 private:
     void print_label_and_rounded_hours
@@ -62,11 +65,6 @@ private:
         unsigned int p_left_col_width = 0
     ) const;
 
-    void write_succinct_summary
-    (   std::ostream& p_os,
-        std::map<std::string, ActivityStats> const& p_activity_stats_map
-    );
-
     void write_flat_summary
     (   std::ostream& p_os,
         std::map<std::string, ActivityStats> const& p_activity_stats_map
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_index_reader_hpp_1329827368945003
+#define GUARD_index_reader_hpp_1329827368945003
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace swx
+{
+
+/**
+ * The log index and the segment manifest each consist of unsigned 64-bit
+ * fields, interspersed with strings (each preceded by its length) and other
+ * fixed-size values. Values are stored in native byte order, as neither file
+ * is meant to be moved between machines.
+ */
+using IndexField = unsigned long long;
+
+/**
+ * Appends the bytes of \e p_value to \e p_buffer, in native byte order.
+ */
+template <typename Value>
+void append_value(std::string& p_buffer, Value p_value);
+
+/**
+ * Reads values successively from a range of bytes, as written by
+ * append_value, returning false once the range has been exhausted.
+ */
+class IndexReader
+{
+// special member functions
+public:
+    IndexReader(char const* p_begin, char const* p_end);
+    IndexReader(IndexReader const& rhs) = delete;
+    IndexReader(IndexReader&& rhs) = delete;
+    IndexReader& operator=(IndexReader const& rhs) = delete;
+    IndexReader& operator=(IndexReader&& rhs) = delete;
+    ~IndexReader() = default;
+
+// ordinary member functions
+public:
+    template <typename Value>
+    bool read(Value& p_value);
+
+    /**
+     * Reads a string of \e p_size bytes into \e p_value.
+     */
+    bool read(std::string& p_value, IndexField p_size);
+
+    bool skip(IndexField p_size);
+    bool exhausted() const;
+    char const* position() const;
+
+// member variables
+private:
+    char const* m_position;
+    char const* const m_end;
+
+};  // class IndexReader
+
+
+// FUNCTION AND MEMBER FUNCTION IMPLEMENTATIONS
+
+template <typename Value>
+void
+append_value(std::string& p_buffer, Value p_value)
+{
+    p_buffer.append(reinterpret_cast<char const*>(&p_value), sizeof(p_value));
+}
+
+inline
+IndexReader::IndexReader(char const* p_begin, char const* p_end):
+    m_position(p_begin),
+    m_end(p_end)
+{
+}
+
+template <typename Value>
+bool
+IndexReader::read(Value& p_value)
+{
+    if (static_cast<std::size_t>(m_end - m_position) < sizeof(p_value))
+    {
+        return false;
+    }
+    std::memcpy(&p_value, m_position, sizeof(p_value));
+    m_position += sizeof(p_value);
+    return true;
+}
+
+inline
+bool
+IndexReader::read(std::string& p_value, IndexField p_size)
+{
+    if (static_cast<IndexField>(m_end - m_position) < p_size)
+    {
+        return false;
+    }
+    p_value.assign(m_position, m_position + p_size);
+    m_position += p_size;
+    return true;
+}
+
+inline
+bool
+IndexReader::skip(IndexField p_size)
+{
+    if (static_cast<IndexField>(m_end - m_position) < p_size)
+    {
+        return false;
+    }
+    m_position += p_size;
+    return true;
+}
+
+inline
+bool
+IndexReader::exhausted() const
+{
+    return m_position == m_end;
+}
+
+inline
+char const*
+IndexReader::position() const
+{
+    return m_position;
+}
+
+}  // namespace swx
+
+#endif  // GUARD_index_reader_hpp_1329827368945003
@@ -19,7 +19,6 @@
 
 #include "report_writer.hpp"
 #include "stint.hpp"
-#include <vector>
 
 namespace swx
 {
@@ -28,10 +27,7 @@ class ListReportWriter: public ReportWriter
 {
 // special member functions
 public:
-    ListReportWriter
-    (   std::vector<Stint> const& p_stints,
-        Options const& p_options
-    );
+    explicit ListReportWriter(Options const& p_options);
     ListReportWriter(ListReportWriter const& rhs) = delete;
     ListReportWriter(ListReportWriter&& rhs) = delete;
     ListReportWriter& operator=(ListReportWriter const& rhs) = delete;
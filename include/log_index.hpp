@@ -0,0 +1,144 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_log_index_hpp_1773985693167235
+#define GUARD_log_index_hpp_1773985693167235
+
+#include "activity_registry.hpp"
+#include "entries.hpp"
+#include "file_utilities.hpp"
+#include "index_reader.hpp"
+#include "rollup.hpp"
+#include <string>
+#include <vector>
+
+namespace swx
+{
+
+/**
+ * The header of the index of a time log, which records the state of the files
+ * from which the index was derived, so that the index can be checked to be
+ * current before the rest of it is read.
+ *
+ * The index is a cache of the parsed entries of the log (including those of
+ * its closed segments), to be rebuilt whenever it cannot be read or is out of
+ * date. Following the header are the activity names in use, then the entries,
+ * with their activities numbered by position among the names, then the rollup,
+ * in a section of its own, which may be discarded and rebuilt from the entries
+ * without invalidating the rest of the index.
+ */
+struct LogIndexHeader
+{
+    /// Signature of the log file.
+    FileSignature file_signature;
+
+    /// Hash of the tail of the log file.
+    unsigned long long file_tail_hash = 0;
+
+    /// Hash of the settings that determine how the log file is parsed.
+    unsigned long long settings_hash = 0;
+
+    /// Byte offset of the line in the log file of the last entry.
+    unsigned long long last_saved_entry_offset = 0;
+
+    bool file_ends_with_newline = true;
+
+    /// Hash of the segment manifest, or 0 if there is none.
+    unsigned long long manifest_hash = 0;
+
+    /// For each closed segment, the index of the entry just past its last.
+    std::vector<Entries::Index> segment_ends;
+};
+
+/**
+ * Reads an index in two stages: first the header, and then, if the header
+ * shows the index to be current, the rest.
+ */
+class LogIndexReader
+{
+// special member functions
+public:
+    LogIndexReader(char const* p_begin, char const* p_end);
+    LogIndexReader(LogIndexReader const& rhs) = delete;
+    LogIndexReader(LogIndexReader&& rhs) = delete;
+    LogIndexReader& operator=(LogIndexReader const& rhs) = delete;
+    LogIndexReader& operator=(LogIndexReader&& rhs) = delete;
+    ~LogIndexReader() = default;
+
+// ordinary member functions
+public:
+
+    /**
+     * Populates \e p_header from the header of the index.
+     *
+     * @returns false if the bytes do not begin with a well-formed header.
+     */
+    bool read_header(LogIndexHeader& p_header);
+
+    /**
+     * Reads the rest of the index, once the header has been read. The
+     * activity names are appended to \e p_activities, which must be empty,
+     * and the entries to \e p_entries, which must be empty, with the
+     * ActivityId of each being the position of its activity in \e
+     * p_activities. If the rollup section is well-formed, it is read into \e
+     * p_rollup, which must be empty, with the same numbering of activities;
+     * otherwise \e p_rollup is left empty, to be rebuilt from the entries.
+     *
+     * @returns false if the index is not well-formed, other than in its rollup
+     * section; in which case the contents of the parameters are unspecified.
+     * Not every failure of form is detected here: the caller must also check
+     * that the activity names are distinct, and that each is in use by an
+     * entry.
+     */
+    bool read_body
+    (   std::vector<std::string>& p_activities,
+        Entries& p_entries,
+        std::vector<RollupDay>& p_rollup
+    );
+
+private:
+    bool read_rollup_section
+    (   char const* p_begin,
+        char const* p_end,
+        Entries const& p_entries,
+        std::vector<RollupDay>& p_rollup
+    ) const;
+
+// member variables
+private:
+    IndexReader m_reader;
+    IndexField const m_size;
+    IndexField m_num_activities = 0;
+    IndexField m_num_entries = 0;
+
+};  // class LogIndexReader
+
+/**
+ * @returns an index with the given header, and holding \e p_entries, with
+ * their activities in \e p_activity_table, and \e p_rollup. Elements of the
+ * activity table that are not in use are omitted, and the others renumbered
+ * accordingly.
+ */
+std::string encode_log_index
+(   LogIndexHeader const& p_header,
+    ActivityTable const& p_activity_table,
+    Entries const& p_entries,
+    std::vector<RollupDay> const& p_rollup
+);
+
+}  // namespace swx
+
+#endif  // GUARD_log_index_hpp_1773985693167235
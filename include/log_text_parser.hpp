@@ -0,0 +1,166 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_log_text_parser_hpp_1348330212965495
+#define GUARD_log_text_parser_hpp_1348330212965495
+
+#include "archive.hpp"
+#include "mapped_file.hpp"
+#include "time_point.hpp"
+#include "time_stamp_parser.hpp"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace swx
+{
+
+/**
+ * The entries parsed from the lines of a time log in [begin, end) by
+ * LogTextParser::parse_chunks, with the activities numbered in order of first
+ * appearance in the chunk, and consecutive entries with the same activity
+ * already combined. If any line cannot be parsed, or is out of order, then
+ * \e failed is set, and the chunk must be parsed again in sequence for the
+ * error to be reported.
+ */
+struct ParsedChunk
+{
+    char const* begin;
+    char const* end;
+    long long initial_previous_offset;  // with which the parser begins
+    long long final_previous_offset;  // with which the parser finishes
+    ArchivedEntries entries;
+    unsigned long long last_entry_offset;  // of the line of the last entry
+    bool failed;
+};
+
+/**
+ * Parses the lines of a time log, each consisting of a time stamp of fixed
+ * length, followed by the name of an activity, possibly surrounded by
+ * whitespace.
+ */
+class LogTextParser
+{
+// static member functions
+public:
+
+    /**
+     * @returns the number of chunks into which parse_chunks should divide
+     * \e p_size bytes of the log, so that each chunk is at least 1 MiB, and
+     * there are no more chunks than processors. If this is less than 2, the
+     * lines are best parsed in sequence.
+     */
+    static unsigned long long num_chunks(unsigned long long p_size);
+
+    /**
+     * Makes num_chunks assume \e p_num_processors processors, and a minimum
+     * chunk size of \e p_min_chunk_size, so that parsing in chunks can be
+     * exercised on small logs and on any machine. If \e p_num_processors is
+     * 0, the defaults are restored.
+     */
+    static void set_chunking
+    (   unsigned int p_num_processors,
+        unsigned long long p_min_chunk_size
+    );
+
+// special member functions
+public:
+
+    /**
+     * @param p_time_format the format of the time stamps.
+     * @param p_time_stamp_length the length of each time stamp.
+     */
+    LogTextParser(std::string const& p_time_format, unsigned int p_time_stamp_length);
+
+    LogTextParser(LogTextParser const& rhs) = delete;
+    LogTextParser(LogTextParser&& rhs) = delete;
+    LogTextParser& operator=(LogTextParser const& rhs) = delete;
+    LogTextParser& operator=(LogTextParser&& rhs) = delete;
+    ~LogTextParser() = default;
+
+// ordinary member functions
+public:
+
+    /**
+     * Parses a line of the log as mapped in \e p_file, running from \e p_begin
+     * up to (but not including) \e p_end, and not including the newline,
+     * using \e p_parser for the time stamp. The activity name is assigned to
+     * \e p_activity (so that the caller can reuse the same buffer from line
+     * to line).
+     *
+     * @returns the TimePoint of the time stamp.
+     *
+     * @exception std::runtime_error if the line cannot be parsed.
+     */
+    TimePoint parse_line
+    (   TimeStampParser& p_parser,
+        MappedFile const& p_file,
+        char const* p_begin,
+        char const* p_end,
+        std::string& p_activity
+    ) const;
+
+    /**
+     * Divides the lines of the log as mapped in \e p_file, in [\e p_begin,
+     * \e p_end), into \e p_num_chunks chunks of roughly equal size, and
+     * parses them concurrently, as far as threads can be created for them.
+     * The parser of each chunk begins with \e p_previous_offset, as is correct
+     * for the first chunk, and nearly always harmless for the others; so each
+     * chunk after the first must be checked with \e parses_alike before its
+     * entries are used.
+     *
+     * @returns the chunks, in order.
+     */
+    std::vector<ParsedChunk> parse_chunks
+    (   MappedFile const& p_file,
+        char const* p_begin,
+        char const* p_end,
+        unsigned long long p_num_chunks,
+        long long p_previous_offset
+    ) const;
+
+    /**
+     * @returns true if and only if the time stamps of the lines in [\e
+     * p_begin, \e p_end) are parsed the same by a TimeStampParser beginning
+     * with either of the given previous offsets.
+     */
+    bool parses_alike
+    (   char const* p_begin,
+        char const* p_end,
+        long long p_previous_offset,
+        long long p_other_previous_offset
+    ) const;
+
+private:
+    void parse_chunk(MappedFile const& p_file, ParsedChunk& p_chunk) const;
+
+// member variables
+private:
+    std::string const m_time_format;
+    unsigned int const m_time_stamp_length;
+
+};  // class LogTextParser
+
+/**
+ * @returns the number of the line in \e p_file on which \e p_position lies.
+ * This is calculated by counting lines, so is best left until it is needed
+ * for an error message.
+ */
+std::size_t line_number_at(MappedFile const& p_file, char const* p_position);
+
+}  // namespace swx
+
+#endif  // GUARD_log_text_parser_hpp_1348330212965495
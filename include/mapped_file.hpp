@@ -0,0 +1,70 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_mapped_file_hpp_7420936185573302
+#define GUARD_mapped_file_hpp_7420936185573302
+
+#include <cstddef>
+#include <string>
+
+namespace swx
+{
+
+/**
+ * Provides read-only access to the contents of a file by mapping it into
+ * memory for the lifetime of the MappedFile. The contents must not be
+ * accessed after the MappedFile has been destroyed.
+ */
+class MappedFile
+{
+// special member functions
+public:
+    /**
+     * @exception std::runtime_error if the file cannot be opened or mapped.
+     */
+    explicit MappedFile(std::string const& p_filepath);
+    MappedFile(MappedFile const& rhs) = delete;
+    MappedFile(MappedFile&& rhs) = delete;
+    MappedFile& operator=(MappedFile const& rhs) = delete;
+    MappedFile& operator=(MappedFile&& rhs) = delete;
+    ~MappedFile();
+
+// ordinary member functions
+public:
+
+    /**
+     * @returns a pointer to the first byte of the file, or a null pointer if
+     * the file is empty.
+     */
+    char const* begin() const;
+
+    /**
+     * @returns a pointer to one past the last byte of the file.
+     */
+    char const* end() const;
+
+    std::size_t size() const;
+
+// member variables
+private:
+    void* m_address;
+    std::size_t m_size;
+
+};  // class MappedFile
+
+}  // namespace swx
+
+#endif  // GUARD_mapped_file_hpp_7420936185573302
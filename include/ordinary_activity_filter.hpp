@@ -51,6 +51,8 @@ private:
         std::string const& p_substitution
     ) const override;
 
+    virtual std::string const* do_get_subactivity_root() const override;
+
 // data members
 private:
     std::string const m_comparitor;
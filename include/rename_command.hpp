@@ -53,9 +53,14 @@ private:
 
     virtual bool does_support_placeholders() const override;
 
+// ordinary member functions
+private:
+    ErrorMessages rename_from_file(std::ostream& p_ordinary_ostream);
+
 // member variables
 private:
     ActivityFilter::Type m_activity_filter_type = ActivityFilter::Type::ordinary;
+    std::string m_renamings_filepath;
 
 };  // class RenameCommand
 
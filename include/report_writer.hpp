@@ -19,9 +19,11 @@
 
 #include "interval_fwd.hpp"
 #include "stint.hpp"
+#include "time_point.hpp"
+#include "time_stamp_formatter.hpp"
+#include <functional>
 #include <ostream>
 #include <string>
-#include <vector>
 
 namespace swx
 {
@@ -76,23 +78,28 @@ public:
         static Type constexpr show_stints       = (1 << 5);
     };
 
+    /**
+     * A StintSource is called with a visitor, which it must call once for
+     * each Stint to be reported, in ascending date order. This allows the
+     * Stints to be generated on the fly rather than collected up front.
+     */
+    using StintSource =
+        std::function<void(std::function<void(Stint const&)> const&)>;
+
 // static factory function
 public:
     /**
+     * Creates a ReportWriter that lists each Stint it is fed. \e p_flags must
+     * include Flags::show_stints; summaries are written by a
+     * SummaryReportWriter instead.
+     *
      * Caller receives ownership of the pointer.
      */
-    static ReportWriter* create
-    (   std::vector<Stint> const& p_stints,
-        Options const& p_options,
-        Flags::Type p_flags
-    );
+    static ReportWriter* create(Options const& p_options, Flags::Type p_flags);
 
 // special member functions
 public:
-    ReportWriter
-    (   std::vector<Stint> const& p_stints,
-        Options const& p_options
-    );
+    explicit ReportWriter(Options const& p_options);
     ReportWriter(ReportWriter const& rhs) = delete;
     ReportWriter(ReportWriter&& rhs) = delete;
     ReportWriter& operator=(ReportWriter const& rhs) = delete;
@@ -101,7 +108,7 @@ public:
 
 // ordinary member functions
 public:
-    void write(std::ostream& p_os);
+    void write(std::ostream& p_os, StintSource const& p_stint_source);
 
 protected:
 
@@ -126,25 +133,28 @@ protected:
      */
     double round_hours(Interval const& p_interval) const;
 
+    /**
+     * @returns \e p_time_point formatted as a timestamp according to the
+     * options passed to the constructor. The returned reference remains valid
+     * only until the next call to this function.
+     */
+    std::string const& time_stamp(TimePoint const& p_time_point) const;
+
 
 // virtual member functions
 private:
-    virtual void do_preprocess_stints
-    (   std::ostream& p_os,
-        std::vector<Stint> const& p_stints
-    );
-    
+    virtual void do_preprocess_stints(std::ostream& p_os);
+
     virtual void do_process_stint(std::ostream& p_os, Stint const& p_stint) = 0;
 
-    virtual void do_postprocess_stints
-    (   std::ostream& p_os,
-        std::vector<Stint> const& p_stints
-    );
+    virtual void do_postprocess_stints(std::ostream& p_os);
 
 // member variables
 private:
     Options const m_options;
-    std::vector<Stint> const& m_stints;
+
+    // Caches its most recent result, so is mutable.
+    mutable TimeStampFormatter m_time_stamp_formatter;
 
 };  // class ReportWriter
 
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_rollup_hpp_1263739107040323
+#define GUARD_rollup_hpp_1263739107040323
+
+#include "entries.hpp"
+#include "time_point.hpp"
+#include <vector>
+
+namespace swx
+{
+
+/**
+ * The time spent on an activity during one day, as held in the rollup.
+ */
+struct RollupRow
+{
+    Entries::ActivityId activity_id;
+    EpochSeconds seconds;
+    EpochSeconds beginning;
+    EpochSeconds ending;
+};
+
+/**
+ * The time spent on each activity during one local day, from midnight to
+ * midnight. Stints of zero duration at exactly the first midnight are not
+ * counted in the rows, as whether they belong in a summary depends on whether
+ * the summary begins at that midnight or earlier; so it is just recorded
+ * whether there are any.
+ */
+struct RollupDay
+{
+    EpochSeconds begin;
+    EpochSeconds end;
+    bool has_boundary_stints;
+    std::vector<RollupRow> rows;
+};
+
+/**
+ * Brings \e p_rollup up to date with \e p_entries, so that it holds a
+ * RollupDay for each whole local day between the first and last of the
+ * entries, in ascending order of day.
+ *
+ * The days that may have been affected by changes to the entries since they
+ * were last marked unmodified are discarded and rebuilt, and the entries are
+ * then marked unmodified. As \e p_entries may be only a suffix of the log, the
+ * entries before which have yet to be loaded, the first day begins no earlier
+ * than the first entry.
+ */
+void update_rollup(Entries& p_entries, std::vector<RollupDay>& p_rollup);
+
+}  // namespace swx
+
+#endif  // GUARD_rollup_hpp_1263739107040323
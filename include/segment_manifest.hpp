@@ -0,0 +1,122 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_segment_manifest_hpp_1378667682493149
+#define GUARD_segment_manifest_hpp_1378667682493149
+
+#include "entries.hpp"
+#include "time_point.hpp"
+#include <string>
+#include <vector>
+
+namespace swx
+{
+
+/**
+ * Determines the periods by which the time log is divided into segments.
+ */
+enum class Segmentation { none, yearly, monthly };
+
+/**
+ * @returns the Segmentation named by \e p_segments, being "none", "yearly" or
+ * "monthly".
+ *
+ * @exception std::runtime_error if \e p_segments is not one of these.
+ */
+Segmentation parse_segmentation(std::string const& p_segments);
+
+/**
+ * @returns the first TimePoint of the (local) year or month in which
+ * \e p_time_point falls. \e p_segmentation must not be Segmentation::none.
+ */
+TimePoint period_begin(TimePoint const& p_time_point, Segmentation p_segmentation);
+
+/**
+ * @returns the name of the (local) year or month in which \e p_time_point
+ * falls, such as "2023" or "2023-04". \e p_segmentation must not be
+ * Segmentation::none.
+ */
+std::string period_label(TimePoint const& p_time_point, Segmentation p_segmentation);
+
+/**
+ * The form in which the file of a closed segment is written.
+ */
+enum class SegmentEncoding { text, archive, compressed_archive };
+
+/**
+ * A closed segment of the time log, as recorded in the manifest. The entries
+ * in the segments, in order, precede those in the log file itself.
+ */
+struct Segment
+{
+    /// The segment file is at the path of the log file + '.' + label.
+    std::string label;
+    EpochSeconds first_seconds;
+    EpochSeconds last_seconds;
+    Entries::Index num_entries;
+
+    /// The activities of the entries in the segment, in ascending order.
+    std::vector<std::string> activities;
+    SegmentEncoding encoding;
+
+    // These are not recorded in the manifest. Once the segment has been
+    // loaded, end is the index in the entries just past its last entry, and
+    // modified is true if its entries have changed since.
+    Entries::Index end;
+    bool modified;
+};
+
+/**
+ * @returns the manifest recording \e p_segments, and also, if \e p_rotating
+ * is true, that a new log file is staged, to be moved into place.
+ */
+std::string encode_manifest(std::vector<Segment> const& p_segments, bool p_rotating);
+
+/**
+ * Populates \e p_segments, and \e p_rotating, from the manifest in [\e
+ * p_begin, \e p_end), which may be of the current layout, or of the previous
+ * one, which lacks the encoding of each segment (as all segments were then
+ * text). The \e end of each segment is set to 0.
+ *
+ * @returns false if the bytes are not a well-formed manifest, in which case
+ * the contents of \e p_segments are unspecified.
+ */
+bool decode_manifest
+(   char const* p_begin,
+    char const* p_end,
+    std::vector<Segment>& p_segments,
+    bool& p_rotating
+);
+
+/**
+ * Appends to \e p_segments a new segment of text for each \e p_segmentation
+ * period spanned by the entries in [\e p_begin, \e p_end) of \e p_entries,
+ * with its \e end set, but its contents yet to be written. Each is labelled
+ * by its period, made unique among \e p_segments by a numeric suffix if need
+ * be, as an entry may have been moved back into a period that already has a
+ * segment.
+ */
+void append_period_segments
+(   Entries const& p_entries,
+    Entries::Index p_begin,
+    Entries::Index p_end,
+    Segmentation p_segmentation,
+    std::vector<Segment>& p_segments
+);
+
+}  // namespace swx
+
+#endif  // GUARD_segment_manifest_hpp_1378667682493149
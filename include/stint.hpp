@@ -18,6 +18,7 @@
 #define GUARD_stint_hpp_7450393879530204
 
 #include "interval.hpp"
+#include <memory>
 #include <string>
 #include <ostream>
 #include <vector>
@@ -25,8 +26,19 @@
 namespace swx
 {
 
+/**
+ * A handle to the immutable name of an activity, which may be shared
+ * between any number of Stints (and threads).
+ */
+using ActivityName = std::shared_ptr<std::string const>;
+
 /**
  * Represents a period of time spent performing a specific activity.
+ *
+ * A Stint shares ownership of its activity name, rather than referring
+ * to a string held elsewhere; so it remains valid after the TimeLog from
+ * which it was obtained is reloaded or destroyed, and copying it does not
+ * copy the name.
  */
 class Stint
 {
@@ -34,21 +46,24 @@ class Stint
 public:
 
     /**
-     * Note \e p_activity is stored <em>as a reference</em>. The
-     * Stint object does not make its own copy of the string. The
-     * caller should ensure that the string used to initialize the Stint
-     * will persist for as long as the Stint persists.
+     * \e p_activity must not be null.
+     */
+    Stint(ActivityName p_activity, Interval const& p_interval);
+
+    /**
+     * Makes a new ActivityName holding a copy of \e p_activity.
      */
     Stint(std::string const& p_activity, Interval const& p_interval);
 
 // ordinary member functions
 public:
     std::string const& activity() const;
+    ActivityName const& activity_name() const;
     Interval interval() const;
 
 // member variables
 private:
-    std::string const& m_activity;
+    ActivityName m_activity;
     Interval m_interval;
 
 };  // class Stint
@@ -23,18 +23,27 @@
 #include "time_point.hpp"
 #include <map>
 #include <ostream>
-#include <vector>
+#include <string>
 
 namespace swx
 {
 
 class SummaryReportWriter: public ReportWriter
 {
+// static factory function
+public:
+    /**
+     * Caller receives ownership of the pointer.
+     */
+    static SummaryReportWriter* create
+    (   Options const& p_options,
+        Flags::Type p_flags
+    );
+
 // special member functions
 public:
     SummaryReportWriter
-    (   std::vector<Stint> const& p_stints,
-        Options const& p_options,
+    (   Options const& p_options,
         Flags::Type p_flags
     );
     SummaryReportWriter(SummaryReportWriter const& rhs) = delete;
@@ -43,23 +52,34 @@ public:
     SummaryReportWriter& operator=(SummaryReportWriter&& rhs) = delete;
     virtual ~SummaryReportWriter();
 
-// inherited virtual member functions
-private:
-    virtual void do_preprocess_stints
+// ordinary member functions
+public:
+    /**
+     * Writes the summary from \e p_activity_stats_map. The entry for the
+     * empty activity, if any, is ignored.
+     */
+    void write_summary
     (   std::ostream& p_os,
-        std::vector<Stint> const& p_stints
-    ) override;
+        std::map<std::string, ActivityStats> p_activity_stats_map
+    );
 
+    /**
+     * Writes a succinct summary directly from \e p_total, the combined
+     * ActivityStats of all the activities to be reported on. The Flags
+     * passed on construction must include Flags::succinct.
+     */
+    void write_total(std::ostream& p_os, ActivityStats const& p_total);
+
+// inherited virtual member functions
+private:
+    /**
+     * A SummaryReportWriter is not fed Stints, so this is never called.
+     */
     virtual void do_process_stint
     (   std::ostream& p_os,
         Stint const& p_stint
     ) override;
 
-    virtual void do_postprocess_stints
-    (   std::ostream& p_os,
-        std::vector<Stint> const& p_stints
-    ) override;
-
 // other virtual member functions
 private:
     virtual void do_write_summary
@@ -67,6 +87,11 @@ private:
         std::map<std::string, ActivityStats> const& p_activity_stats_map
     ) = 0;
 
+    virtual void do_write_total
+    (   std::ostream& p_os,
+        ActivityStats const& p_total
+    ) = 0;
+
 // ordinary member functions
 protected:
     bool has_flag(Flags::Type p_flag) const;
@@ -74,7 +99,6 @@ protected:
 // member variables
 private:
     Flags::Type const m_flags;
-    std::map<std::string, ActivityStats> m_activity_stats_map;
 
 };  // class SummaryReportWriter
 
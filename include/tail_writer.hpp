@@ -0,0 +1,83 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_tail_writer_hpp_0583314870260194
+#define GUARD_tail_writer_hpp_0583314870260194
+
+#include <string>
+
+namespace swx
+{
+
+/**
+ * Provides a mechanism for replacing the tail of an existing file, from a given
+ * byte offset onwards, without rewriting the part of the file that precedes it.
+ * Text accumulated by calls to \e append is written to the file only when
+ * \e commit is called.
+ *
+ * Crash safety is provided by a write-ahead journal. On commit, the offset and
+ * the new tail are first written durably, together with a checksum, to a journal
+ * file alongside the target file; only then is the target file itself modified,
+ * after which the journal is removed. If the process is interrupted before the
+ * journal has been removed, calling \e recover for the same path will either
+ * complete the interrupted change, or, if the journal itself was not written
+ * in full, discard it, leaving the target file as it was before \e commit.
+ */
+class TailWriter
+{
+// special member functions
+public:
+    /**
+     * @param p_filepath path to an existing file.
+     * @param p_offset offset from which the file content is to be replaced;
+     *   must not exceed the current size of the file.
+     */
+    TailWriter(std::string const& p_filepath, unsigned long long p_offset);
+    TailWriter(TailWriter const& rhs) = delete;
+    TailWriter(TailWriter&& rhs) = delete;
+    TailWriter& operator=(TailWriter const& rhs) = delete;
+    TailWriter& operator=(TailWriter&& rhs) = delete;
+    ~TailWriter();
+
+// ordinary and static member functions
+public:
+    void append(std::string const& p_str);
+
+    /**
+     * @exception std::runtime_error if the change cannot be made.
+     */
+    void commit();
+
+    /**
+     * Completes or discards any change to the file at \e p_filepath that was
+     * interrupted before it could be committed in full. Does nothing if there
+     * is no such change outstanding.
+     *
+     * @exception std::runtime_error if an outstanding change cannot be completed.
+     */
+    static void recover(std::string const& p_filepath);
+
+// member variables
+private:
+    std::string const m_filepath;
+    unsigned long long const m_offset;
+    std::string m_tail;
+
+};  // class TailWriter
+
+}  // namespace swx
+
+#endif  // GUARD_tail_writer_hpp_0583314870260194
@@ -18,10 +18,15 @@
 #define GUARD_time_log_hpp_6591341885082117
 
 #include "activity_filter_fwd.hpp"
+#include "activity_stats.hpp"
 #include "stint_fwd.hpp"
 #include "time_point.hpp"
+#include <cstddef>
+#include <functional>
+#include <map>
 #include <string>
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace swx
@@ -30,19 +35,57 @@ namespace swx
 /**
  * Represents a record of time spent on various activities, persisted to a
  * plain text file.
+ *
+ * Optionally, a binary index of the log is kept in a second file, alongside
+ * the first, from which the log can be loaded without parsing the text. The
+ * text file remains authoritative: the index is used only if it is found to
+ * be up to date with the text file, and is otherwise rebuilt.
+ *
+ * Optionally also, the log may be divided into segments by year or by month.
+ * The entries of each period that has closed are then moved to a segment file
+ * of their own, which is not written again unless an activity in it is
+ * renamed; and only the entries of the current period remain in the main
+ * file, to be appended to. A manifest, kept alongside, records the range of
+ * times and the set of activities in each segment. Segments may be compacted
+ * into a binary archive (see compact()), which is quicker to load than text.
+ * If the entries of a closed period cannot be moved to their segment when a
+ * change is saved, the change is still saved, and the move is completed or
+ * retried later; but the function making the change throws
+ * std::runtime_error.
  */
 class TimeLog
 {
 // nested types
+public:
+    using StintVisitor = std::function<void(Stint const&)>;
+
+    // How compact() is to treat the compression of the segments it rewrites.
+    enum class Compression
+    {
+        unchanged,  // leave compressed segments compressed, and others not
+        compressed,
+        uncompressed
+    };
+
 private:
     class Impl;
 
 // special member functions
 public:
+    /**
+     * @param p_segments "yearly" or "monthly" to have the entries of each
+     *   closed year or month moved to a segment file; or "none" to keep them
+     *   in the file at \e p_filepath. Segments already created continue to
+     *   be read regardless.
+     *
+     * @exception std::runtime_error if \e p_segments is not recognized.
+     */
     TimeLog
     (   std::string const& p_filepath,
         std::string const& p_time_format,
-        unsigned int p_formatted_buf_len
+        unsigned int p_formatted_buf_len,
+        bool p_use_index,
+        std::string const& p_segments = "none"
     );
     TimeLog() = delete;
     TimeLog(TimeLog const& rhs) = delete;
@@ -91,6 +134,34 @@ public:
         std::string const& p_new
     );
 
+    /**
+     * Apply each of \e p_renamings in turn, as if by calling
+     * <em>rename_activity(*p_renamings[i].first, p_renamings[i].second)</em>
+     * for each \e i, but loading and saving the log just once, and calling
+     * <em>replace</em> only once for each distinct activity name at each step.
+     * The changes will be immediately persisted to file.
+     *
+     * @return the number of stints for which a change was made by each
+     *   renaming, in order.
+     */
+    std::vector<std::vector<Stint>::size_type> rename_activities
+    (   std::vector<std::pair<ActivityFilter const*, std::string>> const& p_renamings
+    );
+
+    /**
+     * Rewrite each closed segment of the log (see the constructor) that is
+     * still text as a compact binary archive, which is smaller and much
+     * quicker to load. Segments already archived keep their compression,
+     * unless \e p_compression calls for all archives to be compressed, or
+     * for all to be uncompressed. The log file itself is left as text.
+     * The changes will be immediately persisted to file.
+     *
+     * @return the number of segments rewritten.
+     * @exception std::runtime_error if \e p_compression is
+     *   Compression::compressed but this build does not support compression.
+     */
+    std::size_t compact(Compression p_compression);
+
     /**
      * Provide \e p_activity_filter to filter by activity name.
      * Provide non-null pointers to TimePoints to filter by date range,
@@ -104,6 +175,58 @@ public:
         TimePoint const* p_end
     );
 
+    /**
+     * Calls \e p_visitor for each of the Stints that would be returned by
+     * get_stints, called with the same arguments, in the same order, but
+     * without collecting them in a vector.
+     *
+     * The Stint passed to \e p_visitor shares ownership of its activity name
+     * with the TimeLog, so may be copied and kept for as long as is needed,
+     * even after the TimeLog is destroyed. \e p_visitor must not modify the
+     * TimeLog.
+     */
+    void for_each_stint
+    (   ActivityFilter const& p_activity_filter,
+        TimePoint const* p_begin,
+        TimePoint const* p_end,
+        StintVisitor const& p_visitor
+    );
+
+    /**
+     * @returns a map from the name of each activity satisfying \e
+     * p_activity_filter, to the total ActivityStats of its Stints, as would
+     * be returned by get_stints, called with the same arguments.
+     *
+     * Rather than from the individual Stints, the time spent during each
+     * whole (local) day within the range is taken from a per-day summary of
+     * the entries loaded; only the partial days at either end of the range
+     * are summarised from the entries themselves. The summary is built in
+     * memory when first needed, and is saved only in the binary index, if
+     * that is in use; otherwise it is built afresh each time the log is
+     * loaded.
+     */
+    std::map<std::string, ActivityStats> get_activity_stats
+    (   ActivityFilter const& p_activity_filter,
+        TimePoint const* p_begin,
+        TimePoint const* p_end
+    );
+
+    /**
+     * @returns the combined ActivityStats of all the Stints, other than
+     * those of the empty, "inactive activity", that would be returned by
+     * get_stints, called with the same arguments.
+     *
+     * Only the Stints at either end of the range are visited individually.
+     * The time spent between them is found from running totals kept over the
+     * entries, so that the cost of this is largely independent of the length
+     * of the range.
+     */
+    ActivityStats get_total_stats
+    (   ActivityFilter const& p_activity_filter,
+        TimePoint const* p_begin,
+        TimePoint const* p_end
+    );
+
     /**
      * @return the most recent activity to match \e p_regex, considered as a
      * regular expression; or return the empty string if none match. (Modified
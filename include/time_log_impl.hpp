@@ -0,0 +1,488 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_time_log_impl_hpp_9587417367280807
+#define GUARD_time_log_impl_hpp_9587417367280807
+
+#include "time_log.hpp"
+#include "activity_filter_fwd.hpp"
+#include "activity_registry.hpp"
+#include "activity_stats.hpp"
+#include "activity_trie.hpp"
+#include "archive.hpp"
+#include "entries.hpp"
+#include "file_utilities.hpp"
+#include "filter_memo.hpp"
+#include "interval_fwd.hpp"
+#include "log_text_parser.hpp"
+#include "mapped_file.hpp"
+#include "rollup.hpp"
+#include "segment_manifest.hpp"
+#include "stint_fwd.hpp"
+#include "time_point.hpp"
+#include "time_stamp_formatter.hpp"
+#include "time_stamp_parser.hpp"
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace swx
+{
+
+/**
+ * Provides implementation for TimeLog.
+ *
+ * This is shared only among the translation units that implement TimeLog:
+ * time_log.cpp, and the units that implement suffix loading and segment
+ * rotation.
+ */
+class TimeLog::Impl
+{
+// nested types
+private:
+    class Transaction;
+    friend class Transaction;
+
+    // Identifies an activity by its position in the activity table.
+    using ActivityId = ActivityTrie::ActivityId;
+    using EntryIndex = Entries::Index;
+    using ReferenceCount = EntryIndex;  // number of entries with a given activity
+    using PostingList = Entries::PostingList;
+
+    // Denotes a byte offset in the log file that is not known.
+    static unsigned long long const k_unknown_offset = -1;
+
+// special member functions
+public:
+    Impl
+    (   std::string const& p_filepath,
+        std::string const& p_time_format,
+        unsigned int p_formatted_buf_len,
+        bool p_use_index,
+        std::string const& p_segments
+    );
+    Impl() = delete;
+    Impl(Impl const&) = delete;
+    Impl(Impl&&) = delete;
+    Impl& operator=(Impl const&) = delete;
+    Impl& operator=(Impl&&) = delete;
+    ~Impl();
+
+// ordinary member functions
+public:
+
+    // These implement the corresponding public functions of TimeLog.
+
+    void append_entry(std::string const& p_activity, TimePoint const& p_time_point);
+    std::string amend_last(std::string const& p_activity, TimePoint const& p_time_point);
+    std::vector<Stint>::size_type rename_activity
+    (   ActivityFilter const& p_activity_filter,
+        std::string const& p_new
+    );
+
+    std::vector<std::vector<Stint>::size_type> rename_activities
+    (   std::vector<std::pair<ActivityFilter const*, std::string>> const& p_renamings
+    );
+
+    std::size_t compact(Compression p_compression);
+    std::vector<Stint> get_stints
+    (   ActivityFilter const& p_activity_filter,
+        TimePoint const* p_begin,
+        TimePoint const* p_end
+    );
+    void for_each_stint
+    (   ActivityFilter const& p_activity_filter,
+        TimePoint const* p_begin,
+        TimePoint const* p_end,
+        StintVisitor const& p_visitor
+    );
+    std::map<std::string, ActivityStats> get_activity_stats
+    (   ActivityFilter const& p_activity_filter,
+        TimePoint const* p_begin,
+        TimePoint const* p_end
+    );
+    ActivityStats get_total_stats
+    (   ActivityFilter const& p_activity_filter,
+        TimePoint const* p_begin,
+        TimePoint const* p_end
+    );
+    std::string last_activity_to_match(std::string const& p_regex);
+    std::vector<std::string> last_activities(std::size_t p_num);
+    TimePoint last_entry_time(std::size_t p_ago);
+    bool is_active_at(TimePoint const& p_time_point);
+    bool is_active();
+    bool has_activity(std::string const& p_activity);
+
+private:
+
+    // Implementation details.
+
+    // Overall management of in-memory data structures.
+    void clear_cache();
+    void mark_cache_as_stale();
+    void load();
+    void save();
+
+    // Rather than loading the whole log, these load only as many of the
+    // most recent entries as are needed: load_last ensures that at least the
+    // last p_num entries are in memory (or all entries, if there are fewer);
+    // load_since ensures that the entry current at p_time_point and all
+    // subsequent entries are in memory; and load_suffix loads until
+    // p_is_sufficient returns true. The log file is read backwards from the
+    // end, until the requirement is satisfied.
+    //
+    // Until the whole log has been loaded, m_entries contains only a suffix
+    // of the log, and the first entry in m_entries may have begun earlier
+    // than its time_point indicates, since its activity may continue an entry
+    // that has yet to be loaded.
+    void load_last(EntryIndex p_num);
+    void load_since(TimePoint const& p_time_point);
+    void load_suffix(std::function<bool()> const& p_is_sufficient);
+
+    // As for for_each_stint, but visiting only the entries already loaded.
+    void visit_stints
+    (   ActivityFilter const& p_activity_filter,
+        TimePoint const* p_begin,
+        TimePoint const* p_end,
+        StintVisitor const& p_visitor
+    );
+
+    // As for visit_stints, but rather than a Stint, p_visitor is passed the
+    // index of the entry with which each stint begins, and the Interval of
+    // the stint.
+    template <typename Visitor>
+    void visit_stint_intervals
+    (   ActivityFilter const& p_activity_filter,
+        TimePoint const* p_begin,
+        TimePoint const* p_end,
+        Visitor p_visitor
+    );
+
+    // ActivityStats accumulated by ActivityId, so that activity names need
+    // not be looked up, or compared, until accumulation is complete.
+    class ActivityStatsTable
+    {
+    public:
+        explicit ActivityStatsTable(ActivityId p_num_activities);
+        void add(ActivityId p_activity_id, ActivityStats const& p_stats);
+        bool contains(ActivityId p_activity_id) const;
+        ActivityStats const& at(ActivityId p_activity_id) const;
+
+    private:
+        std::vector<ActivityStats> m_stats;
+        std::vector<bool> m_is_present;
+    };
+
+    // As for get_activity_stats, once the necessary entries are loaded, but
+    // adding the ActivityStats to p_activity_stats_table.
+    void accumulate_activity_stats
+    (   ActivityFilter const& p_activity_filter,
+        TimePoint const* p_begin,
+        TimePoint const* p_end,
+        ActivityStatsTable& p_activity_stats_table
+    );
+
+    // Add to p_activity_stats_table each stint of zero duration at exactly
+    // p_seconds, the activity of which satisfies p_filter_memo.
+    void add_boundary_stints
+    (   EpochSeconds p_seconds,
+        FilterMemo& p_filter_memo,
+        ActivityStatsTable& p_activity_stats_table
+    ) const;
+
+    // Start to load a suffix of the log, loading at least one entry.
+    void begin_suffix();
+
+    // Load a further block of the log file, preceding the entries already
+    // loaded; or, once the whole log file is loaded, the closed segment that
+    // precedes them.
+    void extend_suffix();
+    void extend_suffix(MappedFile const& p_file);
+    void extend_suffix_by_segment();
+
+    // Read m_segments from the manifest (leaving it empty if there is no
+    // manifest), first completing any rotation that was interrupted.
+    void load_manifest();
+
+    // Write m_segments to the manifest. If p_rotating is true, the manifest
+    // also records that a new log file is staged, to be moved into place.
+    void save_manifest(bool p_rotating);
+
+    // Returns true if and only if the manifest has not been changed since
+    // it was last read or written.
+    bool manifest_is_current() const;
+
+    std::string segment_filepath(Segment const& p_segment) const;
+
+    // Returns the number of leading entries in m_entries that were loaded
+    // from closed segments, rather than from the log file.
+    EntryIndex num_archived_entries() const;
+
+    // Append the entries of p_segment to m_entries, setting p_segment.end.
+    void load_segment(Segment& p_segment);
+
+    // Append all the closed segments to m_entries.
+    void load_segments();
+
+    // Write each modified segment, from m_entries, to its file, and update
+    // the manifest accordingly.
+    void save_segments();
+
+    // Write the entries from index p_begin to p_segment.end to the file of
+    // p_segment, in p_segment.encoding, recording their range and activities
+    // in p_segment.
+    void write_segment(Segment& p_segment, EntryIndex p_begin);
+
+    // If the log file contains entries from before the period of the last
+    // entry, move them to new closed segments.
+    void rotate_segments();
+
+    void throw_if_future_dated() const;
+
+    // Returns a hash of the tail of [p_begin, p_end), as a final check that
+    // the log file has not been changed since it was last read or written.
+    static unsigned long long tail_hash(char const* p_begin, char const* p_end);
+
+    // Throw std::runtime_error, reporting that the entry on the line of
+    // p_file at p_position is out of order.
+    static void throw_out_of_order(MappedFile const& p_file, char const* p_position);
+
+    // Append the entries in the archive mapped in p_file to m_entries.
+    void load_archive(MappedFile const& p_file);
+
+    // Append p_entries to m_entries, registering each of their activities
+    // once rather than once per entry, and combining consecutive entries
+    // with the same activity. Returns false, having appended only the
+    // entries before it, if an entry precedes the entry before it.
+    bool append_entries(ArchivedEntries const& p_entries);
+
+    // Parse the log file, as mapped in p_file, from the line beginning at
+    // p_begin up to the line beginning at p_end (or the end of the file if
+    // p_end is k_unknown_offset), appending the entries to m_entries.
+    void load_text
+    (   MappedFile const& p_file,
+        unsigned long long p_begin = 0,
+        unsigned long long p_end = k_unknown_offset
+    );
+
+    // Parse the lines of the log file, as mapped in p_file, in [p_begin,
+    // p_end), split into p_num_chunks chunks parsed concurrently, appending
+    // the entries to m_entries. Returns the beginning of the first line from
+    // which the log must instead be parsed in sequence, which is p_end if
+    // all went well.
+    char const* load_text_in_parallel
+    (   MappedFile const& p_file,
+        char const* p_begin,
+        char const* p_end,
+        unsigned long long p_num_chunks
+    );
+
+    // Bring the in-memory data structures up to date with the log file by
+    // reparsing it only from the line at which the last saved entry begins,
+    // returning true if and only if this is possible. This requires that
+    // the entries before the last saved entry have not been changed, in
+    // memory or in the file, since the file was last read or written;
+    // however the file may since have been appended to. If false is
+    // returned, the in-memory data structures are unchanged.
+    bool reload_tail();
+
+    // Populate the in-memory data structures from the index file, returning
+    // true if and only if the index could be read and is up to date with the
+    // log file, as mapped in p_file. If false is returned, the in-memory data
+    // structures must be cleared before use.
+    bool load_index(MappedFile const& p_file);
+
+    // Write the in-memory data structures to the index file. Failure to do
+    // so is not an error, since the index is only an optimization.
+    void save_index() const;
+
+    // Returns a hash of the settings that determine how the time stamps in the
+    // log file are interpreted.
+    unsigned long long settings_hash() const;
+
+    // Returns true if and only if the line in p_file starting at p_offset
+    // begins with a time stamp equal to p_time_point.
+    bool stamp_matches
+    (   MappedFile const& p_file,
+        unsigned long long p_offset,
+        TimePoint const& p_time_point
+    );
+
+    // Returns true if and only if save() can write just the entries that
+    // have changed since the log file was last read or written, rather than
+    // rewriting the whole file.
+    bool can_save_tail() const;
+
+    // Record that an entry refers to an activity, or that it has ceased
+    // to do so. The activity register contains a reference count for each
+    // activity and calling these functions causes this to be updated and
+    // for an activity to be deleted from the register when it is no
+    // longer referred to.
+    //
+    // NOTE register_activity_reference and deregister_activity_reference
+    // are implementation details for push_entry, pop_entry and put_entry,
+    // and for the functions that load or rename entries in bulk; they should
+    // not be called from elsewhere.
+    ActivityId register_activity_reference(std::string const& p_activity);
+    void deregister_activity_reference(ActivityId p_activity_id);
+
+    std::string const& activity_at(EntryIndex p_index) const;
+
+    void push_entry(std::string const& p_activity, TimePoint const& p_time_point);
+    void pop_entry();
+
+    // Place a new entry at a specific index in m_entries, but only if it
+    // would not result in consecutive identical activities. Return true
+    // if and only if entry placed.
+    bool put_entry
+    (   std::string const& p_activity,
+        TimePoint const& p_time_point,
+        EntryIndex p_index
+    );
+
+    // Append an entry to the log file. Returns the number of characters written.
+    template <typename Writer>
+    std::string::size_type write_entry
+    (   Writer& p_writer,
+        std::string const& p_activity,
+        TimePoint const& p_time_point
+    );
+
+    std::string const& id_to_activity(ActivityId p_activity_id) const;
+    EntryIndex find_entry_just_before(TimePoint const& p_time_point) const;
+
+    // Returns the index of the first entry that does not precede
+    // p_time_point, or the number of entries if there is no such entry.
+    EntryIndex find_entry_not_before(TimePoint const& p_time_point) const;
+
+    // Returns the Interval of the stint begun by the entry at p_index,
+    // clipped to the range from *p_begin to *p_end (where non-null), and
+    // ending at p_now if it is the last stint.
+    Interval stint_interval
+    (   EntryIndex p_index,
+        TimePoint const* p_begin,
+        TimePoint const* p_end,
+        TimePoint const& p_now
+    ) const;
+
+    // check validity of internal data structures
+    void assert_valid() const
+    {
+#       ifndef NDEBUG
+            do_assert_valid();
+#       endif
+    }
+
+#   ifndef NDEBUG
+        void do_assert_valid() const;
+#   endif
+
+// member variables
+private:
+    bool m_loaded = false;
+    bool const m_use_index;
+    Segmentation const m_segmentation;
+    unsigned int m_expected_time_stamp_length;
+    std::string m_filepath;
+    Entries m_entries;
+    ActivityTable m_activity_table;
+    ActivityRegistry m_activity_registry;
+
+    // Elements of m_activity_table that are available for reuse.
+    std::vector<ActivityId> m_free_activity_ids;
+
+    // The activities in m_activity_registry, organised by their components.
+    ActivityTrie m_activity_trie;
+
+    // The time spent on each activity, per local day, over the whole days
+    // spanned by m_entries, in ascending order of day. This is kept up to
+    // date lazily, by update_rollup.
+    std::vector<RollupDay> m_rollup;
+    std::string const m_time_format;
+    TimeStampParser m_time_stamp_parser;
+    TimeStampFormatter m_time_stamp_formatter;
+    LogTextParser const m_text_parser;
+    std::string const m_index_filepath;
+    std::string const m_manifest_filepath;
+
+    // The closed segments of the log, in order, as recorded in the manifest.
+    // Of these, the first m_num_unloaded_segments have yet to be loaded.
+    std::vector<Segment> m_segments;
+    std::vector<Segment>::size_type m_num_unloaded_segments = 0;
+
+    // Signature and hash of the manifest when last read or written.
+    FileSignature m_manifest_signature;
+    unsigned long long m_manifest_hash = 0;
+
+    // The following record the state of the log file as at when it was last
+    // read or written, so that save() can write just the tail of the file when
+    // the earlier entries have not changed.
+
+    // Signature of the log file when last read or written.
+    FileSignature m_file_signature;
+
+    // Hash of the tail of the log file, as returned by tail_hash, when last
+    // read or written.
+    unsigned long long m_file_tail_hash = 0;
+
+    // Number of entries in the log file when last read or written.
+    EntryIndex m_num_saved_entries = 0;
+
+    // Number of leading entries in m_entries that are known to be unchanged
+    // since the log file was last read or written.
+    EntryIndex m_num_unchanged_entries = 0;
+
+    // Byte offset of the line in the log file at which the last saved entry
+    // begins, or k_unknown_offset if this is not known.
+    unsigned long long m_last_saved_entry_offset = k_unknown_offset;
+
+    // Whether the log file ends with a newline (or is empty).
+    bool m_file_ends_with_newline = true;
+
+    // Whether m_entries contains all the entries in the log, or only those
+    // parsed from the line of the log file beginning at byte offset
+    // m_suffix_offset onwards, preceded by those of the last closed segments
+    // (if m_suffix_offset is 0).
+    bool m_complete = true;
+    unsigned long long m_suffix_offset = 0;
+};
+
+// Provides RAII mechanism for managing changes to time log as a transaction.
+class TimeLog::Impl::Transaction
+{
+public:
+    // If p_tail_only is true, the transaction must change at most the last
+    // entry in the log, other than by appending entries. It may then be
+    // possible to carry out the transaction without loading the whole log.
+    explicit Transaction(TimeLog::Impl& p_time_log, bool p_tail_only = false);
+    Transaction(Transaction const&) = delete;
+    Transaction(Transaction&&) = delete;
+    Transaction& operator=(Transaction const&) = delete;
+    Transaction& operator=(Transaction&&) = delete;
+    ~Transaction();
+    void commit();
+private:
+    void rollback();
+    bool m_committed = false;
+    TimeLog::Impl& m_time_log_impl;
+};
+
+}  // namespace swx
+
+#endif  // GUARD_time_log_impl_hpp_9587417367280807
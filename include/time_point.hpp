@@ -18,6 +18,7 @@
 #define GUARD_time_point_hpp_285827964211734
 
 #include <chrono>
+#include <cstdint>
 #include <ctime>
 #include <string>
 
@@ -28,6 +29,21 @@ using TimePoint = std::chrono::time_point<std::chrono::system_clock>;
 
 TimePoint now();
 
+/**
+ * A time as a number of seconds since the epoch, which is how the entries
+ * of the time log are held in memory (being at least as fine a resolution
+ * as that of the time stamps in the log).
+ */
+using EpochSeconds = std::int64_t;
+
+/**
+ * @returns \e p_time_point in whole seconds since the epoch, rounded
+ * towards the past (not towards zero).
+ */
+EpochSeconds time_point_to_seconds(TimePoint const& p_time_point);
+
+TimePoint seconds_to_time_point(EpochSeconds p_seconds);
+
 /**
  * The first TimePoint of the day on which \e p_time_point falls; or, if
  * \e p_days_diff is passed a positive integer \e n, the first TimePoint of the
@@ -88,6 +104,29 @@ std::string time_point_to_stamp
     unsigned int p_formatted_buf_len
 );
 
+
+// INLINE FUNCTION IMPLEMENTATIONS
+
+inline
+EpochSeconds
+time_point_to_seconds(TimePoint const& p_time_point)
+{
+    auto const duration = p_time_point.time_since_epoch();
+    auto ret = std::chrono::duration_cast<std::chrono::seconds>(duration).count();
+    if (std::chrono::seconds(ret) > duration)
+    {
+        --ret;  // round towards the past, not towards zero
+    }
+    return ret;
+}
+
+inline
+TimePoint
+seconds_to_time_point(EpochSeconds p_seconds)
+{
+    return TimePoint(std::chrono::seconds(p_seconds));
+}
+
 }  // namespace swx
 
 #endif  // GUARD_time_point_hpp_285827964211734
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_time_stamp_formatter_hpp_5190374628819053
+#define GUARD_time_stamp_formatter_hpp_5190374628819053
+
+#include "time_point.hpp"
+#include "time_zone.hpp"
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace swx
+{
+
+/**
+ * Formats TimePoints as timestamps in a particular format, yielding the same
+ * results as \e time_point_to_stamp, but much faster when formatting large
+ * numbers of timestamps.
+ *
+ * The broken-down local time at the beginning of the most recent day
+ * formatted is cached, so that the time zone database need only be
+ * consulted once per day encountered, provided the UTC offset is constant
+ * throughout that day (otherwise each timestamp on that day is converted
+ * individually). If the format consists only of the conversion
+ * specifications %Y, %m, %d, %H, %M, %S, %F, %T, %R and %%, and of literal
+ * characters, then the timestamp is written directly, and only those of its
+ * fields that have changed since the previous timestamp are rewritten; for
+ * any other format, the cached broken-down time is passed to \e strftime.
+ */
+class TimeStampFormatter
+{
+// nested types
+private:
+    enum class Field
+    {
+        literal,
+        year,
+        month,
+        day,
+        hour,
+        minute,
+        second
+    };
+
+    struct Token
+    {
+        Token(Field p_field, char p_literal = '\0');
+        Field field;
+        char literal;
+    };
+
+// special member functions
+public:
+    TimeStampFormatter(std::string const& p_format, unsigned int p_formatted_buf_len);
+    TimeStampFormatter(TimeStampFormatter const& rhs) = delete;
+    TimeStampFormatter(TimeStampFormatter&& rhs) = delete;
+    TimeStampFormatter& operator=(TimeStampFormatter const& rhs) = delete;
+    TimeStampFormatter& operator=(TimeStampFormatter&& rhs) = delete;
+    ~TimeStampFormatter();
+
+// ordinary member functions
+public:
+
+    /**
+     * @returns \e p_time_point formatted as a timestamp. The returned
+     * reference remains valid only until the next call to this function.
+     *
+     * @exception std::runtime_error if the timestamp would not fit within the
+     * buffer length passed to the constructor (including the terminating null
+     * character).
+     */
+    std::string const& format(TimePoint const& p_time_point);
+
+    /**
+     * @returns \e true if and only if the format passed to the constructor
+     * is written directly, without recourse to \e strftime.
+     */
+    bool is_specialized() const;
+
+private:
+    bool compile(std::string const& p_format);
+
+    // Set m_day_begin, m_day_end and m_day_tm to describe the day on which
+    // p_seconds falls, if its UTC offset is constant; otherwise set them to
+    // describe just the second p_seconds itself.
+    void load_day(long long p_seconds);
+
+    // Set m_result to the timestamp for p_tm.
+    void format_tm(std::tm const& p_tm);
+
+    // Overwrite the two digits of m_result at p_position with p_value.
+    void write_digits(std::string::size_type p_position, int p_value);
+
+// member variables
+private:
+    std::string const m_format;
+    TimeZone const& m_time_zone;
+    unsigned int const m_formatted_buf_len;
+    bool m_specialized;
+    std::vector<Token> m_tokens;
+
+    // Positions of the hour, minute and second within m_result, when
+    // specialized (std::string::npos if not in the format).
+    std::string::size_type m_hour_position;
+    std::string::size_type m_minute_position;
+    std::string::size_type m_second_position;
+
+    // The local time at the beginning of the cached range of seconds
+    // [m_day_begin, m_day_end), throughout which the UTC offset is constant.
+    long long m_day_begin;
+    long long m_day_end;
+    std::tm m_day_tm;
+
+    // Whether m_result holds a timestamp on the cached day, formatted
+    // without recourse to strftime.
+    bool m_day_formatted;
+
+    // The most recently formatted second, and the result.
+    long long m_seconds;
+    std::string m_result;
+    std::vector<char> m_buffer;
+
+};  // class TimeStampFormatter
+
+}  // namespace swx
+
+#endif  // GUARD_time_stamp_formatter_hpp_5190374628819053
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_time_stamp_parser_hpp_7130946620981454
+#define GUARD_time_stamp_parser_hpp_7130946620981454
+
+#include "time_point.hpp"
+#include "time_zone.hpp"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace swx
+{
+
+/**
+ * Parses timestamps in a particular format, yielding the same results as
+ * \e long_time_stamp_to_point, but much faster when parsing large numbers
+ * of timestamps.
+ *
+ * If the format consists only of the conversion specifications %Y, %m, %d,
+ * %H, %M, %S, %F, %T, %R and %%, and of literal characters, and includes at
+ * least a year, month and day, then timestamps are parsed by reading their
+ * digits directly, and the resulting local civil time is converted to a
+ * TimePoint using a cached table of UTC offsets, one per day, so that the
+ * time zone database need only be consulted once per day encountered. On days
+ * on which the UTC offset changes (e.g. due to daylight saving), the local
+ * TimeZone is consulted for each timestamp.
+ *
+ * For any other format, or for any timestamp that does not conform exactly
+ * to the expected layout (e.g. a hand-edited timestamp lacking leading zeroes),
+ * parsing falls back to \e long_time_stamp_to_point.
+ */
+class TimeStampParser
+{
+// nested types
+private:
+    enum class Field
+    {
+        literal,
+        year,
+        month,
+        day,
+        hour,
+        minute,
+        second
+    };
+
+    struct DayOffsets
+    {
+        long long first = 0;
+        long long last = 0;
+    };
+
+    struct Token
+    {
+        Token(Field p_field, char p_literal = '\0');
+        Field field;
+        char literal;
+    };
+
+// special member functions
+public:
+    explicit TimeStampParser(std::string const& p_format);
+    TimeStampParser(TimeStampParser const& rhs) = delete;
+    TimeStampParser(TimeStampParser&& rhs) = delete;
+    TimeStampParser& operator=(TimeStampParser const& rhs) = delete;
+    TimeStampParser& operator=(TimeStampParser&& rhs) = delete;
+    ~TimeStampParser();
+
+// ordinary member functions
+public:
+
+    /**
+     * Parses the timestamp at the beginning of the range [\e p_begin,
+     * \e p_end). Any characters following the timestamp are ignored.
+     *
+     * @exception std::runtime_error if the timestamp cannot be parsed.
+     */
+    TimePoint parse(char const* p_begin, char const* p_end);
+
+    /**
+     * @returns \e true if and only if the format passed to the constructor
+     * can be parsed without falling back to \e long_time_stamp_to_point
+     * (for timestamps that conform to it exactly).
+     */
+    bool is_specialized() const;
+
+    /**
+     * @returns the UTC offset of the most recently parsed timestamp, by
+     * which the interpretation of an ambiguous timestamp (as occurs when
+     * daylight saving ends) is chosen. A sequence of timestamps parsed in
+     * pieces by several TimeStampParsers yields the same results as when
+     * parsed by one, if each begins with the previous offset with which the
+     * parser of the preceding piece finished.
+     */
+    long long previous_offset() const;
+
+    void set_previous_offset(long long p_offset);
+
+private:
+    bool compile(std::string const& p_format);
+
+    // Returns true and sets p_result if parsing succeeds; otherwise returns false.
+    bool parse_fast(char const* p_begin, char const* p_end, long long& p_result);
+
+    // Returns the UTC offsets (in seconds) in effect at the beginning and at
+    // the end of the day with the given number and civil date.
+    DayOffsets const& utc_offsets_of_day
+    (   long long p_day_number,
+        int p_year,
+        int p_month,
+        int p_day
+    );
+
+// member variables
+private:
+    std::string const m_format;
+    TimeZone const& m_time_zone;
+    bool m_specialized;
+    std::vector<Token> m_tokens;
+
+    // Cache of UTC offsets, keyed by day number. The most recently used
+    // day is also remembered separately, since log entries mostly arrive
+    // in date order.
+    long long m_last_day_number;
+    DayOffsets m_last_day_offsets;
+    std::unordered_map<long long, DayOffsets> m_day_offsets;
+
+    // UTC offset of the most recently parsed timestamp.
+    long long m_previous_offset;
+
+};  // class TimeStampParser
+
+}  // namespace swx
+
+#endif  // GUARD_time_stamp_parser_hpp_7130946620981454
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_time_zone_hpp_7522016878215463
+#define GUARD_time_zone_hpp_7522016878215463
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace swx
+{
+
+/**
+ * Returns the number of days between 1970-01-01 and the given date in the
+ * proleptic Gregorian calendar. Days beyond the end of the month carry over
+ * into the next month, as with \e mktime.
+ */
+long long days_from_civil(long long p_year, int p_month, int p_day);
+
+/**
+ * Converts between UTC and local time for the time zone in effect when the
+ * TimeZone is constructed, without recourse to the static storage used by
+ * \e localtime and \e mktime, so that conversions may be performed
+ * concurrently from multiple threads.
+ *
+ * On construction, the UTC offsets, daylight saving flags and abbreviations
+ * in effect from 1970 to 2037 are precomputed into a table of transitions,
+ * using \e localtime_r. Conversions within that range are then performed by
+ * binary search of the table; conversions outside it are delegated to
+ * \e localtime_r and \e mktime. As those consult the TZ environment variable
+ * and static state shared with \e tzset, such conversions are serialized by
+ * the same mutex as \e local: they remain safe to perform concurrently, but
+ * are slower, and do not scale across threads.
+ */
+class TimeZone
+{
+// nested types
+private:
+    struct State
+    {
+        long long begin;  // first second at which this state is in effect
+        long offset;
+        bool is_dst;
+        std::vector<std::string>::size_type abbreviation;
+    };
+
+// static member functions
+public:
+
+    /**
+     * @returns the TimeZone for the TZ environment variable as it currently
+     * stands. TimeZones are cached and never destroyed, so the returned
+     * reference remains valid for the life of the program; but it does not
+     * reflect subsequent changes to TZ, for which this function must be
+     * called again.
+     */
+    static TimeZone const& local();
+
+// special member functions
+public:
+    TimeZone();
+    TimeZone(TimeZone const& rhs) = delete;
+    TimeZone(TimeZone&& rhs) = delete;
+    TimeZone& operator=(TimeZone const& rhs) = delete;
+    TimeZone& operator=(TimeZone&& rhs) = delete;
+    ~TimeZone();
+
+// ordinary member functions
+public:
+
+    /**
+     * @returns the local broken-down time at \e p_seconds since the epoch,
+     * as would \e localtime_r. The \e tm_zone member of the result points
+     * into storage owned by the TimeZone.
+     */
+    std::tm to_tm(long long p_seconds) const;
+
+    /**
+     * @returns the number of seconds since the epoch at which the local time
+     * is as described by \e p_tm, as would \e mktime, with fields beyond their
+     * normal ranges carrying over into the next larger field. If \e tm_isdst
+     * is positive or zero, it is honoured as with \e mktime. If it is negative
+     * and the local time occurs twice, the earlier occurrence is returned; if
+     * the local time does not occur, it is interpreted using the UTC offset
+     * in effect immediately beforehand. Unlike \e mktime, \e p_tm is not
+     * modified.
+     */
+    long long to_seconds(std::tm const& p_tm) const;
+
+    /**
+     * @returns the UTC offset in effect at \e p_seconds since the epoch, in
+     * seconds east of UTC.
+     */
+    long utc_offset(long long p_seconds) const;
+
+private:
+    bool in_table(long long p_seconds) const;
+
+    // Returns the index of the State in effect at p_seconds, which must be
+    // in_table.
+    std::vector<State>::size_type state_index(long long p_seconds) const;
+
+    // Returns the second since the epoch at which the local time is
+    // p_local_seconds (as if the local time were UTC), honouring p_isdst as
+    // described for to_seconds.
+    long long resolve(long long p_local_seconds, int p_isdst) const;
+
+// member variables
+private:
+    long long m_table_begin;
+    long long m_table_end;
+    std::vector<State> m_states;
+    std::vector<std::string> m_abbreviations;
+
+};  // class TimeZone
+
+}  // namespace swx
+
+#endif  // GUARD_time_zone_hpp_7522016878215463
@@ -64,6 +64,12 @@ ActivityFilter::replace(string const& p_old_str, string const& p_substitution) c
         p_old_str;
 }
 
+string const*
+ActivityFilter::subactivity_root() const
+{
+    return do_get_subactivity_root();
+}
+
 string
 ActivityFilter::do_replace(string const& p_old_str, string const& p_substitution) const
 {
@@ -71,4 +77,10 @@ ActivityFilter::do_replace(string const& p_old_str, string const& p_substitution
     return p_substitution;
 }
 
+string const*
+ActivityFilter::do_get_subactivity_root() const
+{
+    return nullptr;
+}
+
 }  // namespace swx
@@ -0,0 +1,190 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "activity_registry.hpp"
+#include "hash.hpp"
+#include <algorithm>
+#include <cassert>
+#include <string>
+#include <vector>
+
+using std::max;
+using std::string;
+using std::vector;
+
+namespace swx
+{
+
+ActivityRegistry::ActivityRegistry
+(   ActivityTable const& p_activity_table
+):
+    m_activity_table(p_activity_table)
+{
+}
+
+ActivityRegistry::size_type
+ActivityRegistry::size() const
+{
+    return m_size;
+}
+
+bool
+ActivityRegistry::empty() const
+{
+    return m_size == 0;
+}
+
+void
+ActivityRegistry::clear()
+{
+    m_slots.clear();
+    m_size = 0;
+}
+
+bool
+ActivityRegistry::find
+(   string const& p_activity,
+    ActivityId& p_activity_id
+) const
+{
+    if (m_slots.empty())
+    {
+        return false;
+    }
+    auto const activity_id = m_slots[probe(p_activity)].activity_id;
+    if (activity_id == k_no_activity_id)
+    {
+        return false;
+    }
+    p_activity_id = activity_id;
+    return true;
+}
+
+bool
+ActivityRegistry::contains(string const& p_activity) const
+{
+    ActivityId activity_id = 0;
+    return find(p_activity, activity_id);
+}
+
+bool
+ActivityRegistry::insert
+(   string const& p_activity,
+    ActivityId p_activity_id
+)
+{
+    assert (p_activity_id != k_no_activity_id);
+
+    // Keep the table at most half full, so that probe sequences are short.
+    if ((m_size + 1) * 2 > m_slots.size())
+    {
+        grow();
+    }
+    auto& slot = m_slots[probe(p_activity)];
+    if (slot.activity_id != k_no_activity_id)
+    {
+        return false;
+    }
+    slot.hash = hash(p_activity);
+    slot.activity_id = p_activity_id;
+    ++m_size;
+    return true;
+}
+
+void
+ActivityRegistry::erase(string const& p_activity)
+{
+    assert (!m_slots.empty());
+    auto const mask = m_slots.size() - 1;
+    auto i = probe(p_activity);
+    assert (m_slots[i].activity_id != k_no_activity_id);
+
+    // Rather than leave a marker in the vacated slot, move back into it any
+    // later slot in the same run that would otherwise no longer be reached
+    // by its probe sequence, and so on until the end of the run.
+    for
+    (   auto j = (i + 1) & mask;
+        m_slots[j].activity_id != k_no_activity_id;
+        j = (j + 1) & mask
+    )
+    {
+        // The slot at j is reached from its home slot without passing i if
+        // and only if its home lies cyclically in (i, j].
+        auto const home = m_slots[j].hash & mask;
+        auto const reachable =
+            ((i <= j)? ((i < home) && (home <= j)): ((i < home) || (home <= j)));
+        if (!reachable)
+        {
+            m_slots[i] = m_slots[j];
+            i = j;
+        }
+    }
+    m_slots[i].activity_id = k_no_activity_id;
+    --m_size;
+}
+
+unsigned long long
+ActivityRegistry::hash(string const& p_activity)
+{
+    return hash_bytes(p_activity.data(), p_activity.data() + p_activity.size());
+}
+
+vector<ActivityRegistry::Slot>::size_type
+ActivityRegistry::probe(string const& p_activity) const
+{
+    assert (!m_slots.empty());
+    auto const mask = m_slots.size() - 1;
+    auto const activity_hash = hash(p_activity);
+    auto i = activity_hash & mask;
+    for ( ; m_slots[i].activity_id != k_no_activity_id; i = (i + 1) & mask)
+    {
+        auto const& slot = m_slots[i];
+        if
+        (   (slot.hash == activity_hash) &&
+            (*m_activity_table[slot.activity_id].name == p_activity)
+        )
+        {
+            break;
+        }
+    }
+    return i;
+}
+
+void
+ActivityRegistry::grow()
+{
+    vector<Slot> slots(max<vector<Slot>::size_type>(16, m_slots.size() * 2));
+    for (auto& slot: slots)
+    {
+        slot.activity_id = k_no_activity_id;
+    }
+    auto const mask = slots.size() - 1;
+    for (auto const& slot: m_slots)
+    {
+        if (slot.activity_id != k_no_activity_id)
+        {
+            auto i = slot.hash & mask;
+            while (slots[i].activity_id != k_no_activity_id)
+            {
+                i = (i + 1) & mask;
+            }
+            slots[i] = slot;
+        }
+    }
+    m_slots.swap(slots);
+}
+
+}  // namespace swx
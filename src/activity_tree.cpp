@@ -16,116 +16,391 @@
 
 #include "activity_tree.hpp"
 #include "activity_stats.hpp"
-#include "activity_node.hpp"
-#include "arithmetic.hpp"
 #include "string_utilities.hpp"
+#include <algorithm>
 #include <cassert>
 #include <map>
 #include <ostream>
-#include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+using std::char_traits;
 using std::map;
 using std::max;
-using std::move;
+using std::min;
 using std::ostream;
-using std::set;
 using std::string;
+using std::unordered_map;
 using std::vector;
 
 namespace swx
 {
 
-ActivityTree::ActivityTree(map<string, ActivityStats> const& p_stats):
-    m_root(ActivityNode())
+namespace
 {
-    // Calculate the greatest number of components of any activity
-    vector<string>::size_type depth = 0;
-    for (auto const& p: p_stats) depth = max(depth, split(p.first).size());
+    // Marks the absence of a node, as for the parent of the root.
+    std::size_t const k_no_node = static_cast<std::size_t>(-1);
 
-    // Make all the leaf activities have the same number of components, and insert
-    // them into the inheritance map.
+}  // end anonymous namespace
+
+/**
+ * Builds the nodes of an ActivityTree from the activities beneath it,
+ * each of which is read one component at a time, in place, rather than
+ * being split into copies of its components.
+ */
+class ActivityTree::Builder
+{
+public:
+    Builder
+    (   ActivityTree& p_tree,
+        map<string, ActivityStats> const& p_stats,
+        unsigned int p_depth_limit
+    );
+    void build();
+
+private:
+
+    // An activity, with the position and size in it of the component at
+    // the level of the tree currently being built. Once its components are
+    // exhausted, the position is string::npos, and it is treated as having
+    // empty components to the depth of the tree.
+    struct Leaf
+    {
+        string const* activity;
+        ActivityStats const* stats;
+        string::size_type offset;
+        string::size_type size;
+    };
+    using LeafIter = vector<Leaf>::iterator;
+
+    static Leaf make_leaf(string const& p_activity, ActivityStats const& p_stats);
+    static void advance(Leaf& p_leaf);
+    static int compare_component(Leaf const& lhs, Leaf const& rhs);
+    static int compare_components(Leaf lhs, Leaf rhs);
+
+    ComponentId intern(Leaf const& p_leaf);
+
+    // Build the descendants of p_node, the node at p_level that would be
+    // printed at p_print_depth, from the leaves in [p_begin, p_end), each
+    // of which is positioned at component p_level.
+    void build
+    (   NodeIndex p_node,
+        LeafIter p_begin,
+        LeafIter p_end,
+        vector<string>::size_type p_level,
+        unsigned int p_print_depth
+    );
+
+    ActivityTree& m_tree;
+    unsigned int const m_depth_limit;
+    vector<string>::size_type m_depth;  // the greatest number of components
+    vector<Leaf> m_leaves;
+    unordered_map<string, ComponentId> m_component_ids;
+};
+
+ActivityTree::ActivityTree
+(   map<string, ActivityStats> const& p_stats,
+    unsigned int p_depth_limit
+)
+{
+    Builder(*this, p_stats, p_depth_limit).build();
+}
+
+ActivityTree::Builder::Builder
+(   ActivityTree& p_tree,
+    map<string, ActivityStats> const& p_stats,
+    unsigned int p_depth_limit
+):
+    m_tree(p_tree),
+    m_depth_limit(p_depth_limit),
+    m_depth(0)
+{
+    m_leaves.reserve(p_stats.size());
     for (auto const& pair: p_stats)
     {
-        m_map.emplace(ActivityNode(pair.first, depth), ActivityData(pair.second));
+        auto const& activity = pair.first;
+        m_leaves.push_back(make_leaf(activity, pair.second));
+        if (!activity.empty())
+        {
+            auto const num_components =
+                std::count(activity.begin(), activity.end(), ' ') + 1;
+            m_depth = max<vector<string>::size_type>(m_depth, num_components);
+        }
     }
+}
 
-    // Go through each generation, starting with the leaves, and building the parent
-    // generation of each. But first, cover the case where there are no nodes. Even
-    // then, we want a root node.
-    if (m_map.empty()) m_map.emplace(m_root, ActivityData());
-    auto current_generation = m_map;
-    assert (!current_generation.empty());
-    while (current_generation.begin()->first != m_root)
+void
+ActivityTree::Builder::build()
+{
+    // Take the leaves in ascending order of their components, discarding
+    // all but the first of any with equal components.
+    auto is_sorted = true;
+    auto has_duplicates = false;
+    for (vector<Leaf>::size_type i = 1; i < m_leaves.size(); ++i)
     {
-        decltype(current_generation) parent_generation;
-        for (auto const& pair: current_generation)
+        auto const result = compare_components(m_leaves[i - 1], m_leaves[i]);
+        if (result > 0)
         {
-            auto const& node = pair.first;
-            auto const& stats = pair.second.stats;
-            auto const parent_node = node.parent();
-            auto const parent_iter = parent_generation.find(parent_node);
-            if (parent_iter == parent_generation.end())
-            {
-                parent_generation.emplace(move(parent_node), ActivityData(stats, {node}));
-            }
-            else
+            is_sorted = false;
+            break;
+        }
+        if (result == 0) has_duplicates = true;
+    }
+    if (!is_sorted)
+    {
+        std::stable_sort
+        (   m_leaves.begin(),
+            m_leaves.end(),
+            [](Leaf const& lhs, Leaf const& rhs)
             {
-                parent_iter->second.children.insert(node);
-                parent_iter->second.stats += stats;
+                return compare_components(lhs, rhs) < 0;
             }
+        );
+    }
+    if (!is_sorted || has_duplicates)
+    {
+        m_leaves.erase
+        (   std::unique
+            (   m_leaves.begin(),
+                m_leaves.end(),
+                [](Leaf const& lhs, Leaf const& rhs)
+                {
+                    return compare_components(lhs, rhs) == 0;
+                }
+            ),
+            m_leaves.end()
+        );
+    }
+
+    // Even if there are no leaves, we want a root node.
+    auto& nodes = m_tree.m_nodes;
+    assert (nodes.empty());
+    Leaf const root_leaf{nullptr, nullptr, string::npos, 0};
+    nodes.push_back
+    (   Node
+        {   intern(root_leaf),
+            k_no_node,
+            k_no_node,
+            k_no_node,
+            k_no_node,
+            0,
+            ActivityStats()
+        }
+    );
+    build(0, m_leaves.begin(), m_leaves.end(), 0, 0);
+
+    // Each node follows its parent, so the stats can be combined from the
+    // leaves upwards in a single pass.
+    for (auto i = nodes.size() - 1; i != 0; --i)
+    {
+        auto const& node = nodes[i];
+        nodes[node.parent].stats += node.stats;
+    }
+}
+
+void
+ActivityTree::Builder::build
+(   NodeIndex p_node,
+    LeafIter p_begin,
+    LeafIter p_end,
+    vector<string>::size_type p_level,
+    unsigned int p_print_depth
+)
+{
+    if (p_begin == p_end)
+    {
+        return;
+    }
+    if (p_level == m_depth)
+    {
+        assert (p_end - p_begin == 1);
+        m_tree.m_nodes[p_node].stats = *p_begin->stats;
+        return;
+    }
+
+    // As the leaves are in order, those sharing each child lie together;
+    // so there is just one child if the first and last leaves share it.
+    auto const has_one_child = (compare_component(*p_begin, *(p_end - 1)) == 0);
+    auto const child_print_depth = p_print_depth + (has_one_child ? 0 : 1);
+    if ((m_depth_limit != 0) && (child_print_depth >= m_depth_limit))
+    {
+        // None of the descendants would be printed.
+        auto& node = m_tree.m_nodes[p_node];
+        node.num_children = 1;
+        node.stats = *p_begin->stats;
+        for (auto it = p_begin + 1; it != p_end; ++it)
+        {
+            if (compare_component(*(it - 1), *it) != 0) ++node.num_children;
+            node.stats += *it->stats;
+        }
+        return;
+    }
+    for (auto child_begin = p_begin; child_begin != p_end; )
+    {
+        auto child_end = child_begin + 1;
+        while ((child_end != p_end) && (compare_component(*child_begin, *child_end) == 0))
+        {
+            ++child_end;
         }
-        m_map.insert(parent_generation.begin(), parent_generation.end());
-        // We don't need the just-visited current generation any more. All its nodes are
-        // now stored as children within the parent generation. So what was the parent
-        // generation becomes the new current generation.
-        current_generation = move(parent_generation);
-        assert (!current_generation.empty());
+        auto const child = m_tree.add_child(p_node, intern(*child_begin));
+        for (auto it = child_begin; it != child_end; ++it) advance(*it);
+        build(child, child_begin, child_end, p_level + 1, child_print_depth);
+        child_begin = child_end;
+    }
+}
+
+ActivityTree::Builder::Leaf
+ActivityTree::Builder::make_leaf
+(   string const& p_activity,
+    ActivityStats const& p_stats
+)
+{
+    Leaf ret{&p_activity, &p_stats, 0, p_activity.find(' ')};
+    if (p_activity.empty())
+    {
+        ret.offset = string::npos;
+        ret.size = 0;
+    }
+    else if (ret.size == string::npos)
+    {
+        ret.size = p_activity.size();
     }
+    return ret;
+}
+
+void
+ActivityTree::Builder::advance(Leaf& p_leaf)
+{
+    if (p_leaf.offset == string::npos)
+    {
+        return;
+    }
+    auto const& activity = *p_leaf.activity;
+    auto const end = p_leaf.offset + p_leaf.size;
+    if (end == activity.size())
+    {
+        p_leaf.offset = string::npos;
+        p_leaf.size = 0;
+        return;
+    }
+    p_leaf.offset = end + 1;
+    auto const next_end = activity.find(' ', p_leaf.offset);
+    p_leaf.size =
+        ((next_end == string::npos) ? activity.size() : next_end) - p_leaf.offset;
+}
+
+int
+ActivityTree::Builder::compare_component(Leaf const& lhs, Leaf const& rhs)
+{
+    auto const lhs_size = lhs.size;
+    auto const rhs_size = rhs.size;
+    auto const size = min(lhs_size, rhs_size);
+    if (size != 0)
+    {
+        auto const result = char_traits<char>::compare
+        (   lhs.activity->data() + lhs.offset,
+            rhs.activity->data() + rhs.offset,
+            size
+        );
+        if (result != 0)
+        {
+            return result;
+        }
+    }
+    return (lhs_size < rhs_size) ? -1 : ((rhs_size < lhs_size) ? 1 : 0);
+}
+
+int
+ActivityTree::Builder::compare_components(Leaf lhs, Leaf rhs)
+{
+    while ((lhs.offset != string::npos) || (rhs.offset != string::npos))
+    {
+        auto const result = compare_component(lhs, rhs);
+        if (result != 0)
+        {
+            return result;
+        }
+        advance(lhs);
+        advance(rhs);
+    }
+    return 0;
+}
+
+ActivityTree::ComponentId
+ActivityTree::Builder::intern(Leaf const& p_leaf)
+{
+    auto& components = m_tree.m_components;
+    auto const component = ((p_leaf.offset == string::npos) ?
+        string() :
+        p_leaf.activity->substr(p_leaf.offset, p_leaf.size));
+    auto const result = m_component_ids.emplace(component, components.size());
+    if (result.second) components.push_back(component);
+    return result.first->second;
+}
+
+ActivityTree::NodeIndex
+ActivityTree::add_child(NodeIndex p_parent, ComponentId p_component)
+{
+    NodeIndex const ret = m_nodes.size();
+    m_nodes.push_back
+    (   Node
+        {   p_component,
+            p_parent,
+            k_no_node,
+            k_no_node,
+            k_no_node,
+            0,
+            ActivityStats()
+        }
+    );
+    auto& parent = m_nodes[p_parent];
+    if (parent.last_child == k_no_node)
+    {
+        parent.first_child = ret;
+    }
+    else
+    {
+        m_nodes[parent.last_child].next_sibling = ret;
+    }
+    parent.last_child = ret;
+    ++parent.num_children;
+    return ret;
 }
 
 void
 ActivityTree::print
 (   ostream& p_os,
-    ActivityNode const& p_node,
+    NodeIndex p_node,
     string const& p_label,
     unsigned int p_depth,
     PrintNode const& p_print_node
 ) const
 {
-    assert (m_map.find(p_node) != m_map.end());
-    auto const& data = m_map.find(p_node)->second;
+    assert (p_node < m_nodes.size());
+    auto const& node = m_nodes[p_node];
     string label_carried_forward;
-    if (data.children.size() == 1)
+    if (node.num_children == 1)
     {
         label_carried_forward = p_label + ' ';
     }
     else
     {
-        p_print_node(p_os, p_depth, p_label, data.stats);
+        p_print_node(p_os, p_depth, p_label, node.stats);
         ++p_depth;
     }
-    for (auto const& child: data.children)
+    for (auto i = node.first_child; i != k_no_node; i = m_nodes[i].next_sibling)
     {
-        auto const label = trim(label_carried_forward + child.marginal_name());
-        print(p_os, child, label, p_depth, p_print_node);
+        auto const& marginal_name = m_components[m_nodes[i].component];
+        auto const label = trim(label_carried_forward + marginal_name);
+        print(p_os, i, label, p_depth, p_print_node);
     }
 }
 
 void
 ActivityTree::print(ostream& p_os, PrintNode const& p_print_node) const
 {
-    print(p_os, m_root, "", 0, p_print_node);
-}
-
-ActivityTree::ActivityData::ActivityData
-(   ActivityStats const& p_stats,
-    set<ActivityNode> const& p_children
-):
-    stats(p_stats),
-    children(p_children)
-{
+    print(p_os, 0, "", 0, p_print_node);
 }
 
 }  // namespace swx
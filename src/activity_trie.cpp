@@ -0,0 +1,132 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "activity_trie.hpp"
+#include "string_utilities.hpp"
+#include <cassert>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace swx
+{
+
+ActivityTrie::ActivityTrie(): m_nodes(1)
+{
+}
+
+ActivityTrie::~ActivityTrie() = default;
+
+void
+ActivityTrie::insert(string const& p_activity, ActivityId p_activity_id)
+{
+    NodeIndex node = 0;
+    for (auto const& component: split(p_activity))
+    {
+        auto const it = m_nodes[node].children.find(component);
+        if (it == m_nodes[node].children.end())
+        {
+            auto const child = m_nodes.size();
+            m_nodes[node].children.emplace(component, child);
+            m_nodes.emplace_back();
+            node = child;
+        }
+        else
+        {
+            node = it->second;
+        }
+    }
+    m_nodes[node].activity_id = p_activity_id;
+    m_nodes[node].has_activity = true;
+}
+
+void
+ActivityTrie::erase(string const& p_activity)
+{
+    NodeIndex node = 0;
+    if (find_node(p_activity, node))
+    {
+        // The node itself is kept, as it may have children, and in any case
+        // is likely to be needed again.
+        m_nodes[node].has_activity = false;
+    }
+}
+
+void
+ActivityTrie::clear()
+{
+    m_nodes.clear();
+    m_nodes.emplace_back();
+}
+
+void
+ActivityTrie::find_subactivities
+(   string const& p_activity,
+    vector<ActivityId>& p_activity_ids
+) const
+{
+    NodeIndex node = 0;
+    if (!find_node(p_activity, node))
+    {
+        return;
+    }
+    if (p_activity.empty())
+    {
+        // The children of the root are not subactivities of the empty
+        // activity, as they do not begin with a space.
+        if (m_nodes[node].has_activity)
+        {
+            p_activity_ids.push_back(m_nodes[node].activity_id);
+        }
+        return;
+    }
+    vector<NodeIndex> pending{node};
+    while (!pending.empty())
+    {
+        auto const& current = m_nodes[pending.back()];
+        pending.pop_back();
+        if (current.has_activity)
+        {
+            p_activity_ids.push_back(current.activity_id);
+        }
+        for (auto const& child: current.children)
+        {
+            pending.push_back(child.second);
+        }
+    }
+}
+
+bool
+ActivityTrie::find_node(string const& p_activity, NodeIndex& p_node) const
+{
+    NodeIndex node = 0;
+    for (auto const& component: split(p_activity))
+    {
+        auto const it = m_nodes[node].children.find(component);
+        if (it == m_nodes[node].children.end())
+        {
+            return false;
+        }
+        node = it->second;
+    }
+    assert (node < m_nodes.size());
+    p_node = node;
+    return true;
+}
+
+}  // namespace swx
@@ -16,6 +16,7 @@
 
 #include "application.hpp"
 #include "command.hpp"
+#include "compact_command.hpp"
 #include "config.hpp"
 #include "config_command.hpp"
 #include "current_command.hpp"
@@ -82,7 +83,13 @@ Application::Application
     m_ordinary_ostream(p_ordinary_ostream),
     m_error_ostream(p_error_ostream),
     m_config(p_config),
-    m_time_log(p_config.path_to_log(), p_config.time_format(), p_config.formatted_buf_len())
+    m_time_log
+    (   p_config.path_to_log(),
+        p_config.time_format(),
+        p_config.formatted_buf_len(),
+        p_config.use_log_index(),
+        p_config.log_segments()
+    )
 {
     using V = vector<string>;
 
@@ -99,6 +106,7 @@ Application::Application
     CommandGroup edit("Editing commands");
     create_command<RenameCommand>(edit, "rename", V{}, m_time_log);
     create_command<EditCommand>(edit, "edit", V{"e"});
+    create_command<CompactCommand>(edit, "compact", V{}, m_time_log);
     m_command_groups.push_back(move(edit));
 
     CommandGroup misc("Miscellaneous commands");
@@ -0,0 +1,334 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "archive.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef SWX_USE_ZLIB
+#   include <zlib.h>
+#endif
+
+using std::equal;
+using std::int64_t;
+using std::numeric_limits;
+using std::runtime_error;
+using std::size_t;
+using std::string;
+using std::uint32_t;
+using std::uint64_t;
+
+namespace swx
+{
+
+namespace
+{
+    // Identifies an archive, and the version of its layout.
+    char const k_archive_tag[] = "swxarc01";
+    auto const k_archive_tag_size = sizeof(k_archive_tag) - 1;
+
+    // Values of the byte following the tag.
+    char const k_uncompressed = 0;
+    char const k_compressed = 1;
+
+    void append_varint(string& p_buffer, uint64_t p_value)
+    {
+        while (p_value >= 0x80)
+        {
+            p_buffer.push_back(static_cast<char>((p_value & 0x7f) | 0x80));
+            p_value >>= 7;
+        }
+        p_buffer.push_back(static_cast<char>(p_value));
+    }
+
+    // Maps signed values to unsigned ones, such that values of small
+    // magnitude have short encodings whatever their sign.
+    uint64_t zigzag(int64_t p_value)
+    {
+        auto const sign = ((p_value < 0)? ~uint64_t(0): uint64_t(0));
+        return (static_cast<uint64_t>(p_value) << 1) ^ sign;
+    }
+
+    int64_t unzigzag(uint64_t p_value)
+    {
+        auto const sign = (((p_value & 1) != 0)? ~uint64_t(0): uint64_t(0));
+        return static_cast<int64_t>((p_value >> 1) ^ sign);
+    }
+
+    [[noreturn]] void throw_invalid()
+    {
+        throw runtime_error("Invalid archive.");
+    }
+
+    // Reads variable-length numbers successively from a range of bytes,
+    // throwing if the range is exhausted part-way through.
+    class VarintReader
+    {
+    public:
+        VarintReader(char const* p_begin, char const* p_end):
+            m_position(p_begin),
+            m_end(p_end)
+        {
+        }
+        uint64_t read()
+        {
+            uint64_t ret = 0;
+            for (unsigned int shift = 0; ; shift += 7)
+            {
+                if ((m_position == m_end) || (shift > 63))
+                {
+                    throw_invalid();
+                }
+                auto const byte = static_cast<unsigned char>(*m_position++);
+                ret |= static_cast<uint64_t>(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0)
+                {
+                    return ret;
+                }
+            }
+        }
+        string read_string()
+        {
+            auto const size = read();
+            if (size > remaining())
+            {
+                throw_invalid();
+            }
+            string ret(m_position, m_position + size);
+            m_position += size;
+            return ret;
+        }
+        uint64_t remaining() const
+        {
+            return m_end - m_position;
+        }
+    private:
+        char const* m_position;
+        char const* const m_end;
+    };
+
+    string encode_contents(ArchivedEntries const& p_entries)
+    {
+        assert (p_entries.seconds.size() == p_entries.activity_numbers.size());
+        string ret;
+        append_varint(ret, p_entries.activities.size());
+        for (auto const& activity: p_entries.activities)
+        {
+            append_varint(ret, activity.size());
+            ret.append(activity);
+        }
+        auto const num_entries = p_entries.seconds.size();
+        append_varint(ret, num_entries);
+        for (decltype(p_entries.seconds.size()) i = 0; i != num_entries; ++i)
+        {
+            auto const seconds = p_entries.seconds[i];
+            if (i == 0)
+            {
+                append_varint(ret, zigzag(seconds));
+            }
+            else
+            {
+                auto const previous = p_entries.seconds[i - 1];
+                assert (seconds >= previous);
+                append_varint
+                (   ret,
+                    static_cast<uint64_t>(seconds) - static_cast<uint64_t>(previous)
+                );
+            }
+            assert (p_entries.activity_numbers[i] < p_entries.activities.size());
+            append_varint(ret, p_entries.activity_numbers[i]);
+        }
+        return ret;
+    }
+
+    void decode_contents
+    (   char const* p_begin,
+        char const* p_end,
+        ArchivedEntries& p_entries
+    )
+    {
+        // Each activity name and each entry occupies at least one byte, which
+        // bounds the sizes that need be reserved for them.
+        VarintReader reader(p_begin, p_end);
+        auto const num_activities = reader.read();
+        if (num_activities > reader.remaining())
+        {
+            throw_invalid();
+        }
+        p_entries.activities.clear();
+        p_entries.activities.reserve(num_activities);
+        for (uint64_t i = 0; i != num_activities; ++i)
+        {
+            p_entries.activities.push_back(reader.read_string());
+        }
+        auto const num_entries = reader.read();
+        if (num_entries > reader.remaining())
+        {
+            throw_invalid();
+        }
+        p_entries.seconds.resize(num_entries);
+        p_entries.activity_numbers.resize(num_entries);
+        int64_t seconds = 0;
+        for (uint64_t i = 0; i != num_entries; ++i)
+        {
+            if (i == 0)
+            {
+                seconds = unzigzag(reader.read());
+            }
+            else
+            {
+                auto const delta = reader.read();
+                auto const max_delta =
+                    static_cast<uint64_t>(numeric_limits<int64_t>::max()) -
+                    static_cast<uint64_t>(seconds);
+                if (delta > max_delta)
+                {
+                    throw_invalid();
+                }
+                seconds = static_cast<int64_t>(static_cast<uint64_t>(seconds) + delta);
+            }
+            auto const activity_number = reader.read();
+            if (activity_number >= num_activities)
+            {
+                throw_invalid();
+            }
+            p_entries.seconds[i] = seconds;
+            p_entries.activity_numbers[i] = static_cast<uint32_t>(activity_number);
+        }
+        if (reader.remaining() != 0)
+        {
+            throw_invalid();
+        }
+    }
+
+}  // end anonymous namespace
+
+bool
+is_archive(char const* p_begin, char const* p_end)
+{
+    return
+    (   (static_cast<size_t>(p_end - p_begin) > k_archive_tag_size) &&
+        equal(k_archive_tag, k_archive_tag + k_archive_tag_size, p_begin)
+    );
+}
+
+bool
+is_compressed_archive(char const* p_begin, char const* p_end)
+{
+    return is_archive(p_begin, p_end) && (p_begin[k_archive_tag_size] == k_compressed);
+}
+
+bool
+archive_compression_is_available()
+{
+#   ifdef SWX_USE_ZLIB
+        return true;
+#   else
+        return false;
+#   endif
+}
+
+string
+encode_archive(ArchivedEntries const& p_entries, bool p_compress)
+{
+    string ret(k_archive_tag, k_archive_tag + k_archive_tag_size);
+    auto const contents = encode_contents(p_entries);
+    if (!p_compress)
+    {
+        ret.push_back(k_uncompressed);
+        ret.append(contents);
+        return ret;
+    }
+#   ifdef SWX_USE_ZLIB
+        ret.push_back(k_compressed);
+        append_varint(ret, contents.size());
+        auto compressed_size = compressBound(contents.size());
+        auto const header_size = ret.size();
+        ret.resize(header_size + compressed_size);
+        auto const result = compress2
+        (   reinterpret_cast<Bytef*>(&ret[header_size]),
+            &compressed_size,
+            reinterpret_cast<Bytef const*>(contents.data()),
+            contents.size(),
+            Z_BEST_COMPRESSION
+        );
+        if (result != Z_OK)
+        {
+            throw runtime_error("Could not compress archive.");
+        }
+        ret.resize(header_size + compressed_size);
+        return ret;
+#   else
+        throw runtime_error("This build does not support compression.");
+#   endif
+}
+
+void
+decode_archive(char const* p_begin, char const* p_end, ArchivedEntries& p_entries)
+{
+    if (!is_archive(p_begin, p_end))
+    {
+        throw_invalid();
+    }
+    auto const flag = p_begin[k_archive_tag_size];
+    auto const begin = p_begin + k_archive_tag_size + 1;
+    if (flag == k_uncompressed)
+    {
+        decode_contents(begin, p_end, p_entries);
+        return;
+    }
+    if (flag != k_compressed)
+    {
+        throw_invalid();
+    }
+#   ifdef SWX_USE_ZLIB
+        VarintReader reader(begin, p_end);
+        auto const size = reader.read();
+        auto const compressed_begin = p_end - reader.remaining();
+
+        // Compression by zlib never shrinks data by much more than a factor
+        // of a thousand, which bounds the size that need be allocated.
+        if (size / 2048 > reader.remaining())
+        {
+            throw_invalid();
+        }
+        string contents(size, '\0');
+        uLongf contents_size = size;
+        auto const result = uncompress
+        (   reinterpret_cast<Bytef*>(&contents[0]),
+            &contents_size,
+            reinterpret_cast<Bytef const*>(compressed_begin),
+            p_end - compressed_begin
+        );
+        if ((result != Z_OK) || (contents_size != size))
+        {
+            throw_invalid();
+        }
+        decode_contents(contents.data(), contents.data() + contents.size(), p_entries);
+#   else
+        throw runtime_error
+        (   "The archive is compressed, but this build does not support compression."
+        );
+#   endif
+}
+
+}  // namespace swx
@@ -32,7 +32,7 @@
 
 using std::cerr;
 using std::endl;
-using std::fputs;
+using std::fwrite;
 using std::rename;
 using std::runtime_error;
 using std::size_t;
@@ -97,7 +97,9 @@ AtomicWriter::~AtomicWriter()
 void
 AtomicWriter::append(string const& p_str)
 {
-    if (fputs(p_str.c_str(), m_tempfile) < 0)
+    // fwrite rather than fputs, so that p_str may contain null characters
+    auto const size = p_str.size();
+    if (fwrite(p_str.data(), 1, size, m_tempfile) != size)
     {
         throw runtime_error("Error appending to file.");
     }
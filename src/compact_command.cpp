@@ -0,0 +1,96 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "compact_command.hpp"
+#include "command.hpp"
+#include "config.hpp"
+#include "help_line.hpp"
+#include "time_log.hpp"
+#include <ostream>
+#include <string>
+#include <vector>
+
+using std::endl;
+using std::ostream;
+using std::string;
+using std::vector;
+
+namespace swx
+{
+
+CompactCommand::CompactCommand
+(   string const& p_command_word,
+    vector<string> const& p_aliases,
+    TimeLog& p_time_log
+):
+    Command
+    (   p_command_word,
+        p_aliases,
+        "Compact old segments of the time log",
+        vector<HelpLine>
+        {   HelpLine
+            (   "Rewrite the closed segments of the time log (see the log_segments "
+                    "configuration setting) in a compact binary form, which is "
+                    "quicker to load. Segments already compacted keep their "
+                    "compression, unless an option below is passed. The time log "
+                    "itself remains plain text"
+            )
+        },
+        false
+    ),
+    m_time_log(p_time_log)
+{
+    add_option
+    (   vector<string>{"z", "compress"},
+        "Also compress the segments, including any compacted already (ignored "
+            "if followed by -u)",
+        [this]() { m_compression = TimeLog::Compression::compressed; }
+    );
+    add_option
+    (   vector<string>{"u", "uncompress"},
+        "Leave the segments uncompressed, decompressing any compressed already "
+            "(ignored if followed by -z)",
+        [this]() { m_compression = TimeLog::Compression::uncompressed; }
+    );
+}
+
+CompactCommand::~CompactCommand() = default;
+
+Command::ErrorMessages
+CompactCommand::do_process
+(   Config const& p_config,
+    vector<string> const& p_ordinary_args,
+    ostream& p_ordinary_ostream
+)
+{
+    (void)p_config; (void)p_ordinary_args;  // silence compiler re. unused param
+    auto const count = m_time_log.compact(m_compression);
+    switch (count)
+    {
+    case 0:
+        p_ordinary_ostream << "No segments needed compacting." << endl;
+        break;
+    case 1:
+        p_ordinary_ostream << "1 segment compacted." << endl;
+        break;
+    default:
+        p_ordinary_ostream << count << " segments compacted." << endl;
+        break;
+    }
+    return ErrorMessages();
+}
+
+}  // namespace swx
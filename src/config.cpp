@@ -181,6 +181,18 @@ Config::path_to_log() const
     return get_option_value<string>("path_to_log");
 }
 
+bool
+Config::use_log_index() const
+{
+    return get_option_value<bool>("use_log_index");
+}
+
+string
+Config::log_segments() const
+{
+    return get_option_value<string>("log_segments");
+}
+
 string
 Config::summary() const
 {
@@ -352,6 +364,35 @@ Config::set_defaults()
             "Path to file in which time log is recorded."
         )
     );
+    unchecked_set_option
+    (   "use_log_index",
+        OptionData
+        (   "0",
+            "If set to 1, a binary index of the time log is kept in a file "
+            "alongside it, at path_to_log with \".index\" appended. This "
+            "spares the log from being parsed afresh each time the program "
+            "is run. The index is rebuilt automatically whenever it is found "
+            "to be out of date with the log. Set to 0 (the default) to "
+            "disable."
+        )
+    );
+    unchecked_set_option
+    (   "log_segments",
+        OptionData
+        (   "none",
+            "If set to \"yearly\" or \"monthly\", then once a year or month "
+            "has passed, its entries are moved out of the time log into a "
+            "segment file of their own, at path_to_log with the year or month "
+            "appended (e.g. \".2023\" or \".2023-04\"), and recorded in a "
+            "manifest at path_to_log with \".manifest\" appended. Segment "
+            "files are not changed thereafter, except by the rename and "
+            "compact commands; "
+            "and queries that begin within the time log itself do not read "
+            "them at all. Note the edit command edits only the time log "
+            "itself, not its segments. Set to \"none\" to stop creating new "
+            "segments; existing segments continue to form part of the log."
+        )
+    );
 }
 
 void
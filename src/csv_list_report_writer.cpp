@@ -21,20 +21,15 @@
 #include "time_point.hpp"
 #include <iomanip>
 #include <ostream>
-#include <vector>
 
 using std::setprecision;
 using std::ostream;
-using std::vector;
 
 namespace swx
 {
 
-CsvListReportWriter::CsvListReportWriter
-(   vector<Stint> const& p_stints,
-    Options const& p_options
-):
-    ListReportWriter(p_stints, p_options)
+CsvListReportWriter::CsvListReportWriter(Options const& p_options):
+    ListReportWriter(p_options)
 {
 }
 
@@ -49,9 +44,9 @@ CsvListReportWriter::do_process_stint(ostream& p_os, Stint const& p_stint)
         p_os << setprecision(output_precision());
         auto const interval = p_stint.interval();
         CsvRow row;
-        row << time_point_to_stamp(interval.beginning(), time_format(), formatted_buf_len())
-            << time_point_to_stamp(interval.ending(), time_format(), formatted_buf_len())
-            << round_hours(interval)
+        row << time_stamp(interval.beginning());
+        row << time_stamp(interval.ending());
+        row << round_hours(interval)
             << p_stint.activity();
         p_os << row;
     }
@@ -23,22 +23,19 @@
 #include <map>
 #include <ostream>
 #include <string>
-#include <vector>
 
 using std::map;
 using std::ostream;
 using std::string;
-using std::vector;
 
 namespace swx
 {
 
 CsvSummaryReportWriter::CsvSummaryReportWriter
-(   vector<Stint> const& p_stints,
-    Options const& p_options,
+(   Options const& p_options,
     Flags::Type p_flags
 ):
-    SummaryReportWriter(p_stints, p_options, p_flags)
+    SummaryReportWriter(p_options, p_flags)
 {
 }
 
@@ -50,26 +47,11 @@ CsvSummaryReportWriter::do_write_summary
     map<string, ActivityStats> const& p_activity_stats_map
 )
 {
-    auto const add_time_info = [this](CsvRow& row, ActivityStats const& info)
-    {
-        row << seconds_to_rounded_hours(info.seconds);
-        if (has_flag(Flags::include_beginning))
-        {
-            row << time_point_to_stamp(info.beginning, time_format(), formatted_buf_len());
-        }
-        if (has_flag(Flags::include_ending))
-        {
-            row << time_point_to_stamp(info.ending, time_format(), formatted_buf_len());
-        }
-    };
-
     if (has_flag(Flags::succinct))
     {
         ActivityStats total_info;
         for (auto const& pair: p_activity_stats_map) total_info += pair.second;
-        CsvRow row;
-        add_time_info(row, total_info);
-        p_os << row;
+        do_write_total(p_os, total_info);
     }
     else
     {
@@ -85,4 +67,26 @@ CsvSummaryReportWriter::do_write_summary
     }
 }
 
+void
+CsvSummaryReportWriter::do_write_total(ostream& p_os, ActivityStats const& p_total)
+{
+    CsvRow row;
+    add_time_info(row, p_total);
+    p_os << row;
+}
+
+void
+CsvSummaryReportWriter::add_time_info(CsvRow& p_row, ActivityStats const& p_info) const
+{
+    p_row << seconds_to_rounded_hours(p_info.seconds);
+    if (has_flag(Flags::include_beginning))
+    {
+        p_row << time_stamp(p_info.beginning);
+    }
+    if (has_flag(Flags::include_ending))
+    {
+        p_row << time_stamp(p_info.ending);
+    }
+}
+
 }  // namespace swx
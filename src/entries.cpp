@@ -0,0 +1,228 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "entries.hpp"
+#include "time_point.hpp"
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+using std::min;
+using std::vector;
+
+namespace swx
+{
+
+namespace
+{
+    // The total time spent on an activity over a range of entries is found
+    // from a running total over its posting list, if it has at least this
+    // many entries; otherwise by summing the durations of its stints.
+    Entries::Index const k_cumulative_seconds_threshold = 64;
+
+}  // end anonymous namespace
+
+void
+Entries::push_back(ActivityId p_activity_id, EpochSeconds p_seconds)
+{
+    discard_postings();
+    m_seconds.push_back(p_seconds);
+    m_activity_ids.push_back(p_activity_id);
+}
+
+void
+Entries::pop_back()
+{
+    discard_postings();
+    m_seconds.pop_back();
+    m_activity_ids.pop_back();
+    m_num_unmodified = min(m_num_unmodified, m_seconds.size());
+}
+
+void
+Entries::truncate(Index p_size)
+{
+    assert (p_size <= size());
+    discard_postings();
+    m_seconds.resize(p_size);
+    m_activity_ids.resize(p_size);
+    m_num_unmodified = min(m_num_unmodified, p_size);
+}
+
+void
+Entries::set
+(   Index p_index,
+    ActivityId p_activity_id,
+    EpochSeconds p_seconds
+)
+{
+    discard_postings();
+    m_num_unmodified = min(m_num_unmodified, p_index);
+    m_seconds[p_index] = p_seconds;
+    m_activity_ids[p_index] = p_activity_id;
+}
+
+void
+Entries::reserve(Index p_num)
+{
+    m_seconds.reserve(p_num);
+    m_activity_ids.reserve(p_num);
+}
+
+void
+Entries::clear()
+{
+    discard_postings();
+    m_num_unmodified = 0;
+    m_seconds.clear();
+    m_activity_ids.clear();
+}
+
+void
+Entries::swap(Entries& p_other)
+{
+    m_seconds.swap(p_other.m_seconds);
+    m_activity_ids.swap(p_other.m_activity_ids);
+    m_postings.swap(p_other.m_postings);
+    m_cumulative_seconds.swap(p_other.m_cumulative_seconds);
+    std::swap(m_postings_valid, p_other.m_postings_valid);
+    m_num_unmodified = p_other.m_num_unmodified = 0;
+}
+
+void
+Entries::append(Entries const& p_other, Index p_begin)
+{
+    discard_postings();
+    assert (p_begin <= p_other.size());
+    m_seconds.insert
+    (   m_seconds.end(),
+        p_other.m_seconds.begin() + p_begin,
+        p_other.m_seconds.end()
+    );
+    m_activity_ids.insert
+    (   m_activity_ids.end(),
+        p_other.m_activity_ids.begin() + p_begin,
+        p_other.m_activity_ids.end()
+    );
+}
+
+Entries::Index
+Entries::lower_bound(EpochSeconds p_seconds) const
+{
+    auto const it = std::lower_bound(m_seconds.begin(), m_seconds.end(), p_seconds);
+    return it - m_seconds.begin();
+}
+
+Entries::Index
+Entries::upper_bound(EpochSeconds p_seconds) const
+{
+    auto const it = std::upper_bound(m_seconds.begin(), m_seconds.end(), p_seconds);
+    return it - m_seconds.begin();
+}
+
+Entries::PostingList const&
+Entries::postings(ActivityId p_activity_id)
+{
+    if (!m_postings_valid)
+    {
+        m_postings.clear();
+        for (Index i = 0; i != m_activity_ids.size(); ++i)
+        {
+            auto const activity_id = m_activity_ids[i];
+            if (activity_id >= m_postings.size())
+            {
+                m_postings.resize(activity_id + 1);
+            }
+            m_postings[activity_id].push_back(i);
+        }
+        m_postings_valid = true;
+    }
+    if (p_activity_id >= m_postings.size())
+    {
+        m_postings.resize(p_activity_id + 1);
+    }
+    return m_postings[p_activity_id];
+}
+
+void
+Entries::discard_postings()
+{
+    if (m_postings_valid)
+    {
+        m_postings.clear();
+        m_cumulative_seconds.clear();
+        m_postings_valid = false;
+    }
+}
+
+EpochSeconds
+Entries::activity_seconds
+(   ActivityId p_activity_id,
+    Index p_begin,
+    Index p_end
+)
+{
+    assert (p_begin <= p_end);
+    assert (p_end < size());
+    auto const& postings = this->postings(p_activity_id);
+    auto const b = std::lower_bound(postings.begin(), postings.end(), p_begin);
+    auto const f = std::lower_bound(b, postings.end(), p_end);
+    if (postings.size() < k_cumulative_seconds_threshold)
+    {
+        EpochSeconds ret = 0;
+        for (auto it = b; it != f; ++it)
+        {
+            ret += m_seconds[*it + 1] - m_seconds[*it];
+        }
+        return ret;
+    }
+    if (p_activity_id >= m_cumulative_seconds.size())
+    {
+        m_cumulative_seconds.resize(p_activity_id + 1);
+    }
+    auto& cumulative_seconds = m_cumulative_seconds[p_activity_id];
+    if (cumulative_seconds.empty())
+    {
+        cumulative_seconds.reserve(postings.size() + 1);
+        EpochSeconds total = 0;
+        cumulative_seconds.push_back(total);
+        for (auto const index: postings)
+        {
+            if (index + 1 != m_seconds.size())
+            {
+                total += m_seconds[index + 1] - m_seconds[index];
+            }
+            cumulative_seconds.push_back(total);
+        }
+    }
+    return
+        cumulative_seconds[f - postings.begin()] -
+        cumulative_seconds[b - postings.begin()];
+}
+
+Entries::Index
+Entries::num_unmodified() const
+{
+    return m_num_unmodified;
+}
+
+void
+Entries::mark_unmodified()
+{
+    m_num_unmodified = size();
+}
+
+}  // namespace swx
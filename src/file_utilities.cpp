@@ -16,9 +16,14 @@
 
 #include "file_utilities.hpp"
 #include <cerrno>
+#include <stdexcept>
 #include <string>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
 #include <unistd.h>
 
+using std::runtime_error;
 using std::string;
 
 namespace swx
@@ -33,4 +38,78 @@ file_exists_at(string const& p_filepath)
         (errno != ENOENT);
 }
 
+FileSignature::FileSignature():
+    exists(false),
+    device(0),
+    inode(0),
+    size(0),
+    modification_seconds(0),
+    modification_nanoseconds(0)
+{
+}
+
+bool
+operator==(FileSignature const& lhs, FileSignature const& rhs)
+{
+    return
+        (lhs.exists == rhs.exists) &&
+        (lhs.device == rhs.device) &&
+        (lhs.inode == rhs.inode) &&
+        (lhs.size == rhs.size) &&
+        (lhs.modification_seconds == rhs.modification_seconds) &&
+        (lhs.modification_nanoseconds == rhs.modification_nanoseconds);
+}
+
+bool
+operator!=(FileSignature const& lhs, FileSignature const& rhs)
+{
+    return !(lhs == rhs);
+}
+
+FileSignature
+file_signature(string const& p_filepath)
+{
+    // non-portable
+    FileSignature ret;
+    struct stat status;
+    if (stat(p_filepath.c_str(), &status) != 0)
+    {
+        if (errno == ENOENT)
+        {
+            return ret;
+        }
+        throw runtime_error("Could not examine file at " + p_filepath);
+    }
+    ret.exists = true;
+    ret.device = status.st_dev;
+    ret.inode = status.st_ino;
+    ret.size = status.st_size;
+    ret.modification_seconds = status.st_mtim.tv_sec;
+    ret.modification_nanoseconds = status.st_mtim.tv_nsec;
+    return ret;
+}
+
+void
+sync_directory_of(string const& p_filepath)
+{
+    // non-portable
+    auto const separator_pos = p_filepath.rfind('/');
+    string const directory =
+    (   (separator_pos == string::npos) ?
+        string(".") :
+        p_filepath.substr(0, (separator_pos == 0) ? 1 : separator_pos)
+    );
+    int const descriptor = open(directory.c_str(), O_RDONLY);
+    if (descriptor == -1)
+    {
+        throw runtime_error("Could not open directory " + directory);
+    }
+    auto const sync_result = fsync(descriptor);
+    close(descriptor);
+    if (sync_result != 0)
+    {
+        throw runtime_error("Could not sync directory " + directory);
+    }
+}
+
 }  // namespace swx
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "filter_memo.hpp"
+#include "activity_filter.hpp"
+#include "activity_registry.hpp"
+#include "activity_trie.hpp"
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+using std::fill;
+using std::vector;
+
+namespace swx
+{
+
+FilterMemo::FilterMemo
+(   ActivityTable const& p_activity_table,
+    ActivityTrie const& p_activity_trie,
+    ActivityFilter const& p_activity_filter
+):
+    m_activity_table(p_activity_table),
+    m_activity_trie(p_activity_trie),
+    m_activity_filter(p_activity_filter),
+    m_results(p_activity_table.size(), Result::unknown)
+{
+}
+
+bool
+FilterMemo::matches(ActivityId p_activity_id)
+{
+    assert (p_activity_id < m_results.size());
+    auto& result = m_results[p_activity_id];
+    if (result == Result::unknown)
+    {
+        auto const& activity = *m_activity_table[p_activity_id].name;
+        result = (m_activity_filter.matches(activity)? Result::yes: Result::no);
+    }
+    return result == Result::yes;
+}
+
+vector<FilterMemo::ActivityId>
+FilterMemo::matching_activity_ids()
+{
+    vector<ActivityId> ret;
+    auto const* const root = m_activity_filter.subactivity_root();
+    if (root)
+    {
+        // The filter need not be consulted at all.
+        m_activity_trie.find_subactivities(*root, ret);
+        fill(m_results.begin(), m_results.end(), Result::no);
+        for (auto const activity_id: ret) m_results[activity_id] = Result::yes;
+        return ret;
+    }
+    for (ActivityId i = 0; i != m_activity_table.size(); ++i)
+    {
+        if ((m_activity_table[i].reference_count != 0) && matches(i))
+        {
+            ret.push_back(i);
+        }
+    }
+    return ret;
+}
+
+}  // namespace swx
@@ -0,0 +1,35 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hash.hpp"
+
+namespace swx
+{
+
+unsigned long long
+hash_bytes(char const* p_begin, char const* p_end, unsigned long long p_seed)
+{
+    unsigned long long const prime = 1099511628211ULL;
+    auto ret = p_seed;
+    for ( ; p_begin != p_end; ++p_begin)
+    {
+        ret ^= static_cast<unsigned char>(*p_begin);
+        ret *= prime;
+    }
+    return ret;
+}
+
+}  // namespace swx
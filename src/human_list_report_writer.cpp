@@ -24,7 +24,6 @@
 #include <iostream>
 #include <ostream>
 #include <string>
-#include <vector>
 
 using std::endl;
 using std::fixed;
@@ -33,16 +32,12 @@ using std::right;
 using std::setprecision;
 using std::setw;
 using std::string;
-using std::vector;
 
 namespace swx
 {
 
-HumanListReportWriter::HumanListReportWriter
-(   vector<Stint> const& p_stints,
-    Options const& p_options
-):
-    ListReportWriter(p_stints, p_options)
+HumanListReportWriter::HumanListReportWriter(Options const& p_options):
+    ListReportWriter(p_options)
 {
 }
 
@@ -60,8 +55,8 @@ HumanListReportWriter::do_process_stint(ostream& p_os, Stint const& p_stint)
     {
         StreamFlagGuard guard(p_os);
         auto const interval = p_stint.interval();
-        p_os << time_point_to_stamp(interval.beginning(), time_format(), formatted_buf_len()) << "  ";
-        p_os << time_point_to_stamp(interval.ending(), time_format(), formatted_buf_len()) << "  ";
+        p_os << time_stamp(interval.beginning()) << "  ";
+        p_os << time_stamp(interval.ending()) << "  ";
         p_os << fixed
              << setprecision(output_precision())
              << right
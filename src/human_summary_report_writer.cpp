@@ -32,7 +32,6 @@
 #include <ostream>
 #include <stdexcept>
 #include <string>
-#include <vector>
 
 using std::endl;
 using std::fixed;
@@ -45,17 +44,15 @@ using std::runtime_error;
 using std::setprecision;
 using std::setw;
 using std::string;
-using std::vector;
 
 namespace swx
 {
 
 HumanSummaryReportWriter::HumanSummaryReportWriter
-(   vector<Stint> const& p_stints,
-    Options const& p_options,
+(   Options const& p_options,
     Flags::Type p_flags
 ):
-    SummaryReportWriter(p_stints, p_options, p_flags)
+    SummaryReportWriter(p_options, p_flags)
 {
 }
 
@@ -67,9 +64,20 @@ HumanSummaryReportWriter::do_write_summary
     map<string, ActivityStats> const& p_activity_stats_map
 )
 {
-    if (has_flag(Flags::succinct)) write_succinct_summary(p_os, p_activity_stats_map);
-    else if (has_flag(Flags::verbose)) write_flat_summary(p_os, p_activity_stats_map);
-    else write_tree_summary(p_os, p_activity_stats_map);
+    if (has_flag(Flags::succinct))
+    {
+        ActivityStats total_info;
+        for (auto const& pair: p_activity_stats_map) total_info += pair.second;
+        do_write_total(p_os, total_info);
+    }
+    else if (has_flag(Flags::verbose))
+    {
+        write_flat_summary(p_os, p_activity_stats_map);
+    }
+    else
+    {
+        write_tree_summary(p_os, p_activity_stats_map);
+    }
 }
 
 void
@@ -94,31 +102,24 @@ HumanSummaryReportWriter::print_label_and_rounded_hours
 
     if (p_beginning != nullptr)
     {
-        p_os << "    "
-             << time_point_to_stamp(*p_beginning, time_format(), formatted_buf_len());
+        p_os << "    " << time_stamp(*p_beginning);
     }
     if (p_ending != nullptr)
     {
-        p_os << "    "
-             << time_point_to_stamp(*p_ending, time_format(), formatted_buf_len());
+        p_os << "    " << time_stamp(*p_ending);
     }
     p_os << endl;
 }
 
 void
-HumanSummaryReportWriter::write_succinct_summary
-(   ostream& p_os,
-    map<string, ActivityStats> const& p_activity_stats_map
-)
+HumanSummaryReportWriter::do_write_total(ostream& p_os, ActivityStats const& p_total)
 {
-    ActivityStats total_info;
-    for (auto const& pair: p_activity_stats_map) total_info += pair.second;
     print_label_and_rounded_hours
     (   p_os,
         string(),
-        total_info.seconds,
-        (has_flag(Flags::include_beginning) ?  &(total_info.beginning) : nullptr),
-        (has_flag(Flags::include_ending) ? &(total_info.ending) : nullptr)
+        p_total.seconds,
+        (has_flag(Flags::include_beginning) ?  &(p_total.beginning) : nullptr),
+        (has_flag(Flags::include_ending) ? &(p_total.ending) : nullptr)
     );
 }
 
@@ -174,7 +175,7 @@ HumanSummaryReportWriter::write_tree_summary
         p_os << endl;
         return;
     }
-    ActivityTree const tree(p_activity_stats_map);
+    ActivityTree const tree(p_activity_stats_map, depth());
     ActivityTree::PrintNode const print_node = [this]
     (   ostream& p_ostream,
         unsigned int p_node_depth,
@@ -195,15 +196,11 @@ HumanSummaryReportWriter::write_tree_summary
             guard.reset();
             if (has_flag(Flags::include_beginning))
             {
-                auto const& b = p_stats.beginning;
-                auto const s = time_point_to_stamp(b, time_format(), formatted_buf_len());
-                p_ostream << "[ " << s << " ]";
+                p_ostream << "[ " << time_stamp(p_stats.beginning) << " ]";
             }
             if (has_flag(Flags::include_ending))
             {
-                auto const& e = p_stats.ending;
-                auto const s = time_point_to_stamp(e, time_format(), formatted_buf_len());
-                p_ostream << "[ " << s << " ]";
+                p_ostream << "[ " << time_stamp(p_stats.ending) << " ]";
             }
             p_ostream << ' ' << p_node_label << endl;
         }
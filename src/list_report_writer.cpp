@@ -17,18 +17,13 @@
 #include "list_report_writer.hpp"
 #include "report_writer.hpp"
 #include "stint.hpp"
-#include <vector>
 
-using std::vector;
 
 namespace swx
 {
 
-ListReportWriter::ListReportWriter
-(   vector<Stint> const& p_stints,
-    Options const& p_options
-):
-    ReportWriter(p_stints, p_options)
+ListReportWriter::ListReportWriter(Options const& p_options):
+    ReportWriter(p_options)
 {
 }
 
@@ -0,0 +1,333 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "log_index.hpp"
+#include "activity_registry.hpp"
+#include "entries.hpp"
+#include "hash.hpp"
+#include "index_reader.hpp"
+#include "rollup.hpp"
+#include "time_point.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::equal;
+using std::string;
+using std::vector;
+
+namespace swx
+{
+
+namespace
+{
+    // Identifies an index file, and the version of its layout.
+    char const k_index_tag[] = "swxidx04";
+    auto const k_index_tag_size = sizeof(k_index_tag) - 1;
+
+    // The activity of an entry, or of a row of the rollup, is recorded as
+    // its position among the activity names.
+    using IndexActivityNumber = std::uint32_t;
+
+}  // end anonymous namespace
+
+LogIndexReader::LogIndexReader(char const* p_begin, char const* p_end):
+    m_reader(p_begin, p_end),
+    m_size(p_end - p_begin)
+{
+}
+
+bool
+LogIndexReader::read_header(LogIndexHeader& p_header)
+{
+    auto const tag = m_reader.position();
+    if
+    (   (m_size < k_index_tag_size) ||
+        !equal(k_index_tag, k_index_tag + k_index_tag_size, tag) ||
+        !m_reader.skip(k_index_tag_size)
+    )
+    {
+        return false;
+    }
+    auto& signature = p_header.file_signature;
+    IndexField modification_seconds = 0;
+    IndexField modification_nanoseconds = 0;
+    IndexField file_ends_with_newline = 0;
+    IndexField num_segments = 0;
+    if
+    (   !m_reader.read(signature.device) ||
+        !m_reader.read(signature.inode) ||
+        !m_reader.read(signature.size) ||
+        !m_reader.read(modification_seconds) ||
+        !m_reader.read(modification_nanoseconds) ||
+        !m_reader.read(p_header.file_tail_hash) ||
+        !m_reader.read(p_header.settings_hash) ||
+        !m_reader.read(p_header.last_saved_entry_offset) ||
+        !m_reader.read(file_ends_with_newline) ||
+        !m_reader.read(m_num_activities) ||
+        !m_reader.read(m_num_entries) ||
+        !m_reader.read(p_header.manifest_hash) ||
+        !m_reader.read(num_segments) ||
+        (num_segments > m_size / sizeof(IndexField)) ||
+        (m_num_activities > m_size / sizeof(IndexField)) ||
+        (m_num_entries > m_size / (sizeof(EpochSeconds) + sizeof(IndexActivityNumber)))
+    )
+    {
+        return false;
+    }
+    signature.exists = true;
+    signature.modification_seconds = static_cast<long long>(modification_seconds);
+    signature.modification_nanoseconds =
+        static_cast<long long>(modification_nanoseconds);
+    p_header.file_ends_with_newline = (file_ends_with_newline != 0);
+
+    // Read the index of the entry at which each closed segment ends.
+    Entries::Index num_archived_entries = 0;
+    p_header.segment_ends.clear();
+    p_header.segment_ends.reserve(num_segments);
+    for (IndexField i = 0; i != num_segments; ++i)
+    {
+        IndexField end = 0;
+        if
+        (   !m_reader.read(end) ||
+            (end <= num_archived_entries) ||
+            (end > m_num_entries)
+        )
+        {
+            return false;
+        }
+        p_header.segment_ends.push_back(num_archived_entries = end);
+    }
+
+    // The log file is empty if and only if all the entries are in segments;
+    // and otherwise the last entry must begin within it.
+    auto const size = signature.size;
+    return
+    (   ((m_num_entries == num_archived_entries) == (size == 0)) &&
+        ((size == 0) || (p_header.last_saved_entry_offset < size))
+    );
+}
+
+bool
+LogIndexReader::read_body
+(   vector<string>& p_activities,
+    Entries& p_entries,
+    vector<RollupDay>& p_rollup
+)
+{
+    assert (p_activities.empty());
+    assert (p_entries.empty());
+    assert (p_rollup.empty());
+    p_activities.resize(m_num_activities);
+    for (auto& activity: p_activities)
+    {
+        IndexField activity_size = 0;
+        if (!m_reader.read(activity_size) || !m_reader.read(activity, activity_size))
+        {
+            return false;
+        }
+    }
+    p_entries.reserve(m_num_entries);
+    for (IndexField i = 0; i != m_num_entries; ++i)
+    {
+        EpochSeconds seconds = 0;
+        IndexActivityNumber activity_id = 0;
+        if
+        (   !m_reader.read(seconds) ||
+            !m_reader.read(activity_id) ||
+            (activity_id >= m_num_activities)
+        )
+        {
+            return false;
+        }
+        if (!p_entries.empty())
+        {
+            auto const last = p_entries.size() - 1;
+            if
+            (   (p_entries.activity_id(last) == activity_id) ||
+                (p_entries.seconds(last) > seconds)
+            )
+            {
+                return false;
+            }
+        }
+        p_entries.push_back(activity_id, seconds);
+    }
+
+    // The rollup is held in a section of its own, following the entries,
+    // with its size and a hash of its contents. As it is derived wholly from
+    // the entries, a rollup section that is invalid does not invalidate the
+    // rest of the index.
+    IndexField rollup_size = 0;
+    IndexField rollup_hash = 0;
+    if (!m_reader.read(rollup_size) || !m_reader.read(rollup_hash))
+    {
+        return false;
+    }
+    auto const rollup_begin = m_reader.position();
+    if (!m_reader.skip(rollup_size))
+    {
+        return false;
+    }
+    auto const rollup_end = m_reader.position();
+    if
+    (   (hash_bytes(rollup_begin, rollup_end) != rollup_hash) ||
+        !read_rollup_section(rollup_begin, rollup_end, p_entries, p_rollup)
+    )
+    {
+        p_rollup.clear();
+    }
+    return m_reader.exhausted();
+}
+
+bool
+LogIndexReader::read_rollup_section
+(   char const* p_begin,
+    char const* p_end,
+    Entries const& p_entries,
+    vector<RollupDay>& p_rollup
+) const
+{
+    // The rollup must lie within the span of the entries.
+    IndexReader reader(p_begin, p_end);
+    auto const num_entries = p_entries.size();
+    IndexField num_days = 0;
+    if (!reader.read(num_days) || ((num_days != 0) && (num_entries == 0)))
+    {
+        return false;
+    }
+    auto const first_seconds = (num_entries? p_entries.seconds(0): 0);
+    auto const last_seconds = (num_entries? p_entries.seconds(num_entries - 1): 0);
+    for (IndexField i = 0; i != num_days; ++i)
+    {
+        RollupDay day;
+        IndexField has_boundary_stints = 0;
+        IndexField num_rows = 0;
+        if
+        (   !reader.read(day.begin) ||
+            !reader.read(day.end) ||
+            !reader.read(has_boundary_stints) ||
+            !reader.read(num_rows) ||
+            (day.end <= day.begin) ||
+            (day.begin < (p_rollup.empty()? first_seconds: p_rollup.back().end)) ||
+            (day.end > last_seconds) ||
+            (num_rows > m_num_activities)
+        )
+        {
+            return false;
+        }
+        day.has_boundary_stints = (has_boundary_stints != 0);
+        day.rows.resize(num_rows);
+        for (auto& row: day.rows)
+        {
+            IndexActivityNumber activity_id = 0;
+            if
+            (   !reader.read(activity_id) ||
+                !reader.read(row.seconds) ||
+                !reader.read(row.beginning) ||
+                !reader.read(row.ending) ||
+                (activity_id >= m_num_activities)
+            )
+            {
+                return false;
+            }
+            row.activity_id = activity_id;
+        }
+        p_rollup.push_back(std::move(day));
+    }
+    return reader.exhausted();
+}
+
+string
+encode_log_index
+(   LogIndexHeader const& p_header,
+    ActivityTable const& p_activity_table,
+    Entries const& p_entries,
+    vector<RollupDay> const& p_rollup
+)
+{
+    // Number the activities in use by their order in the activity table.
+    vector<IndexActivityNumber> activity_numbers(p_activity_table.size());
+    IndexActivityNumber num_activities = 0;
+    for (Entries::ActivityId i = 0; i != p_activity_table.size(); ++i)
+    {
+        if (p_activity_table[i].reference_count != 0)
+        {
+            activity_numbers[i] = num_activities++;
+        }
+    }
+
+    auto const& signature = p_header.file_signature;
+    string buffer(k_index_tag, k_index_tag + k_index_tag_size);
+    append_value<IndexField>(buffer, signature.device);
+    append_value<IndexField>(buffer, signature.inode);
+    append_value<IndexField>(buffer, signature.size);
+    append_value<IndexField>(buffer, signature.modification_seconds);
+    append_value<IndexField>(buffer, signature.modification_nanoseconds);
+    append_value<IndexField>(buffer, p_header.file_tail_hash);
+    append_value<IndexField>(buffer, p_header.settings_hash);
+    append_value<IndexField>(buffer, p_header.last_saved_entry_offset);
+    append_value<IndexField>(buffer, p_header.file_ends_with_newline);
+    append_value<IndexField>(buffer, num_activities);
+    append_value<IndexField>(buffer, p_entries.size());
+    append_value<IndexField>(buffer, p_header.manifest_hash);
+    append_value<IndexField>(buffer, p_header.segment_ends.size());
+    for (auto const end: p_header.segment_ends)
+    {
+        append_value<IndexField>(buffer, end);
+    }
+    for (auto const& record: p_activity_table)
+    {
+        if (record.reference_count != 0)
+        {
+            append_value<IndexField>(buffer, record.name->size());
+            buffer.append(*record.name);
+        }
+    }
+    for (Entries::Index i = 0; i != p_entries.size(); ++i)
+    {
+        append_value(buffer, p_entries.seconds(i));
+        append_value(buffer, activity_numbers[p_entries.activity_id(i)]);
+    }
+
+    string rollup;
+    append_value<IndexField>(rollup, p_rollup.size());
+    for (auto const& day: p_rollup)
+    {
+        append_value(rollup, day.begin);
+        append_value(rollup, day.end);
+        append_value<IndexField>(rollup, day.has_boundary_stints);
+        append_value<IndexField>(rollup, day.rows.size());
+        for (auto const& row: day.rows)
+        {
+            assert (p_activity_table[row.activity_id].reference_count != 0);
+            append_value(rollup, activity_numbers[row.activity_id]);
+            append_value(rollup, row.seconds);
+            append_value(rollup, row.beginning);
+            append_value(rollup, row.ending);
+        }
+    }
+    auto const rollup_hash = hash_bytes(rollup.data(), rollup.data() + rollup.size());
+    append_value<IndexField>(buffer, rollup.size());
+    append_value<IndexField>(buffer, rollup_hash);
+    buffer.append(rollup);
+    return buffer;
+}
+
+}  // namespace swx
@@ -0,0 +1,322 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "log_text_parser.hpp"
+#include "archive.hpp"
+#include "mapped_file.hpp"
+#include "stream_utilities.hpp"
+#include "time_point.hpp"
+#include "time_stamp_parser.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using std::exception;
+using std::max;
+using std::min;
+using std::ostringstream;
+using std::runtime_error;
+using std::size_t;
+using std::string;
+using std::system_error;
+using std::thread;
+using std::unordered_map;
+using std::vector;
+
+namespace swx
+{
+
+namespace
+{
+    // When a stretch of the log at least twice this long is parsed, it is
+    // split into chunks of at least this size, which are parsed concurrently
+    // if there are processors to spare.
+    unsigned long long const k_min_chunk_size = 1 << 20;
+
+    // Set by LogTextParser::set_chunking, in place of the number of
+    // processors and k_min_chunk_size, unless num_processors_override is 0.
+    unsigned int num_processors_override = 0;
+    unsigned long long min_chunk_size_override = 0;
+
+    bool is_space(char p_char)
+    {
+        return isspace(static_cast<unsigned char>(p_char));
+    }
+
+}  // end anonymous namespace
+
+unsigned long long
+LogTextParser::num_chunks(unsigned long long p_size)
+{
+    if (num_processors_override != 0)
+    {
+        return min<unsigned long long>
+        (   num_processors_override,
+            p_size / min_chunk_size_override
+        );
+    }
+    return min<unsigned long long>
+    (   thread::hardware_concurrency(),
+        p_size / k_min_chunk_size
+    );
+}
+
+void
+LogTextParser::set_chunking
+(   unsigned int p_num_processors,
+    unsigned long long p_min_chunk_size
+)
+{
+    assert ((p_num_processors == 0) || (p_min_chunk_size != 0));
+    num_processors_override = p_num_processors;
+    min_chunk_size_override = p_min_chunk_size;
+}
+
+LogTextParser::LogTextParser
+(   string const& p_time_format,
+    unsigned int p_time_stamp_length
+):
+    m_time_format(p_time_format),
+    m_time_stamp_length(p_time_stamp_length)
+{
+}
+
+TimePoint
+LogTextParser::parse_line
+(   TimeStampParser& p_parser,
+    MappedFile const& p_file,
+    char const* p_begin,
+    char const* p_end,
+    string& p_activity
+) const
+{
+    if (static_cast<size_t>(p_end - p_begin) < m_time_stamp_length)
+    {
+        ostringstream oss;
+        enable_exceptions(oss);
+        oss << "Error parsing the time log at line "
+            << line_number_at(p_file, p_begin) << '.';
+        throw runtime_error(oss.str());
+    }
+    auto const time_stamp_end = p_begin + m_time_stamp_length;
+    assert (time_stamp_end > p_begin);
+    auto const time_point = p_parser.parse(p_begin, time_stamp_end);
+
+    // Trim whitespace in place, then copy only the activity name itself;
+    // assign reuses p_activity's storage where possible.
+    auto activity_begin = time_stamp_end;
+    auto activity_end = p_end;
+    while ((activity_begin != activity_end) && is_space(*activity_begin))
+    {
+        ++activity_begin;
+    }
+    while ((activity_end != activity_begin) && is_space(*(activity_end - 1)))
+    {
+        --activity_end;
+    }
+    p_activity.assign(activity_begin, activity_end);
+    return time_point;
+}
+
+vector<ParsedChunk>
+LogTextParser::parse_chunks
+(   MappedFile const& p_file,
+    char const* p_begin,
+    char const* p_end,
+    unsigned long long p_num_chunks,
+    long long p_previous_offset
+) const
+{
+    assert (p_num_chunks > 1);
+
+    // Divide the lines into chunks of roughly equal size.
+    vector<ParsedChunk> chunks(p_num_chunks);
+    auto const chunk_size = (p_end - p_begin) / p_num_chunks;
+    auto chunk_begin = p_begin;
+    for (decltype(chunks.size()) i = 0; i != chunks.size(); ++i)
+    {
+        auto& chunk = chunks[i];
+        chunk.begin = chunk_begin;
+        chunk.end = p_end;
+        if (i + 1 != chunks.size())
+        {
+            auto const target = max(chunk_begin, p_begin + (i + 1) * chunk_size);
+            auto const newline = static_cast<char const*>
+            (   memchr(target, '\n', p_end - target)
+            );
+            chunk.end = (newline ? newline + 1 : p_end);
+        }
+        chunk.initial_previous_offset = p_previous_offset;
+        chunk_begin = chunk.end;
+    }
+
+    // Parse the first chunk in this thread, and the others in threads of
+    // their own, as far as they can be created.
+    vector<thread> threads;
+    auto num_threaded_chunks = chunks.size();
+    try
+    {
+        threads.reserve(chunks.size() - 1);
+        for (decltype(chunks.size()) i = 1; i != chunks.size(); ++i)
+        {
+            auto& chunk = chunks[i];
+            threads.emplace_back([this, &p_file, &chunk]()
+            {
+                parse_chunk(p_file, chunk);
+            });
+        }
+    }
+    catch (system_error&)
+    {
+        num_threaded_chunks = threads.size() + 1;
+    }
+    parse_chunk(p_file, chunks[0]);
+    for (auto i = num_threaded_chunks; i != chunks.size(); ++i)
+    {
+        parse_chunk(p_file, chunks[i]);
+    }
+    for (auto& chunk_thread: threads)
+    {
+        chunk_thread.join();
+    }
+    return chunks;
+}
+
+void
+LogTextParser::parse_chunk(MappedFile const& p_file, ParsedChunk& p_chunk) const
+{
+    p_chunk.failed = false;
+    try
+    {
+        TimeStampParser parser(m_time_format);
+        parser.set_previous_offset(p_chunk.initial_previous_offset);
+        auto& entries = p_chunk.entries;
+        unordered_map<string, std::uint32_t> activity_numbers;
+        string activity;
+        for (auto line_begin = p_chunk.begin; line_begin != p_chunk.end; )
+        {
+            auto const newline = static_cast<char const*>
+            (   memchr(line_begin, '\n', p_chunk.end - line_begin)
+            );
+            auto const line_end = (newline ? newline : p_chunk.end);
+            auto const seconds = time_point_to_seconds
+            (   parse_line(parser, p_file, line_begin, line_end, activity)
+            );
+            if (!entries.seconds.empty() && (seconds < entries.seconds.back()))
+            {
+                p_chunk.failed = true;
+                return;
+            }
+            auto const number = activity_numbers.emplace
+            (   activity,
+                static_cast<std::uint32_t>(entries.activities.size())
+            );
+            if (number.second)
+            {
+                entries.activities.push_back(activity);
+            }
+            auto const activity_number = number.first->second;
+            if
+            (   entries.activity_numbers.empty() ||
+                (entries.activity_numbers.back() != activity_number)
+            )
+            {
+                entries.seconds.push_back(seconds);
+                entries.activity_numbers.push_back(activity_number);
+                p_chunk.last_entry_offset = line_begin - p_file.begin();
+            }
+            line_begin = (newline ? newline + 1 : p_chunk.end);
+        }
+        p_chunk.final_previous_offset = parser.previous_offset();
+    }
+    catch (exception&)
+    {
+        // The error will be reported when the chunk is parsed again.
+        p_chunk.failed = true;
+    }
+}
+
+bool
+LogTextParser::parses_alike
+(   char const* p_begin,
+    char const* p_end,
+    long long p_previous_offset,
+    long long p_other_previous_offset
+) const
+{
+    // Once the parsers reach the same previous offset, they will parse all
+    // subsequent time stamps alike; which nearly always happens at the
+    // first.
+    if (p_previous_offset == p_other_previous_offset)
+    {
+        return true;
+    }
+    TimeStampParser parser(m_time_format);
+    TimeStampParser other_parser(m_time_format);
+    parser.set_previous_offset(p_previous_offset);
+    other_parser.set_previous_offset(p_other_previous_offset);
+    for (auto line_begin = p_begin; line_begin != p_end; )
+    {
+        auto const time_stamp_end = line_begin + m_time_stamp_length;
+        assert (time_stamp_end <= p_end);
+        if
+        (   parser.parse(line_begin, time_stamp_end) !=
+            other_parser.parse(line_begin, time_stamp_end)
+        )
+        {
+            return false;
+        }
+        if (parser.previous_offset() == other_parser.previous_offset())
+        {
+            return true;
+        }
+        auto const newline = static_cast<char const*>
+        (   memchr(line_begin, '\n', p_end - line_begin)
+        );
+        line_begin = (newline ? newline + 1 : p_end);
+    }
+    return true;
+}
+
+size_t
+line_number_at(MappedFile const& p_file, char const* p_position)
+{
+    size_t ret = 1;
+    for (auto it = p_file.begin(); it != p_position; ++ret)
+    {
+        auto const newline =
+            static_cast<char const*>(memchr(it, '\n', p_position - it));
+        if (!newline)
+        {
+            break;
+        }
+        it = newline + 1;
+    }
+    return ret;
+}
+
+}  // namespace swx
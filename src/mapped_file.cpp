@@ -0,0 +1,92 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mapped_file.hpp"
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+using std::runtime_error;
+using std::size_t;
+using std::string;
+
+// NOTE This is non-portable. POSIX is assumed.
+
+namespace swx
+{
+
+MappedFile::MappedFile(string const& p_filepath):
+    m_address(nullptr),
+    m_size(0)
+{
+    auto const descriptor = open(p_filepath.c_str(), O_RDONLY);
+    if (descriptor == -1)
+    {
+        throw runtime_error("Could not open file at " + p_filepath + ".");
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) != 0)
+    {
+        close(descriptor);
+        throw runtime_error("Could not examine file at " + p_filepath + ".");
+    }
+    m_size = static_cast<size_t>(status.st_size);
+    if (m_size != 0)  // mmap does not accept a length of zero
+    {
+        m_address = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (m_address == MAP_FAILED)
+        {
+            close(descriptor);
+            throw runtime_error("Could not map file at " + p_filepath + ".");
+        }
+        madvise(m_address, m_size, MADV_SEQUENTIAL);
+    }
+    // The mapping remains valid after the descriptor is closed.
+    close(descriptor);
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_address)
+    {
+        munmap(m_address, m_size);
+    }
+}
+
+char const*
+MappedFile::begin() const
+{
+    return static_cast<char const*>(m_address);
+}
+
+char const*
+MappedFile::end() const
+{
+    return begin() + m_size;
+}
+
+size_t
+MappedFile::size() const
+{
+    return m_size;
+}
+
+}  // namespace swx
@@ -54,4 +54,10 @@ OrdinaryActivityFilter::do_replace
     return p_substitution + string(p_old_str.begin() + m_comparitor.size(), p_old_str.end());
 }
 
+string const*
+OrdinaryActivityFilter::do_get_subactivity_root() const
+{
+    return &m_comparitor;
+}
+
 }  // namespace swx
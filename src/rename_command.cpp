@@ -27,15 +27,22 @@
 #include "stream_utilities.hpp"
 #include "string_utilities.hpp"
 #include "time_log.hpp"
+#include <cstddef>
+#include <fstream>
 #include <memory>
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 using std::endl;
+using std::getline;
+using std::ifstream;
 using std::ostream;
 using std::ostringstream;
+using std::pair;
+using std::size_t;
 using std::unique_ptr;
 using std::string;
 using std::vector;
@@ -48,6 +55,22 @@ namespace
     auto const k_exclude_subactivities_alias = "x";
     auto const k_use_regex_alias = "r";
 
+    void print_count(ostream& p_os, vector<Stint>::size_type p_count)
+    {
+        switch (p_count)
+        {
+        case 0:
+            p_os << "No matches found." << endl;
+            break;
+        case 1:
+            p_os << "1 stint matched and renamed" << endl;
+            break;
+        default:
+            p_os << p_count << " stints matched and renamed." << endl;
+            break;
+        }
+    }
+
 }  // end anonymous namespace
 
 RenameCommand::RenameCommand
@@ -90,6 +113,21 @@ RenameCommand::RenameCommand
         use_regex_message_stream.str(),
         [this]() { m_activity_filter_type = ActivityFilter::Type::regex; }
     );
+    add_option
+    (   vector<string>{"f", "file"},
+        HelpLine
+        (   "Instead of renaming a single ACTIVITY, apply each of the renamings "
+                "listed in FILE in turn, saving the log just once. Each line of FILE "
+                "consists of \"ordinary\", \"exact\" or \"regex\" (corresponding to "
+                "the absence of an option, -" + string(k_exclude_subactivities_alias) +
+                " and -" + string(k_use_regex_alias) + " respectively), ACTIVITY and "
+                "NAME, separated by tabs; blank lines, and lines beginning with '#', "
+                "are ignored",
+            "<FILE>"
+        ),
+        nullptr,
+        &m_renamings_filepath
+    );
 }
 
 RenameCommand::~RenameCommand() = default;
@@ -103,7 +141,19 @@ RenameCommand::do_process
 {
     (void)p_config;  // silence compiler re. unused param.
     ErrorMessages error_messages;
-    if (p_ordinary_args.size() == 2)
+    if (!m_renamings_filepath.empty())
+    {
+        if (p_ordinary_args.empty())
+        {
+            return rename_from_file(p_ordinary_ostream);
+        }
+        ostringstream oss;
+        enable_exceptions(oss);
+        oss << "Wrong number of arguments. Required 0 with a FILE, received "
+            << p_ordinary_args.size();
+        error_messages.push_back(oss.str());
+    }
+    else if (p_ordinary_args.size() == 2)
     {
         auto const process_arg = [p_ordinary_args](TimeLog& log, size_t i)
         {
@@ -115,18 +165,7 @@ RenameCommand::do_process
         unique_ptr<ActivityFilter>
             activity_filter(ActivityFilter::create(comparitor, m_activity_filter_type));
         auto const count = time_log().rename_activity(*activity_filter, new_name);
-        switch (count)
-        {
-        case 0:
-            p_ordinary_ostream << "No matches found." << endl;
-            break;
-        case 1:
-            p_ordinary_ostream << "1 stint matched and renamed" << endl;
-            break;
-        default:
-            p_ordinary_ostream << count << " stints matched and renamed." << endl;
-            break;
-        }
+        print_count(p_ordinary_ostream, count);
     }
     else
     {
@@ -139,6 +178,82 @@ RenameCommand::do_process
     return error_messages;
 }
 
+Command::ErrorMessages
+RenameCommand::rename_from_file(ostream& p_ordinary_ostream)
+{
+    // Read all the renamings before applying any of them, so that they are
+    // applied only if all of them are valid.
+    ErrorMessages error_messages;
+    ifstream infile(m_renamings_filepath.c_str());
+    if (!infile)
+    {
+        error_messages.push_back("Could not open file at " + m_renamings_filepath + ".");
+        return error_messages;
+    }
+    vector<unique_ptr<ActivityFilter>> activity_filters;
+    vector<pair<ActivityFilter const*, string>> renamings;
+    vector<size_t> line_numbers;
+    string line;
+    for (size_t line_number = 1; getline(infile, line); ++line_number)
+    {
+        auto const trimmed_line = trim(line);
+        if (trimmed_line.empty() || (trimmed_line[0] == '#'))
+        {
+            continue;
+        }
+        ostringstream oss;
+        enable_exceptions(oss);
+        oss << "Error in " << m_renamings_filepath << " at line " << line_number << ": ";
+        auto const fields = split(line, '\t');
+        if (fields.size() != 3)
+        {
+            oss << "expected 3 fields separated by tabs, found " << fields.size();
+            error_messages.push_back(oss.str());
+            continue;
+        }
+        auto activity_filter_type = ActivityFilter::Type::ordinary;
+        auto const type_name = trim(fields[0]);
+        if (type_name == "exact")
+        {
+            activity_filter_type = ActivityFilter::Type::exact;
+        }
+        else if (type_name == "regex")
+        {
+            activity_filter_type = ActivityFilter::Type::regex;
+        }
+        else if (type_name != "ordinary")
+        {
+            oss << "unrecognized type of renaming \"" << type_name << '"';
+            error_messages.push_back(oss.str());
+            continue;
+        }
+        auto const comparitor = expand_placeholders(split(fields[1]), time_log());
+        activity_filters.emplace_back
+        (   ActivityFilter::create(comparitor, activity_filter_type)
+        );
+        renamings.emplace_back
+        (   activity_filters.back().get(),
+            expand_placeholders(split(fields[2]), time_log())
+        );
+        line_numbers.push_back(line_number);
+    }
+    if (infile.bad())
+    {
+        error_messages.push_back("Could not read " + m_renamings_filepath);
+    }
+    if (!error_messages.empty())
+    {
+        return error_messages;
+    }
+    auto const counts = time_log().rename_activities(renamings);
+    for (vector<Stint>::size_type i = 0; i != counts.size(); ++i)
+    {
+        p_ordinary_ostream << "Line " << line_numbers[i] << ": ";
+        print_count(p_ordinary_ostream, counts[i]);
+    }
+    return error_messages;
+}
+
 bool
 RenameCommand::does_support_placeholders() const
 {
@@ -18,55 +18,34 @@
 #include "arithmetic.hpp"
 #include "config.hpp"
 #include "csv_list_report_writer.hpp"
-#include "csv_summary_report_writer.hpp"
 #include "human_list_report_writer.hpp"
-#include "human_summary_report_writer.hpp"
 #include "interval.hpp"
 #include "stint.hpp"
+#include "time_point.hpp"
+#include <cassert>
 #include <ostream>
 #include <string>
-#include <vector>
 
 using std::ostream;
 using std::string;
-using std::vector;
 
 namespace swx
 {
 
 ReportWriter*
-ReportWriter::create
-(   vector<Stint> const& p_stints,
-    Options const& p_options,
-    Flags::Type p_flags
-)
-{
-    auto const csv = (p_flags & Flags::csv);
-    auto const show_stints = (p_flags & Flags::show_stints);
-    if (csv && show_stints)
-    {
-        return new CsvListReportWriter(p_stints, p_options);
-    }
-    else if (csv)
-    {
-        return new CsvSummaryReportWriter(p_stints, p_options, p_flags);
-    }
-    else if (show_stints)
-    {
-        return new HumanListReportWriter(p_stints, p_options);
-    }
-    else
+ReportWriter::create(Options const& p_options, Flags::Type p_flags)
+{
+    assert (p_flags & Flags::show_stints);
+    if (p_flags & Flags::csv)
     {
-        return new HumanSummaryReportWriter(p_stints, p_options, p_flags);
+        return new CsvListReportWriter(p_options);
     }
+    return new HumanListReportWriter(p_options);
 }
 
-ReportWriter::ReportWriter
-(   vector<Stint> const& p_stints,
-    Options const& p_options
-):
+ReportWriter::ReportWriter(Options const& p_options):
     m_options(p_options),
-    m_stints(p_stints)
+    m_time_stamp_formatter(p_options.time_format, p_options.formatted_buf_len)
 {
 }
 
@@ -130,27 +109,33 @@ ReportWriter::round_hours(Interval const& p_interval) const
     return seconds_to_rounded_hours(p_interval.duration().count());
 }
 
+string const&
+ReportWriter::time_stamp(TimePoint const& p_time_point) const
+{
+    return m_time_stamp_formatter.format(p_time_point);
+}
+
 void
-ReportWriter::write(ostream& p_os)
+ReportWriter::write(ostream& p_os, StintSource const& p_stint_source)
 {
-        do_preprocess_stints(p_os, m_stints);
-        for (auto const& stint: m_stints) do_process_stint(p_os, stint);
-        do_postprocess_stints(p_os, m_stints);
+    do_preprocess_stints(p_os);
+    p_stint_source([this, &p_os](Stint const& p_stint)
+    {
+        do_process_stint(p_os, p_stint);
+    });
+    do_postprocess_stints(p_os);
 }
 
 void
-ReportWriter::do_preprocess_stints(ostream& p_os, vector<Stint> const& p_stints)
+ReportWriter::do_preprocess_stints(ostream& p_os)
 {
-    (void)p_os; (void)p_stints;  // silence compiler re. unused params.
+    (void)p_os;  // silence compiler re. unused param.
 }
 
 void
-ReportWriter::do_postprocess_stints
-(   ostream& p_os,
-    vector<Stint> const& p_stints
-)
+ReportWriter::do_postprocess_stints(ostream& p_os)
 {
-    (void)p_os; (void)p_stints;  // silence compiler re. unused params.
+    (void)p_os;  // silence compiler re. unused param.
 }
 
 ReportWriter::Options::Options
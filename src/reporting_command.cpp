@@ -158,8 +158,6 @@ ReportingCommand::print_report
 
     unique_ptr<ActivityFilter>
         filter(ActivityFilter::create(comparitor, m_activity_filter_type));
-    auto const stints = m_time_log.get_stints(*filter, p_begin, p_end);
-
     unsigned int depth = 0;
     stringstream ss(m_depth_str);
     ss >> depth;
@@ -180,9 +178,39 @@ ReportingCommand::print_report
         depth
     );
 
+    if (!(m_report_flags & ReportWriter::Flags::show_stints))
+    {
+        // Summaries can be obtained without visiting each stint.
+        unique_ptr<SummaryReportWriter>
+            report_writer(SummaryReportWriter::create(options, m_report_flags));
+        if (m_report_flags & ReportWriter::Flags::succinct)
+        {
+            report_writer->write_total
+            (   p_os,
+                m_time_log.get_total_stats(*filter, p_begin, p_end)
+            );
+        }
+        else
+        {
+            report_writer->write_summary
+            (   p_os,
+                m_time_log.get_activity_stats(*filter, p_begin, p_end)
+            );
+        }
+        return ErrorMessages{};
+    }
+
     unique_ptr<ReportWriter>
-        report_writer(ReportWriter::create(stints, options, m_report_flags));
-    report_writer->write(p_os);
+        report_writer(ReportWriter::create(options, m_report_flags));
+    report_writer->write
+    (   p_os,
+        [this, &filter, p_begin, p_end]
+        (   TimeLog::StintVisitor const& p_visitor
+        )
+        {
+            m_time_log.for_each_stint(*filter, p_begin, p_end, p_visitor);
+        }
+    );
 
     return ErrorMessages{};
 }
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rollup.hpp"
+#include "entries.hpp"
+#include "time_point.hpp"
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+using std::max;
+using std::min;
+using std::vector;
+
+namespace swx
+{
+
+void
+update_rollup(Entries& p_entries, vector<RollupDay>& p_rollup)
+{
+    // Discard the days that may have been affected by changes to the entries
+    // since the rollup was last updated. A day is unaffected if it ends no
+    // later than an unmodified entry, since then each stint overlapping it
+    // both begins and ends with an unmodified entry.
+    auto const num_unmodified = p_entries.num_unmodified();
+    if (num_unmodified == 0)
+    {
+        p_rollup.clear();
+    }
+    else
+    {
+        auto const limit = p_entries.seconds(num_unmodified - 1);
+        while (!p_rollup.empty() && (p_rollup.back().end > limit))
+        {
+            p_rollup.pop_back();
+        }
+    }
+    p_entries.mark_unmodified();
+    if (p_entries.empty())
+    {
+        return;
+    }
+
+    // Add each further day that ends no later than the last entry.
+    auto const num_entries = p_entries.size();
+    auto const last_seconds = p_entries.seconds(num_entries - 1);
+    TimePoint next_day_begin;
+    if (p_rollup.empty())
+    {
+        auto const first = p_entries.time_point(0);
+        next_day_begin = day_begin(first);
+        if (next_day_begin < first) next_day_begin = day_begin(first, 1);
+    }
+    else
+    {
+        next_day_begin = seconds_to_time_point(p_rollup.back().end);
+    }
+    while (true)
+    {
+        auto const next_day_end = day_begin(next_day_begin, 1);
+        RollupDay day;
+        day.begin = time_point_to_seconds(next_day_begin);
+        day.end = time_point_to_seconds(next_day_end);
+        if ((day.end > last_seconds) || (day.end <= day.begin))
+        {
+            break;
+        }
+        auto const add = [&day]
+        (   Entries::ActivityId p_activity_id,
+            EpochSeconds p_b,
+            EpochSeconds p_e
+        )
+        {
+            for (auto& row: day.rows)
+            {
+                if (row.activity_id == p_activity_id)
+                {
+                    row.seconds += p_e - p_b;
+                    row.beginning = min(row.beginning, p_b);
+                    row.ending = max(row.ending, p_e);
+                    return;
+                }
+            }
+            day.rows.push_back(RollupRow{p_activity_id, p_e - p_b, p_b, p_e});
+        };
+
+        // The stint current at the start of the day is that of the last entry
+        // at or before the first midnight; any earlier entries at exactly
+        // that midnight begin stints of zero duration.
+        auto const i = p_entries.upper_bound(day.begin);
+        assert ((i != 0) && (i != num_entries));
+        day.has_boundary_stints = (i - p_entries.lower_bound(day.begin) > 1);
+        for (auto j = i - 1; p_entries.seconds(j) < day.end; ++j)
+        {
+            assert (j + 1 != num_entries);
+            auto const b = max(p_entries.seconds(j), day.begin);
+            auto const e = min(p_entries.seconds(j + 1), day.end);
+            add(p_entries.activity_id(j), b, e);
+        }
+        p_rollup.push_back(std::move(day));
+        next_day_begin = next_day_end;
+    }
+}
+
+}  // namespace swx
@@ -0,0 +1,232 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "segment_manifest.hpp"
+#include "entries.hpp"
+#include "index_reader.hpp"
+#include "stream_utilities.hpp"
+#include "time_point.hpp"
+#include <algorithm>
+#include <cassert>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::equal;
+using std::ostringstream;
+using std::runtime_error;
+using std::setfill;
+using std::setw;
+using std::string;
+using std::vector;
+
+namespace swx
+{
+
+namespace
+{
+    // Identifies a segment manifest, and the version of its layout.
+    char const k_manifest_tag[] = "swxman02";
+    auto const k_manifest_tag_size = sizeof(k_manifest_tag) - 1;
+
+    // Identifies a manifest of the previous layout, which lacks the encoding
+    // of each segment, as all segments were then text.
+    char const k_text_manifest_tag[] = "swxman01";
+
+}  // end anonymous namespace
+
+Segmentation
+parse_segmentation(string const& p_segments)
+{
+    if (p_segments == "none") return Segmentation::none;
+    if (p_segments == "yearly") return Segmentation::yearly;
+    if (p_segments == "monthly") return Segmentation::monthly;
+    throw runtime_error("Unrecognized log segmentation: " + p_segments);
+}
+
+TimePoint
+period_begin(TimePoint const& p_time_point, Segmentation p_segmentation)
+{
+    assert (p_segmentation != Segmentation::none);
+    auto time_tm = time_point_to_tm(p_time_point);
+    if (p_segmentation == Segmentation::yearly) time_tm.tm_mon = 0;
+    time_tm.tm_mday = 1;
+    time_tm.tm_hour = time_tm.tm_min = time_tm.tm_sec = 0;
+    time_tm.tm_isdst = -1;
+    return tm_to_time_point(time_tm);
+}
+
+string
+period_label(TimePoint const& p_time_point, Segmentation p_segmentation)
+{
+    assert (p_segmentation != Segmentation::none);
+    auto const time_tm = time_point_to_tm(p_time_point);
+    ostringstream oss;
+    enable_exceptions(oss);
+    oss << setfill('0') << setw(4) << (time_tm.tm_year + 1900);
+    if (p_segmentation == Segmentation::monthly)
+    {
+        oss << '-' << setw(2) << (time_tm.tm_mon + 1);
+    }
+    return oss.str();
+}
+
+string
+encode_manifest(vector<Segment> const& p_segments, bool p_rotating)
+{
+    string buffer(k_manifest_tag, k_manifest_tag + k_manifest_tag_size);
+    append_value<IndexField>(buffer, p_rotating);
+    append_value<IndexField>(buffer, p_segments.size());
+    for (auto const& segment: p_segments)
+    {
+        append_value<IndexField>(buffer, segment.label.size());
+        buffer.append(segment.label);
+        append_value(buffer, segment.first_seconds);
+        append_value(buffer, segment.last_seconds);
+        append_value<IndexField>(buffer, segment.num_entries);
+        append_value<IndexField>(buffer, static_cast<IndexField>(segment.encoding));
+        append_value<IndexField>(buffer, segment.activities.size());
+        for (auto const& activity: segment.activities)
+        {
+            append_value<IndexField>(buffer, activity.size());
+            buffer.append(activity);
+        }
+    }
+    return buffer;
+}
+
+bool
+decode_manifest
+(   char const* p_begin,
+    char const* p_end,
+    vector<Segment>& p_segments,
+    bool& p_rotating
+)
+{
+    auto const size = static_cast<IndexField>(p_end - p_begin);
+    auto const has_tag = [p_begin, size](char const* p_tag)
+    {
+        return
+        (   (size >= k_manifest_tag_size) &&
+            equal(p_tag, p_tag + k_manifest_tag_size, p_begin)
+        );
+    };
+    auto const has_encodings = has_tag(k_manifest_tag);
+    IndexReader reader(p_begin, p_end);
+    IndexField rotating = 0;
+    IndexField num_segments = 0;
+    if
+    (   (!has_encodings && !has_tag(k_text_manifest_tag)) ||
+        !reader.skip(k_manifest_tag_size) ||
+        !reader.read(rotating) ||
+        !reader.read(num_segments) ||
+        (num_segments > size)
+    )
+    {
+        return false;
+    }
+    auto const max_encoding =
+        static_cast<IndexField>(SegmentEncoding::compressed_archive);
+    p_segments.resize(num_segments);
+    for (auto& segment: p_segments)
+    {
+        IndexField label_size = 0;
+        IndexField num_entries = 0;
+        IndexField encoding = 0;
+        IndexField num_activities = 0;
+        if
+        (   !reader.read(label_size) ||
+            !reader.read(segment.label, label_size) ||
+            !reader.read(segment.first_seconds) ||
+            !reader.read(segment.last_seconds) ||
+            !reader.read(num_entries) ||
+            (has_encodings && !reader.read(encoding)) ||
+            !reader.read(num_activities) ||
+            (encoding > max_encoding) ||
+            segment.label.empty() ||
+            (segment.label.find('/') != string::npos) ||
+            (segment.first_seconds > segment.last_seconds) ||
+            (num_entries == 0) ||
+            (num_activities > num_entries)
+        )
+        {
+            return false;
+        }
+        segment.num_entries = num_entries;
+        segment.encoding = static_cast<SegmentEncoding>(encoding);
+        segment.activities.resize(num_activities);
+        for (auto& activity: segment.activities)
+        {
+            IndexField activity_size = 0;
+            if (!reader.read(activity_size) || !reader.read(activity, activity_size))
+            {
+                return false;
+            }
+        }
+        segment.end = 0;
+        segment.modified = false;
+    }
+    p_rotating = (rotating != 0);
+    return reader.exhausted();
+}
+
+void
+append_period_segments
+(   Entries const& p_entries,
+    Entries::Index p_begin,
+    Entries::Index p_end,
+    Segmentation p_segmentation,
+    vector<Segment>& p_segments
+)
+{
+    assert (p_end <= p_entries.size());
+    for (auto i = p_begin; i != p_end; )
+    {
+        auto const label = period_label(p_entries.time_point(i), p_segmentation);
+        auto j = i + 1;
+        while
+        (   (j != p_end) &&
+            (period_label(p_entries.time_point(j), p_segmentation) == label)
+        )
+        {
+            ++j;
+        }
+        Segment segment;
+        segment.label = label;
+        segment.encoding = SegmentEncoding::text;
+        auto const is_taken = [&segment](Segment const& p_other)
+        {
+            return p_other.label == segment.label;
+        };
+        for
+        (   unsigned int k = 2;
+            std::any_of(p_segments.begin(), p_segments.end(), is_taken);
+            ++k
+        )
+        {
+            segment.label = label + '_' + std::to_string(k);
+        }
+        segment.end = j;
+        segment.modified = true;
+        p_segments.push_back(std::move(segment));
+        i = j;
+    }
+}
+
+}  // namespace swx
@@ -25,14 +25,18 @@
 #include <iostream>
 #include <ostream>
 #include <map>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 using std::endl;
 using std::fixed;
 using std::ios_base;
 using std::left;
+using std::make_shared;
 using std::map;
+using std::move;
 using std::ostream;
 using std::right;
 using std::setprecision;
@@ -43,14 +47,26 @@ using std::vector;
 namespace swx
 {
 
-Stint::Stint(string const& p_activity, Interval const& p_interval):
-    m_activity(p_activity),
+Stint::Stint(ActivityName p_activity, Interval const& p_interval):
+    m_activity(move(p_activity)),
     m_interval(p_interval)
+{
+    assert (m_activity);
+}
+
+Stint::Stint(string const& p_activity, Interval const& p_interval):
+    Stint(make_shared<string const>(p_activity), p_interval)
 {
 }
 
 string const&
 Stint::activity() const
+{
+    return *m_activity;
+}
+
+ActivityName const&
+Stint::activity_name() const
 {
     return m_activity;
 }
@@ -17,6 +17,8 @@
 #include "summary_report_writer.hpp"
 #include "activity_stats.hpp"
 #include "arithmetic.hpp"
+#include "csv_summary_report_writer.hpp"
+#include "human_summary_report_writer.hpp"
 #include "seconds.hpp"
 #include "stint.hpp"
 #include "stream_utilities.hpp"
@@ -26,64 +28,61 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
-#include <vector>
 
 using std::map;
 using std::ostringstream;
 using std::ostream;
 using std::runtime_error;
 using std::string;
-using std::vector;
 
 namespace swx
 {
 
+SummaryReportWriter*
+SummaryReportWriter::create(Options const& p_options, Flags::Type p_flags)
+{
+    if (p_flags & Flags::csv)
+    {
+        return new CsvSummaryReportWriter(p_options, p_flags);
+    }
+    return new HumanSummaryReportWriter(p_options, p_flags);
+}
+
 SummaryReportWriter::SummaryReportWriter
-(   vector<Stint> const& p_stints,
-    Options const& p_options,
+(   Options const& p_options,
     Flags::Type p_flags
 ):
-    ReportWriter(p_stints, p_options),
+    ReportWriter(p_options),
     m_flags(p_flags)
 {
-    assert (m_activity_stats_map.empty());
 }
 
 SummaryReportWriter::~SummaryReportWriter() = default;
 
 void
-SummaryReportWriter::do_preprocess_stints
+SummaryReportWriter::write_summary
 (   ostream& p_os,
-    vector<Stint> const& p_stints
+    map<string, ActivityStats> p_activity_stats_map
 )
 {
-    (void)p_os; (void)p_stints;  // silence compiler warnings re. unused params.
-    assert (m_activity_stats_map.empty());
+    p_activity_stats_map.erase(string());
+    do_write_summary(p_os, p_activity_stats_map);
 }
 
 void
-SummaryReportWriter::do_process_stint(ostream& p_os, Stint const& p_stint)
+SummaryReportWriter::write_total(ostream& p_os, ActivityStats const& p_total)
 {
-    (void)p_os;  // silence compiler warning re. unused param.
-    auto const interval = p_stint.interval();
-    unsigned long long const seconds = interval.duration().count();
-    auto const& activity = p_stint.activity();
-    if (!activity.empty())
-    {
-        m_activity_stats_map[activity] +=
-            ActivityStats(seconds, interval.beginning(), interval.ending());
-    }
+    assert (has_flag(Flags::succinct));
+    do_write_total(p_os, p_total);
 }
 
 void
-SummaryReportWriter::do_postprocess_stints
-(   ostream& p_os,
-    vector<Stint> const& p_stints
-)
+SummaryReportWriter::do_process_stint(ostream& p_os, Stint const& p_stint)
 {
-    (void)p_stints;  // silence compiler warning re. unused param.
-    do_write_summary(p_os, m_activity_stats_map);
-    m_activity_stats_map.clear();  // hygienic even if unnecessary
+    // Summaries are written only via write_summary and write_total.
+    (void)p_os;  // silence compiler warning re. unused param.
+    (void)p_stint;  // silence compiler warning re. unused param.
+    assert (false);
 }
 
 bool
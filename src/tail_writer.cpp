@@ -0,0 +1,233 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tail_writer.hpp"
+#include "file_utilities.hpp"
+#include "hash.hpp"
+#include "stream_utilities.hpp"
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+using std::ifstream;
+using std::ios_base;
+using std::istreambuf_iterator;
+using std::istringstream;
+using std::ostringstream;
+using std::remove;
+using std::runtime_error;
+using std::size_t;
+using std::string;
+
+// NOTE There's a bunch of non-portable stuff in here. POSIX is assumed.
+
+namespace swx
+{
+
+namespace
+{
+    char const k_journal_suffix[] = ".journal";
+    char const k_journal_tag[] = "swx-journal";
+
+    string journal_filepath(string const& p_filepath)
+    {
+        return p_filepath + k_journal_suffix;
+    }
+
+    // Closes a file descriptor on destruction.
+    class DescriptorGuard
+    {
+    public:
+        explicit DescriptorGuard(int p_descriptor): m_descriptor(p_descriptor)
+        {
+        }
+        DescriptorGuard(DescriptorGuard const& rhs) = delete;
+        DescriptorGuard(DescriptorGuard&& rhs) = delete;
+        DescriptorGuard& operator=(DescriptorGuard const& rhs) = delete;
+        DescriptorGuard& operator=(DescriptorGuard&& rhs) = delete;
+        ~DescriptorGuard()
+        {
+            close(m_descriptor);
+        }
+    private:
+        int const m_descriptor;
+    };
+
+    void write_at(int p_descriptor, string const& p_str, unsigned long long p_offset)
+    {
+        size_t written = 0;
+        while (written != p_str.size())
+        {
+            auto const result = pwrite
+            (   p_descriptor,
+                p_str.data() + written,
+                p_str.size() - written,
+                p_offset + written
+            );
+            if (result == -1)
+            {
+                if (errno == EINTR) continue;
+                throw runtime_error("Error writing to file.");
+            }
+            written += result;
+        }
+    }
+
+    // Replace everything in the file at p_filepath from p_offset onwards with
+    // p_tail, and flush the result to the storage device. Doing this more than
+    // once with the same arguments has the same result as doing it once.
+    void replace_tail
+    (   string const& p_filepath,
+        unsigned long long p_offset,
+        string const& p_tail
+    )
+    {
+        int const descriptor = open(p_filepath.c_str(), O_WRONLY);
+        if (descriptor == -1)
+        {
+            throw runtime_error("Error opening " + p_filepath + " for writing.");
+        }
+        DescriptorGuard const guard(descriptor);
+        write_at(descriptor, p_tail, p_offset);
+        if (ftruncate(descriptor, p_offset + p_tail.size()) != 0)
+        {
+            throw runtime_error("Error truncating " + p_filepath + '.');
+        }
+        if (fsync(descriptor) != 0)
+        {
+            throw runtime_error("Error flushing " + p_filepath + " to disk.");
+        }
+    }
+
+    void remove_journal(string const& p_journal_filepath)
+    {
+        if (remove(p_journal_filepath.c_str()) != 0)
+        {
+            throw runtime_error("Error removing " + p_journal_filepath + '.');
+        }
+        // Otherwise a stale journal could reappear after a crash, and clobber
+        // subsequent changes when replayed.
+        sync_directory_of(p_journal_filepath);
+    }
+
+}  // end anonymous namespace
+
+TailWriter::TailWriter(string const& p_filepath, unsigned long long p_offset):
+    m_filepath(p_filepath),
+    m_offset(p_offset)
+{
+}
+
+TailWriter::~TailWriter() = default;
+
+void
+TailWriter::append(string const& p_str)
+{
+    m_tail += p_str;
+}
+
+void
+TailWriter::commit()
+{
+    auto const journal = journal_filepath(m_filepath);
+    ostringstream oss;
+    enable_exceptions(oss);
+    oss << k_journal_tag << ' '
+        << m_offset << ' '
+        << m_tail.size() << ' '
+        << hash_bytes(m_tail.data(), m_tail.data() + m_tail.size()) << '\n';
+    // anonymous scope
+    {
+        int const descriptor =
+            open(journal.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+        if (descriptor == -1)
+        {
+            throw runtime_error("Error opening " + journal + " for writing.");
+        }
+        DescriptorGuard const guard(descriptor);
+        auto const header = oss.str();
+        write_at(descriptor, header, 0);
+        write_at(descriptor, m_tail, header.size());
+        if (fsync(descriptor) != 0)
+        {
+            throw runtime_error("Error flushing " + journal + " to disk.");
+        }
+    }
+    sync_directory_of(journal);
+
+    // The journal is now durable, so from here on, an interrupted change
+    // will be completed by recover().
+    replace_tail(m_filepath, m_offset, m_tail);
+    remove_journal(journal);
+}
+
+void
+TailWriter::recover(string const& p_filepath)
+{
+    auto const journal = journal_filepath(p_filepath);
+    if (!file_exists_at(journal))
+    {
+        return;
+    }
+    string contents;
+    // anonymous scope
+    {
+        ifstream infile(journal.c_str(), ios_base::in | ios_base::binary);
+        if (!infile)
+        {
+            throw runtime_error("Error opening " + journal + '.');
+        }
+        contents.assign(istreambuf_iterator<char>(infile), istreambuf_iterator<char>());
+    }
+
+    // If the journal is incomplete or corrupt, then the commit that wrote it
+    // was interrupted before it touched the target file, and the journal can
+    // simply be discarded.
+    auto const header_end = contents.find('\n');
+    if (header_end != string::npos)
+    {
+        istringstream iss(contents.substr(0, header_end));
+        string tag;
+        unsigned long long offset = 0;
+        string::size_type tail_size = 0;
+        unsigned long long checksum = 0;
+        iss >> tag >> offset >> tail_size >> checksum;
+        auto const tail_begin = contents.data() + header_end + 1;
+        auto const tail_end = contents.data() + contents.size();
+        if
+        (   iss &&
+            (tag == k_journal_tag) &&
+            (static_cast<string::size_type>(tail_end - tail_begin) == tail_size) &&
+            (hash_bytes(tail_begin, tail_end) == checksum)
+        )
+        {
+            replace_tail(p_filepath, offset, string(tail_begin, tail_end));
+        }
+    }
+    remove_journal(journal);
+}
+
+}  // namespace swx
@@ -16,24 +16,44 @@
 
 #include "time_log.hpp"
 #include "activity_filter.hpp"
+#include "activity_registry.hpp"
+#include "activity_stats.hpp"
+#include "activity_trie.hpp"
+#include "archive.hpp"
 #include "atomic_writer.hpp"
+#include "entries.hpp"
 #include "file_utilities.hpp"
+#include "filter_memo.hpp"
+#include "hash.hpp"
 #include "interval.hpp"
+#include "log_index.hpp"
+#include "log_text_parser.hpp"
+#include "mapped_file.hpp"
 #include "regex_activity_filter.hpp"
+#include "rollup.hpp"
+#include "segment_manifest.hpp"
 #include "stint.hpp"
 #include "stream_utilities.hpp"
 #include "string_utilities.hpp"
+#include "tail_writer.hpp"
+#include "time_log_impl.hpp"
 #include "time_point.hpp"
+#include "time_stamp_formatter.hpp"
+#include "time_stamp_parser.hpp"
 #include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <ctime>
 #include <fstream>
-#include <iomanip>
 #include <ios>
+#include <map>
+#include <memory>
+#include <queue>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -41,17 +61,18 @@
 #include <utility>
 #include <vector>
 
-using std::getline;
-using std::ifstream;
-using std::make_pair;
-using std::move;
+using std::make_shared;
+using std::map;
+using std::max;
+using std::min;
 using std::ofstream;
 using std::ostringstream;
 using std::pair;
+using std::priority_queue;
+using std::getenv;
 using std::runtime_error;
 using std::size_t;
 using std::string;
-using std::upper_bound;
 using std::unordered_map;
 using std::vector;
 
@@ -60,168 +81,42 @@ namespace chrono = std::chrono;
 namespace swx
 {
 
-/**
- * Provides implementation for TimeLog.
- */
-class TimeLog::Impl
-{
-// nested types
-private:
-    class Transaction;
-    friend class Transaction;
-    struct Entry;     // a single entry in the log, registered in the cache
-    using Entries = vector<Entry>;
-    using ReferenceCount = Entries::size_type;  // number of entries with a given activity
-    using ActivityId = pair<string const, ReferenceCount>*;
-    using ActivityRegistry = unordered_map<string, ReferenceCount>;
-
-// special member functions
-public:
-    Impl
-    (   string const& p_filepath,
-        string const& p_time_format,
-        unsigned int p_formatted_buf_len
-    );
-    Impl() = delete;
-    Impl(Impl const&) = delete;
-    Impl(Impl&&) = delete;
-    Impl& operator=(Impl const&) = delete;
-    Impl& operator=(Impl&&) = delete;
-    ~Impl();
-
-// ordinary member functions
-public:
-
-    // These implement the corresponding public functions of TimeLog.
-
-    void append_entry(string const& p_activity, TimePoint const& p_time_point);
-    string amend_last(string const& p_activity, TimePoint const& p_time_point);
-    vector<Stint>::size_type rename_activity
-    (   ActivityFilter const& p_activity_filter,
-        string const& p_new
-    );
-    vector<Stint> get_stints
-    (   ActivityFilter const& p_activity_filter,
-        TimePoint const* p_begin,
-        TimePoint const* p_end
-    );
-    string last_activity_to_match(string const& p_regex);
-    vector<string> last_activities(size_t p_num);
-    TimePoint last_entry_time(size_t p_ago);
-    bool is_active_at(TimePoint const& p_time_point);
-    bool is_active();
-    bool has_activity(string const& p_activity);
-
-private:
-
-    // Implementation details.
-
-    // Overall management of in-memory data structures.
-    void clear_cache();
-    void mark_cache_as_stale();
-    void load();
-    void save() const;
-
-    // Record that an entry refers to an activity, or that it has ceased
-    // to do so. The activity register contains a reference count for each
-    // activity and calling these functions causes this to be updated and
-    // for an activity to be deleted from the register when it is no
-    // longer referred to.
-    //
-    // NOTE register_activity_reference and deregister_activity_reference
-    // are implementation details for push_entry, pop_entry and put_entry,
-    // and should not be called from elsewhere.
-    ActivityId register_activity_reference(string const& p_activity);
-    void deregister_activity_reference(ActivityId p_activity_id);
-
-    string const& activity_at(Entry const& p_entry) const;
-
-    void push_entry(string const& p_activity, TimePoint const& p_time_point);
-    void pop_entry();
-
-    // Place a new entry at a specific index in m_entries, but only if it
-    // would not result in consecutive identical activities. Return true
-    // if and only if entry placed.
-    bool put_entry
-    (   string const& p_activity,
-        TimePoint const& p_time_point,
-        Entries::size_type p_index
-    );
+namespace
+{
+    char const k_index_suffix[] = ".index";
+
+    char const k_manifest_suffix[] = ".manifest";
+
+    // Number of bytes at the end of the log file that are hashed, as a final
+    // check that the log has not been changed since it was last read or written.
+    unsigned long long const k_tail_hash_size = 4096;
 
-    // Parse a line provided from the log file, returning a pair of
-    // activity name and TimePoint.
-    pair<string, TimePoint> parse_line
-    (   string const& p_entry_string,
-        size_t p_line_number
-    ) const;
-
-    // Append an entry to the log file.
-    void write_entry
-    (   AtomicWriter& p_writer,
-        string const& p_activity,
-        TimePoint const& p_time_point
-    ) const;
-
-    string const& id_to_activity(ActivityId p_activity_id) const;
-    Entries::const_iterator find_entry_just_before(TimePoint const& p_time_point);
-
-    // check validity of internal data structures
-    void assert_valid() const
-    {
-#       ifndef NDEBUG
-            do_assert_valid();
-#       endif
-    }
-
-#   ifndef NDEBUG
-        void do_assert_valid() const;
-#   endif
-
-// member variables
-private:
-    bool m_loaded = false;
-    unsigned int m_formatted_buf_len;
-    unsigned int m_expected_time_stamp_length;
-    string m_filepath;
-    Entries m_entries;
-    ActivityRegistry m_activity_registry;
-    string const m_time_format;
-};
-
-// Represents an entry in the in-memory cache of the time log, corresonding
-// to a line in the log file.
-struct TimeLog::Impl::Entry
-{
-    Entry(ActivityId p_activity_id, TimePoint const& p_time_point);
-    ActivityId activity_id;
-    TimePoint time_point;
-};
-
-// Provides RAII mechanism for managing changes to time log as a transaction.
-class TimeLog::Impl::Transaction
-{
-public:
-    explicit Transaction(TimeLog::Impl& p_time_log);
-    Transaction(Transaction const&) = delete;
-    Transaction(Transaction&&) = delete;
-    Transaction& operator=(Transaction const&) = delete;
-    Transaction& operator=(Transaction&&) = delete;
-    ~Transaction();
-    void commit();
-private:
-    void rollback();
-    bool m_committed = false;
-    TimeLog::Impl& m_time_log_impl;
-};
+    // When reporting on the stints of only some activities, the entries of
+    // those activities are visited via their posting lists, rather than by
+    // scanning every entry in the range, unless the activities account for
+    // at least 1 / k_posting_list_threshold of all entries.
+    unsigned long long const k_posting_list_threshold = 4;
+
+}  // end anonymous namespace
 
 // Implementation of public TimeLog class. Implementation defer to Impl.
 
 TimeLog::TimeLog
 (   string const& p_filepath,
     string const& p_time_format,
-    unsigned int p_formatted_buf_len
+    unsigned int p_formatted_buf_len,
+    bool p_use_index,
+    string const& p_segments
 ):
-    m_impl(new Impl(p_filepath, p_time_format, p_formatted_buf_len))
+    m_impl
+    (   new Impl
+        (   p_filepath,
+            p_time_format,
+            p_formatted_buf_len,
+            p_use_index,
+            p_segments
+        )
+    )
 {
 }
 
@@ -245,6 +140,20 @@ TimeLog::rename_activity(ActivityFilter const& p_activity_filter, string const&
     return m_impl->rename_activity(p_activity_filter, p_new);
 }
 
+size_t
+TimeLog::compact(Compression p_compression)
+{
+    return m_impl->compact(p_compression);
+}
+
+vector<vector<Stint>::size_type>
+TimeLog::rename_activities
+(   vector<pair<ActivityFilter const*, string>> const& p_renamings
+)
+{
+    return m_impl->rename_activities(p_renamings);
+}
+
 vector<Stint>
 TimeLog::get_stints
 (   ActivityFilter const& p_activity_filter,
@@ -255,6 +164,37 @@ TimeLog::get_stints
     return m_impl->get_stints(p_activity_filter, p_begin, p_end);
 }
 
+void
+TimeLog::for_each_stint
+(   ActivityFilter const& p_activity_filter,
+    TimePoint const* p_begin,
+    TimePoint const* p_end,
+    StintVisitor const& p_visitor
+)
+{
+    m_impl->for_each_stint(p_activity_filter, p_begin, p_end, p_visitor);
+}
+
+map<string, ActivityStats>
+TimeLog::get_activity_stats
+(   ActivityFilter const& p_activity_filter,
+    TimePoint const* p_begin,
+    TimePoint const* p_end
+)
+{
+    return m_impl->get_activity_stats(p_activity_filter, p_begin, p_end);
+}
+
+ActivityStats
+TimeLog::get_total_stats
+(   ActivityFilter const& p_activity_filter,
+    TimePoint const* p_begin,
+    TimePoint const* p_end
+)
+{
+    return m_impl->get_total_stats(p_activity_filter, p_begin, p_end);
+}
+
 string
 TimeLog::last_activity_to_match(string const& p_regex)
 {
@@ -287,18 +227,29 @@ TimeLog::has_activity(string const& p_activity)
 
 // Implementation of TimeLog::Impl
 
+unsigned long long const TimeLog::Impl::k_unknown_offset;
+
 TimeLog::Impl::Impl
 (   string const& p_filepath,
     string const& p_time_format,
-    unsigned int p_formatted_buf_len
+    unsigned int p_formatted_buf_len,
+    bool p_use_index,
+    string const& p_segments
 ):
     m_loaded(false),
-    m_formatted_buf_len(p_formatted_buf_len),
+    m_use_index(p_use_index),
+    m_segmentation(parse_segmentation(p_segments)),
     m_expected_time_stamp_length
     (   time_point_to_stamp(now(), p_time_format, p_formatted_buf_len).length()
     ),
     m_filepath(p_filepath),
-    m_time_format(p_time_format)
+    m_activity_registry(m_activity_table),
+    m_time_format(p_time_format),
+    m_time_stamp_parser(p_time_format),
+    m_time_stamp_formatter(p_time_format, p_formatted_buf_len),
+    m_text_parser(p_time_format, m_expected_time_stamp_length),
+    m_index_filepath(p_filepath + k_index_suffix),
+    m_manifest_filepath(p_filepath + k_manifest_suffix)
 {
     assert (m_entries.empty());
     assert (m_activity_registry.empty());
@@ -310,7 +261,7 @@ TimeLog::Impl::~Impl() = default;
 void
 TimeLog::Impl::append_entry(string const& p_activity, TimePoint const& p_time_point)
 {
-    Transaction transaction(*this);
+    Transaction transaction(*this, true);
     if (p_time_point > now())
     {
         throw runtime_error("Entry must not be future-dated.");
@@ -322,7 +273,7 @@ TimeLog::Impl::append_entry(string const& p_activity, TimePoint const& p_time_po
 string
 TimeLog::Impl::amend_last(string const& p_activity, TimePoint const& p_time_point)
 {
-    Transaction transaction(*this);
+    Transaction transaction(*this, true);
     if (p_time_point > now())
     {
         throw runtime_error("Entry must not be future-dated.");
@@ -330,7 +281,7 @@ TimeLog::Impl::amend_last(string const& p_activity, TimePoint const& p_time_poin
     string last_activity;
     if (!m_entries.empty())
     {
-        last_activity = activity_at(m_entries.back());
+        last_activity = activity_at(m_entries.size() - 1);
         pop_entry();
         push_entry(p_activity, p_time_point);
     }
@@ -341,394 +292,1629 @@ TimeLog::Impl::amend_last(string const& p_activity, TimePoint const& p_time_poin
 vector<Stint>::size_type
 TimeLog::Impl::rename_activity(ActivityFilter const& p_activity_filter, string const& p_new)
 {
-    // There is far from the most efficient implementation, but it is fairly straightforward.
-    // Note we do it this way using put_entry() to avoid consecutive entries with the same
-    // activity.
+    return rename_activities
+    (   vector<pair<ActivityFilter const*, string>>{{&p_activity_filter, p_new}}
+    ).front();
+}
+
+vector<vector<Stint>::size_type>
+TimeLog::Impl::rename_activities
+(   vector<pair<ActivityFilter const*, string>> const& p_renamings
+)
+{
     Transaction transaction(*this);
-    Entries::size_type const num_entries = m_entries.size();
-    Entries::size_type num_amended = 0;
-    Entries::size_type num_written = 0;
-    for (Entries::size_type num_read = 0; num_read != num_entries; ++num_read)
+
+    // Work out the name of each activity after each renaming in turn,
+    // calling replace just once for each distinct name at each stage. The
+    // names are numbered, so that they can be compared cheaply: after k
+    // renamings, the activity of an entry whose activity ID is old_ids[j]
+    // is named names[stages[k * num_old_ids + j]].
+    vector<ActivityId> old_ids;
+    vector<size_t> old_id_positions(m_activity_table.size());
+    for (ActivityId i = 0; i != m_activity_table.size(); ++i)
     {
-        auto const& old_entry = m_entries[num_read];
-        auto const& time_point = old_entry.time_point;
-        auto const& old_activity = activity_at(old_entry);
-        auto const new_activity = p_activity_filter.replace(old_activity, p_new);
-        if (new_activity != old_activity)
+        if (m_activity_table[i].reference_count != 0)
         {
-            ++num_amended;
+            old_id_positions[i] = old_ids.size();
+            old_ids.push_back(i);
         }
-        if (put_entry(new_activity, time_point, num_written))
+    }
+    auto const num_old_ids = old_ids.size();
+    auto const num_renamings = p_renamings.size();
+    vector<string> names;
+    unordered_map<string, size_t> name_numbers;
+    auto const number_name = [&names, &name_numbers](string const& p_name)
+    {
+        auto const result = name_numbers.emplace(p_name, names.size());
+        if (result.second) names.push_back(p_name);
+        return result.first->second;
+    };
+    vector<size_t> stages;
+    stages.reserve((num_renamings + 1) * num_old_ids);
+    for (auto const old_id: old_ids)
+    {
+        stages.push_back(number_name(id_to_activity(old_id)));
+    }
+    for (auto const& renaming: p_renamings)
+    {
+        unordered_map<size_t, size_t> replacements;
+        auto const previous = stages.size() - num_old_ids;
+        for (size_t j = 0; j != num_old_ids; ++j)
         {
-            ++num_written; 
+            auto const name_number = stages[previous + j];
+            auto it = replacements.find(name_number);
+            if (it == replacements.end())
+            {
+                auto const replacement =
+                    renaming.first->replace(names[name_number], renaming.second);
+                it = replacements.emplace(name_number, number_name(replacement)).first;
+            }
+            stages.push_back(it->second);
         }
     }
-    assert (num_written <= m_entries.size());
-    while (m_entries.size() != num_written)
+
+    // Map the ID of each renamed activity to the ID of its final name. Each
+    // final name is registered once here, so that its ID remains valid
+    // throughout, even if all the entries that previously referred to it are
+    // themselves renamed.
+    vector<ActivityId> new_ids(m_activity_table.size());
+    vector<ActivityId> registered_ids;
+    auto const final_stage = num_renamings * num_old_ids;
+    for (size_t j = 0; j != num_old_ids; ++j)
     {
-        pop_entry();
+        auto const old_id = old_ids[j];
+        new_ids[old_id] = old_id;
+        if (stages[final_stage + j] != stages[j])
+        {
+            new_ids[old_id] = register_activity_reference(names[stages[final_stage + j]]);
+            registered_ids.push_back(new_ids[old_id]);
+        }
     }
-    transaction.commit();
-    return num_amended;
-}
 
-vector<Stint>
-TimeLog::Impl::get_stints
-(   ActivityFilter const& p_activity_filter,
-    TimePoint const* p_begin,
-    TimePoint const* p_end
-)
-{
-    load();
-    vector<Stint> ret;
-    auto const e = m_entries.end();
-    auto it = (p_begin ? find_entry_just_before(*p_begin) : m_entries.begin());
-    auto const n = now();
-    for ( ; (it != e) && (!p_end || (it->time_point < *p_end)); ++it)
-    {
-        string const& activity = id_to_activity(it->activity_id);
-        if (p_activity_filter.matches(activity))
-        {
-            auto tp = it->time_point;
-            if (p_begin && (tp < *p_begin)) tp = *p_begin;
-            auto const next_it = it + 1;
-            auto const done = (next_it == e);
-            auto next_tp = (done ? (n > tp ? n: tp) : next_it->time_point);
-            if (p_end && (next_tp > *p_end)) next_tp = *p_end;
-            assert (next_tp >= tp);
-            assert (!p_begin || (tp >= *p_begin));
-            assert (!p_end || (next_tp <= *p_end));
-            auto const duration = next_tp - tp;
-            auto const seconds = chrono::duration_cast<Seconds>(duration);
-            Interval const interval(tp, seconds, done);
-            ret.push_back(Stint(activity, interval));
+    // Then rewrite m_entries in a single pass, dropping any entry that would
+    // have the same activity as the one before it, and tallying the changes
+    // in reference counts rather than applying them entry by entry.
+    auto const num_activity_ids = m_activity_table.size();
+    vector<ReferenceCount> num_gained(num_activity_ids, 0);
+    vector<ReferenceCount> num_lost(num_activity_ids, 0);
+    vector<vector<Stint>::size_type> ret(num_renamings, 0);
+    EntryIndex const num_entries = m_entries.size();
+    EntryIndex num_written = 0;
+    size_t previous_position = 0;
+
+    // Keep track of which closed segment each entry belongs to, so that only
+    // the segments that are changed need be rewritten.
+    assert (m_num_unloaded_segments == 0);
+    auto segment = m_segments.begin();
+    for (EntryIndex num_read = 0; num_read != num_entries; ++num_read)
+    {
+        for ( ; (segment != m_segments.end()) && (segment->end == num_read); ++segment)
+        {
+            segment->end = num_written;
         }
-    }
-    return ret;
-}
+        auto const old_id = m_entries.activity_id(num_read);
+        auto const new_id = new_ids[old_id];
+        auto const seconds = m_entries.seconds(num_read);
+        auto const position = old_id_positions[old_id];
+
+        // Count the renamings that change this entry, up to and including any
+        // after which it has the same activity as the entry before it. Had
+        // the renamings been applied one at a time, it would then have been
+        // dropped, so that later ones would not count it.
+        for (size_t k = 1; k <= num_renamings; ++k)
+        {
+            auto const stage = k * num_old_ids;
+            if (stages[stage + position] != stages[stage - num_old_ids + position])
+            {
+                ++ret[k - 1];
+            }
+            if
+            (   (num_read != 0) &&
+                (stages[stage + position] == stages[stage + previous_position])
+            )
+            {
+                break;
+            }
+        }
+        previous_position = position;
 
-string
-TimeLog::Impl::last_activity_to_match(string const& p_regex)
-{
-    load();
-    RegexActivityFilter const activity_filter(p_regex);
-    for (auto rit = m_entries.rbegin(); rit != m_entries.rend(); ++rit)  // reverse
+        auto modified = (new_id != old_id);
+        if (modified)
+        {
+            ++num_lost[old_id];
+            ++num_gained[new_id];
+        }
+        if ((num_written != 0) && (m_entries.activity_id(num_written - 1) == new_id))
+        {
+            // avoid consecutive entries with the same activity
+            ++num_lost[new_id];
+            modified = true;
+        }
+        else
+        {
+            if
+            (   (m_entries.activity_id(num_written) != new_id) ||
+                (m_entries.seconds(num_written) != seconds)
+            )
+            {
+                m_num_unchanged_entries = min(m_num_unchanged_entries, num_written);
+                m_entries.set(num_written, new_id, seconds);
+            }
+            ++num_written;
+        }
+        if (modified && (segment != m_segments.end()))
+        {
+            segment->modified = true;
+        }
+    }
+    for ( ; segment != m_segments.end(); ++segment)
+    {
+        segment->end = num_written;
+    }
+    assert (num_written <= m_entries.size());
+    m_entries.truncate(num_written);
+    m_num_unchanged_entries = min(m_num_unchanged_entries, num_written);
+
+    // Apply the changes in reference counts, leaving one reference to be
+    // released by deregister_activity_reference, so that any activity no
+    // longer referred to is deleted; and finally release the references
+    // taken above.
+    for (ActivityId i = 0; i != num_activity_ids; ++i)
     {
-        auto const& activity = id_to_activity(rit->activity_id);
-        if (!activity.empty() && activity_filter.matches(activity))
+        if ((num_gained[i] != 0) || (num_lost[i] != 0))
         {
-            return activity;
+            auto& reference_count = m_activity_table[i].reference_count;
+            assert (reference_count + num_gained[i] >= num_lost[i]);
+            reference_count = reference_count + num_gained[i] + 1 - num_lost[i];
+            deregister_activity_reference(i);
         }
     }
-    return string();
+    for (auto const activity_id: registered_ids)
+    {
+        deregister_activity_reference(activity_id);
+    }
+    transaction.commit();
+    return ret;
 }
 
-vector<string>
-TimeLog::Impl::last_activities(size_t p_num)
+size_t
+TimeLog::Impl::compact(Compression p_compression)
 {
-    load();
-    vector<string> ret;
-    if (m_entries.empty())
+    if
+    (   (p_compression == Compression::compressed) &&
+        !archive_compression_is_available()
+    )
     {
-        return ret;
+        throw runtime_error("This build does not support compression.");
     }
-    assert (m_entries.size() >= 1);
-    for (auto rit = m_entries.rbegin(); rit != m_entries.rend(); ++rit)  // reverse
+    Transaction transaction(*this);
+    size_t ret = 0;
+    for (auto& segment: m_segments)
     {
-        if (ret.size() == p_num)
+        auto encoding = SegmentEncoding::archive;
+        switch (p_compression)
         {
+        case Compression::unchanged:
+            if (segment.encoding == SegmentEncoding::compressed_archive)
+            {
+                encoding = SegmentEncoding::compressed_archive;
+            }
+            break;
+        case Compression::compressed:
+            encoding = SegmentEncoding::compressed_archive;
+            break;
+        case Compression::uncompressed:
             break;
         }
-        auto const& activity = id_to_activity(rit->activity_id);
-        if (!activity.empty() && (ret.empty() || (activity != ret.back())))
+        if (segment.encoding != encoding)
         {
-            ret.push_back(activity);
+            segment.encoding = encoding;
+            segment.modified = true;
+            ++ret;
         }
     }
-    assert (ret.size() <= p_num);
-    assert (ret.size() <= m_entries.size());
+    transaction.commit();
     return ret;
 }
 
-TimePoint
-TimeLog::Impl::last_entry_time(size_t p_ago)
+vector<Stint>
+TimeLog::Impl::get_stints
+(   ActivityFilter const& p_activity_filter,
+    TimePoint const* p_begin,
+    TimePoint const* p_end
+)
 {
-    load();
-    if (p_ago >= m_entries.size())
-    {
-        return TimePoint::min();
-    }
-    assert (m_entries.size() >= 1);
-    auto const index = m_entries.size() - 1 - p_ago;
-    assert (index < m_entries.size());
-    return m_entries[index].time_point;
+    vector<Stint> ret;
+    for_each_stint
+    (   p_activity_filter,
+        p_begin,
+        p_end,
+        [&ret](Stint const& p_stint) { ret.push_back(p_stint); }
+    );
+    return ret;
 }
 
-bool
-TimeLog::Impl::is_active()
+void
+TimeLog::Impl::for_each_stint
+(   ActivityFilter const& p_activity_filter,
+    TimePoint const* p_begin,
+    TimePoint const* p_end,
+    StintVisitor const& p_visitor
+)
 {
-    load();
-    return !(m_entries.empty() || activity_at(m_entries.back()).empty());
+    if (p_begin)
+    {
+        load_since(*p_begin);
+    }
+    else
+    {
+        load();
+    }
+    visit_stints(p_activity_filter, p_begin, p_end, p_visitor);
 }
 
-bool
-TimeLog::Impl::has_activity(string const& p_activity)
+map<string, ActivityStats>
+TimeLog::Impl::get_activity_stats
+(   ActivityFilter const& p_activity_filter,
+    TimePoint const* p_begin,
+    TimePoint const* p_end
+)
 {
-    load();
-    return m_activity_registry.find(p_activity) != m_activity_registry.end();
-}
+    if (p_begin)
+    {
+        load_since(*p_begin);
+    }
+    else
+    {
+        load();
+    }
+    ActivityStatsTable activity_stats_table(m_activity_table.size());
+    accumulate_activity_stats(p_activity_filter, p_begin, p_end, activity_stats_table);
 
-void
-TimeLog::Impl::clear_cache()
-{
-    m_entries.clear();
-    m_activity_registry.clear();
-    mark_cache_as_stale();
+    // Each name is looked up, and copied, just once.
+    map<string, ActivityStats> ret;
+    for (ActivityId i = 0; i != m_activity_table.size(); ++i)
+    {
+        if (activity_stats_table.contains(i))
+        {
+            ret.emplace(id_to_activity(i), activity_stats_table.at(i));
+        }
+    }
+    return ret;
 }
 
 void
-TimeLog::Impl::mark_cache_as_stale()
+TimeLog::Impl::accumulate_activity_stats
+(   ActivityFilter const& p_activity_filter,
+    TimePoint const* p_begin,
+    TimePoint const* p_end,
+    ActivityStatsTable& p_activity_stats_table
+)
 {
-    m_loaded = false;
-}
+    auto const add_stint = [this, &p_activity_stats_table]
+    (   EntryIndex p_index,
+        Interval const& p_interval
+    )
+    {
+        p_activity_stats_table.add
+        (   m_entries.activity_id(p_index),
+            ActivityStats
+            (   p_interval.duration().count(),
+                p_interval.beginning(),
+                p_interval.ending()
+            )
+        );
+    };
 
-void
-TimeLog::Impl::load()
-{
-    assert_valid();
-    if (!m_loaded)
+    if (p_begin && (seconds_to_time_point(time_point_to_seconds(*p_begin)) != *p_begin))
     {
-        clear_cache();
-        if (file_exists_at(m_filepath))
-        {
-            ifstream infile(m_filepath.c_str());
-            enable_exceptions(infile);
-            string line;
-            size_t line_number = 1;
-            while (infile.peek() != EOF)
+        // A stint clipped to begin part-way through a second also ends
+        // part-way through a second, as its duration is in whole seconds; so
+        // its ending would be misplaced if it were split at a midnight. (Such
+        // a range does not arise from the command line.)
+        visit_stint_intervals(p_activity_filter, p_begin, p_end, add_stint);
+        return;
+    }
+
+    // Find the days in the rollup that lie wholly within the range. If only a
+    // suffix of the log has been loaded, the rollup covers only the whole days
+    // after its first entry; but as that entry is no later than the beginning
+    // of the range, these include every whole day in the range.
+    update_rollup(m_entries, m_rollup);
+    auto first = m_rollup.begin();
+    auto last = m_rollup.end();
+    if (p_begin)
+    {
+        first = std::partition_point
+        (   first,
+            last,
+            [p_begin](RollupDay const& p_day)
             {
-                getline(infile, line);
-                pair<string, TimePoint> const parsed_line = parse_line(line, line_number);
-                auto const& activity = parsed_line.first;
-                auto const& time_point = parsed_line.second;
-                if (!m_entries.empty() && (time_point < m_entries.back().time_point))
-                {
-                    ostringstream oss;
-                    enable_exceptions(oss);
-                    oss << "Time log entries out of order at line " << line_number << '.'; 
-                    throw runtime_error(oss.str());
-                }
-                push_entry(activity, time_point);
-                ++line_number;
+                return seconds_to_time_point(p_day.begin) < *p_begin;
             }
-            if (!m_entries.empty() && (m_entries.back().time_point > now()))
+        );
+    }
+    if (p_end)
+    {
+        last = std::partition_point
+        (   first,
+            last,
+            [p_end](RollupDay const& p_day)
             {
-                throw runtime_error
-                (   "The final entry in the time log is future-dated. "
-                    "Future dated entries are not supported."
-                );
+                return seconds_to_time_point(p_day.end) <= *p_end;
             }
-        }
-        m_loaded = true;
+        );
     }
-    assert_valid();
-}
-
-void
-TimeLog::Impl::save() const
-{
-    assert_valid();
-    AtomicWriter writer(m_filepath);
-    for (auto const& entry: m_entries)
+    if (first == last)
     {
-        write_entry(writer, activity_at(entry), entry.time_point);
+        visit_stint_intervals(p_activity_filter, p_begin, p_end, add_stint);
+        return;
     }
-    assert_valid();
-    writer.commit();
-    assert_valid();
-}
 
-TimeLog::Impl::ActivityId
-TimeLog::Impl::register_activity_reference(string const& p_activity)
-{
-    auto const it = m_activity_registry.find(p_activity);
-    if (it == m_activity_registry.end())
+    // The whole days are summarised from the rollup, and only the partial
+    // days at either end from the entries.
+    auto const days_begin = seconds_to_time_point(first->begin);
+    auto const days_end = seconds_to_time_point((last - 1)->end);
+    visit_stint_intervals(p_activity_filter, p_begin, &days_begin, add_stint);
+    FilterMemo filter_memo(m_activity_table, m_activity_trie, p_activity_filter);
+    for (auto it = first; it != last; ++it)
     {
-        return &*(m_activity_registry.emplace(p_activity, 1).first);
+        for (auto const& row: it->rows)
+        {
+            assert (m_activity_table[row.activity_id].reference_count != 0);
+            if (filter_memo.matches(row.activity_id))
+            {
+                p_activity_stats_table.add
+                (   row.activity_id,
+                    ActivityStats
+                    (   row.seconds,
+                        seconds_to_time_point(row.beginning),
+                        seconds_to_time_point(row.ending)
+                    )
+                );
+            }
+        }
+        if
+        (   it->has_boundary_stints &&
+            (!p_begin || (*p_begin < seconds_to_time_point(it->begin)))
+        )
+        {
+            add_boundary_stints(it->begin, filter_memo, p_activity_stats_table);
+        }
     }
-    ++it->second;
-    return &*it;
-}
-
-void
-TimeLog::Impl::deregister_activity_reference(ActivityId p_activity_id)
-{
-    assert (p_activity_id->second > 0);
-    auto const new_reference_count = --p_activity_id->second; 
-    if (new_reference_count == 0)
+    if (!p_end || (days_end < *p_end))
     {
-        // Pointer (p_activity_id) is stable, but iterator is not! We have
-        // to erase via the iterator or via key.
-        m_activity_registry.erase(p_activity_id->first);
+        add_boundary_stints((last - 1)->end, filter_memo, p_activity_stats_table);
     }
+    visit_stint_intervals(p_activity_filter, &days_end, p_end, add_stint);
 }
 
-string const&
-TimeLog::Impl::activity_at(Entry const& p_entry) const
-{
-    return id_to_activity(p_entry.activity_id);
-}
-
-void
-TimeLog::Impl::push_entry(string const& p_activity, TimePoint const& p_time_point)
+ActivityStats
+TimeLog::Impl::get_total_stats
+(   ActivityFilter const& p_activity_filter,
+    TimePoint const* p_begin,
+    TimePoint const* p_end
+)
 {
-    auto const next_activity_id = register_activity_reference(p_activity);
-    if (!m_entries.empty() && (next_activity_id == m_entries.back().activity_id))
+    if (p_begin)
     {
-        // avoid consecutive entries with the same activity
-        deregister_activity_reference(next_activity_id);
+        load_since(*p_begin);
     }
     else
     {
-        m_entries.emplace_back(next_activity_id, p_time_point);
+        load();
+    }
+    ActivityStats ret;
+    auto const begin_index = (p_begin ? find_entry_just_before(*p_begin) : 0);
+    auto const end_index =
+        (p_end ? max(find_entry_not_before(*p_end), begin_index) : m_entries.size());
+    if (begin_index == end_index)
+    {
+        return ret;
     }
-}
-
-bool
-TimeLog::Impl::put_entry
-(   string const& p_activity,
-    TimePoint const& p_time_point,
-    Entries::size_type p_index
-)
-{
-    auto const old_activity_id = m_entries[p_index].activity_id;
-    auto const new_activity_id = register_activity_reference(p_activity);
 
-    // prevent consecutive identical activities
-    if ((p_index != 0) && (m_entries[p_index - 1].activity_id == new_activity_id))
+    // Time spent inactive is not counted.
+    FilterMemo filter_memo(m_activity_table, m_activity_trie, p_activity_filter);
+    auto activity_ids = filter_memo.matching_activity_ids();
+    ActivityId inactive_id = 0;
+    auto const has_inactive = m_activity_registry.find(string(), inactive_id);
+    auto const is_counted = [&](EntryIndex p_index)
     {
-        deregister_activity_reference(new_activity_id);
-        return false;
+        auto const activity_id = m_entries.activity_id(p_index);
+        return
+            !(has_inactive && (activity_id == inactive_id)) &&
+            filter_memo.matches(activity_id);
+    };
+    if (has_inactive)
+    {
+        activity_ids.erase
+        (   std::remove(activity_ids.begin(), activity_ids.end(), inactive_id),
+            activity_ids.end()
+        );
     }
-    deregister_activity_reference(old_activity_id);
-    m_entries[p_index] = Entry(new_activity_id, p_time_point);
-    return true;
-}
 
-void
-TimeLog::Impl::pop_entry()
+    // The stints at either end of the range may be clipped to it, or still
+    // open, so are measured individually. Each stint in between both begins
+    // and ends at an entry.
+    auto const n = now();
+    auto const add_stint = [&](EntryIndex p_index)
+    {
+        if (is_counted(p_index))
+        {
+            auto const interval = stint_interval(p_index, p_begin, p_end, n);
+            ret += ActivityStats
+            (   interval.duration().count(),
+                interval.beginning(),
+                interval.ending()
+            );
+        }
+    };
+    add_stint(begin_index);
+    if (end_index - begin_index == 1)
+    {
+        return ret;
+    }
+    add_stint(end_index - 1);
+    auto const inner_begin = begin_index + 1;
+    auto const inner_end = end_index - 1;
+    if (inner_begin == inner_end)
+    {
+        return ret;
+    }
+    EpochSeconds seconds = 0;
+    auto first = inner_end;  // index of first counted entry
+    auto last = inner_begin;  // index of entry following last counted entry
+    if (activity_ids.size() + (has_inactive ? 1 : 0) == m_activity_registry.size())
+    {
+        // Every activity other than inactivity is counted, so the total is
+        // just the time elapsed, less the time spent inactive.
+        seconds = m_entries.seconds(inner_end) - m_entries.seconds(inner_begin);
+        if (has_inactive)
+        {
+            seconds -= m_entries.activity_seconds(inactive_id, inner_begin, inner_end);
+        }
+        first = inner_begin;
+        while ((first != inner_end) && !is_counted(first)) ++first;
+        last = inner_end;
+        while ((last != first) && !is_counted(last - 1)) --last;
+    }
+    else
+    {
+        for (auto const activity_id: activity_ids)
+        {
+            auto const& postings = m_entries.postings(activity_id);
+            auto const b =
+                std::lower_bound(postings.begin(), postings.end(), inner_begin);
+            auto const f = std::lower_bound(b, postings.end(), inner_end);
+            if (b != f)
+            {
+                seconds +=
+                    m_entries.activity_seconds(activity_id, inner_begin, inner_end);
+                first = min(first, *b);
+                last = max(last, *(f - 1) + 1);
+            }
+        }
+    }
+    if (first < last)
+    {
+        ret += ActivityStats
+        (   seconds,
+            m_entries.time_point(first),
+            m_entries.time_point(last)
+        );
+    }
+    return ret;
+}
+
+void
+TimeLog::Impl::visit_stints
+(   ActivityFilter const& p_activity_filter,
+    TimePoint const* p_begin,
+    TimePoint const* p_end,
+    StintVisitor const& p_visitor
+)
 {
-    deregister_activity_reference(m_entries.back().activity_id);
-    m_entries.pop_back();
+    visit_stint_intervals
+    (   p_activity_filter,
+        p_begin,
+        p_end,
+        [this, &p_visitor](EntryIndex p_index, Interval const& p_interval)
+        {
+            auto const& record = m_activity_table[m_entries.activity_id(p_index)];
+            p_visitor(Stint(record.name, p_interval));
+        }
+    );
+}
+
+template <typename Visitor>
+void
+TimeLog::Impl::visit_stint_intervals
+(   ActivityFilter const& p_activity_filter,
+    TimePoint const* p_begin,
+    TimePoint const* p_end,
+    Visitor p_visitor
+)
+{
+    auto const e = m_entries.size();
+    auto const begin_index = (p_begin ? find_entry_just_before(*p_begin) : 0);
+    auto const end_index =
+        (p_end ? max(find_entry_not_before(*p_end), begin_index) : e);
+    auto const n = now();
+    auto const visit = [&](EntryIndex i)
+    {
+        p_visitor(i, stint_interval(i, p_begin, p_end, n));
+    };
+
+    FilterMemo filter_memo(m_activity_table, m_activity_trie, p_activity_filter);
+    auto const activity_ids = filter_memo.matching_activity_ids();
+    EntryIndex num_matching_entries = 0;
+    for (auto const activity_id: activity_ids)
+    {
+        num_matching_entries += m_activity_table[activity_id].reference_count;
+    }
+    if (num_matching_entries * k_posting_list_threshold >= e)
+    {
+        for (auto i = begin_index; i != end_index; ++i)
+        {
+            if (filter_memo.matches(m_entries.activity_id(i))) visit(i);
+        }
+        return;
+    }
+
+    // Merge the parts of the matching activities' posting lists that lie
+    // within the range, visiting the entries in ascending order.
+    using Cursor = pair<PostingList::const_iterator, PostingList::const_iterator>;
+    auto const is_later = [](Cursor const& lhs, Cursor const& rhs)
+    {
+        return *lhs.first > *rhs.first;
+    };
+    priority_queue<Cursor, vector<Cursor>, decltype(is_later)> cursors(is_later);
+    for (auto const activity_id: activity_ids)
+    {
+        auto const& postings = m_entries.postings(activity_id);
+        auto const b = std::lower_bound(postings.begin(), postings.end(), begin_index);
+        auto const f = std::lower_bound(b, postings.end(), end_index);
+        if (b != f) cursors.emplace(b, f);
+    }
+    while (!cursors.empty())
+    {
+        auto cursor = cursors.top();
+        cursors.pop();
+        visit(*cursor.first);
+        if (++cursor.first != cursor.second) cursors.push(cursor);
+    }
+}
+
+string
+TimeLog::Impl::last_activity_to_match(string const& p_regex)
+{
+    load();
+    RegexActivityFilter const activity_filter(p_regex);
+    FilterMemo filter_memo(m_activity_table, m_activity_trie, activity_filter);
+    for (auto i = m_entries.size(); i != 0; --i)  // reverse
+    {
+        auto const& activity = activity_at(i - 1);
+        if (!activity.empty() && filter_memo.matches(m_entries.activity_id(i - 1)))
+        {
+            return activity;
+        }
+    }
+    return string();
+}
+
+vector<string>
+TimeLog::Impl::last_activities(size_t p_num)
+{
+    // We don't know how many entries will be needed, so load progressively more
+    // of them until we find enough activities, or run out of entries.
+    vector<string> ret;
+    for (EntryIndex num_entries = p_num; ; num_entries = m_entries.size() * 2)
+    {
+        load_last(num_entries);
+        ret.clear();
+        for (auto i = m_entries.size(); i != 0; --i)  // reverse
+        {
+            if (ret.size() == p_num)
+            {
+                break;
+            }
+            auto const& activity = activity_at(i - 1);
+            if (!activity.empty() && (ret.empty() || (activity != ret.back())))
+            {
+                ret.push_back(activity);
+            }
+        }
+        if ((ret.size() == p_num) || m_complete)
+        {
+            break;
+        }
+    }
+    assert (ret.size() <= p_num);
+    assert (ret.size() <= m_entries.size());
+    return ret;
+}
+
+TimePoint
+TimeLog::Impl::last_entry_time(size_t p_ago)
+{
+    load_last(p_ago + 1);
+    if (p_ago >= m_entries.size())
+    {
+        return TimePoint::min();
+    }
+    assert (m_entries.size() >= 1);
+    auto const index = m_entries.size() - 1 - p_ago;
+    assert (index < m_entries.size());
+    return m_entries.time_point(index);
+}
+
+bool
+TimeLog::Impl::is_active()
+{
+    load_last(1);
+    return !(m_entries.empty() || activity_at(m_entries.size() - 1).empty());
+}
+
+bool
+TimeLog::Impl::has_activity(string const& p_activity)
+{
+    load_last(1);
+    if (m_segments.empty())
+    {
+        load();
+        return m_activity_registry.contains(p_activity);
+    }
+
+    // The activities in the closed segments are listed in the manifest, so
+    // only the log file itself need be loaded.
+    load_suffix([this]() { return m_suffix_offset == 0; });
+    if (m_activity_registry.contains(p_activity))
+    {
+        return true;
+    }
+    for (auto const& segment: m_segments)
+    {
+        auto const& activities = segment.activities;
+        if (std::binary_search(activities.begin(), activities.end(), p_activity))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+TimeLog::Impl::clear_cache()
+{
+    m_entries.clear();
+    m_activity_table.clear();
+    m_activity_registry.clear();
+    m_free_activity_ids.clear();
+    m_activity_trie.clear();
+    m_rollup.clear();
+    m_segments.clear();
+    m_num_unloaded_segments = 0;
+    m_manifest_signature = FileSignature();
+    m_manifest_hash = 0;
+    m_file_signature = FileSignature();
+    m_file_tail_hash = 0;
+    m_num_saved_entries = m_num_unchanged_entries = 0;
+    m_last_saved_entry_offset = k_unknown_offset;
+    m_file_ends_with_newline = true;
+    m_complete = true;
+    m_suffix_offset = 0;
+    mark_cache_as_stale();
+}
+
+void
+TimeLog::Impl::mark_cache_as_stale()
+{
+    m_loaded = false;
+}
+
+void
+TimeLog::Impl::load()
+{
+    assert_valid();
+    if (!m_loaded || !m_complete)
+    {
+        if (!m_loaded)
+        {
+            TailWriter::recover(m_filepath);
+            m_loaded = reload_tail();
+        }
+        if (!m_loaded || !m_complete)
+        {
+            clear_cache();
+            load_manifest();
+            if (file_exists_at(m_filepath))
+            {
+                auto const signature = file_signature(m_filepath);
+                MappedFile const file(m_filepath);
+                auto const file_tail_hash = tail_hash(file.begin(), file.end());
+                m_file_signature = signature;
+                m_file_tail_hash = file_tail_hash;
+                auto const indexed = (m_use_index && load_index(file));
+                if (!indexed)
+                {
+                    clear_cache();
+                    load_manifest();
+                    m_file_signature = signature;
+                    m_file_tail_hash = file_tail_hash;
+                    load_segments();
+                    load_text(file);
+                }
+                m_num_saved_entries = m_num_unchanged_entries = m_entries.size();
+                if (m_use_index && !indexed)
+                {
+                    update_rollup(m_entries, m_rollup);
+                    save_index();
+                }
+            }
+            else
+            {
+                load_segments();
+                m_num_saved_entries = m_num_unchanged_entries = m_entries.size();
+            }
+            m_loaded = true;
+        }
+        throw_if_future_dated();
+    }
+    assert (m_complete);
+    assert_valid();
+}
+
+void
+TimeLog::Impl::throw_if_future_dated() const
+{
+    if (!m_entries.empty() && (m_entries.time_point(m_entries.size() - 1) > now()))
+    {
+        throw runtime_error
+        (   "The final entry in the time log is future-dated. "
+            "Future dated entries are not supported."
+        );
+    }
+}
+
+unsigned long long
+TimeLog::Impl::tail_hash(char const* p_begin, char const* p_end)
+{
+    auto const size = static_cast<unsigned long long>(p_end - p_begin);
+    auto const begin = ((size > k_tail_hash_size)? (p_end - k_tail_hash_size): p_begin);
+    return hash_bytes(begin, p_end);
+}
+
+void
+TimeLog::Impl::throw_out_of_order(MappedFile const& p_file, char const* p_position)
+{
+    ostringstream oss;
+    enable_exceptions(oss);
+    oss << "Time log entries out of order at line "
+        << line_number_at(p_file, p_position) << '.';
+    throw runtime_error(oss.str());
+}
+
+void
+TimeLog::Impl::load_archive(MappedFile const& p_file)
+{
+    ArchivedEntries archived;
+    decode_archive(p_file.begin(), p_file.end(), archived);
+    if (!append_entries(archived))
+    {
+        throw runtime_error("Time log entries out of order in archive.");
+    }
+}
+
+bool
+TimeLog::Impl::append_entries(ArchivedEntries const& p_entries)
+{
+    // Register each activity once, rather than once for each entry, then
+    // release those references once the entries hold their own.
+    vector<ActivityId> activity_ids;
+    activity_ids.reserve(p_entries.activities.size());
+    for (auto const& activity: p_entries.activities)
+    {
+        activity_ids.push_back(register_activity_reference(activity));
+    }
+    auto const num_entries = p_entries.seconds.size();
+    m_entries.reserve(m_entries.size() + num_entries);
+    auto in_order = true;
+    for (decltype(p_entries.seconds.size()) i = 0; i != num_entries; ++i)
+    {
+        auto const seconds = p_entries.seconds[i];
+        auto const activity_id = activity_ids[p_entries.activity_numbers[i]];
+        if (!m_entries.empty())
+        {
+            auto const last = m_entries.size() - 1;
+            if (seconds < m_entries.seconds(last))
+            {
+                in_order = false;
+                break;
+            }
+            if (activity_id == m_entries.activity_id(last))
+            {
+                continue;  // avoid consecutive entries with the same activity
+            }
+        }
+        ++m_activity_table[activity_id].reference_count;
+        m_entries.push_back(activity_id, seconds);
+    }
+    for (auto const activity_id: activity_ids)
+    {
+        deregister_activity_reference(activity_id);
+    }
+    return in_order;
+}
+
+void
+TimeLog::Impl::load_text
+(   MappedFile const& p_file,
+    unsigned long long p_begin,
+    unsigned long long p_end
+)
+{
+    auto const file_begin = p_file.begin();
+    auto const end = ((p_end == k_unknown_offset)? p_file.end(): (file_begin + p_end));
+    assert (p_begin <= static_cast<unsigned long long>(end - file_begin));
+    auto begin = file_begin + p_begin;
+    auto const num_chunks = LogTextParser::num_chunks(end - begin);
+    if (num_chunks > 1)
+    {
+        begin = load_text_in_parallel(p_file, begin, end, num_chunks);
+    }
+    string activity;
+    for (auto line_begin = begin; line_begin != end; )
+    {
+        auto const newline = static_cast<char const*>
+        (   memchr(line_begin, '\n', end - line_begin)
+        );
+        m_file_ends_with_newline = (newline != nullptr);
+        auto const line_end = (newline ? newline : end);
+        auto const time_point = m_text_parser.parse_line
+        (   m_time_stamp_parser,
+            p_file,
+            line_begin,
+            line_end,
+            activity
+        );
+        if
+        (   !m_entries.empty() &&
+            (time_point < m_entries.time_point(m_entries.size() - 1))
+        )
+        {
+            throw_out_of_order(p_file, line_begin);
+        }
+        auto const num_entries = m_entries.size();
+        push_entry(activity, time_point);
+        if (m_entries.size() != num_entries)
+        {
+            m_last_saved_entry_offset = line_begin - file_begin;
+        }
+        line_begin = (newline ? newline + 1 : end);
+    }
+}
+
+char const*
+TimeLog::Impl::load_text_in_parallel
+(   MappedFile const& p_file,
+    char const* p_begin,
+    char const* p_end,
+    unsigned long long p_num_chunks
+)
+{
+    assert (p_num_chunks > 1);
+
+    // Each parser begins with the previous offset of m_time_stamp_parser, as
+    // is correct for the first chunk, and nearly always harmless for the
+    // others.
+    auto const initial_previous_offset = m_time_stamp_parser.previous_offset();
+    auto const chunks = m_text_parser.parse_chunks
+    (   p_file,
+        p_begin,
+        p_end,
+        p_num_chunks,
+        initial_previous_offset
+    );
+
+    // Merge the chunks in order, checking the order of the entries across
+    // each boundary between chunks.
+    auto previous_offset = initial_previous_offset;
+    for (auto const& chunk: chunks)
+    {
+        if (chunk.begin == chunk.end)
+        {
+            continue;
+        }
+        if
+        (   chunk.failed ||
+            !m_text_parser.parses_alike
+            (   chunk.begin,
+                chunk.end,
+                chunk.initial_previous_offset,
+                previous_offset
+            )
+        )
+        {
+            m_time_stamp_parser.set_previous_offset(previous_offset);
+            return chunk.begin;
+        }
+        if
+        (   !m_entries.empty() &&
+            (chunk.entries.seconds.front() < m_entries.seconds(m_entries.size() - 1))
+        )
+        {
+            throw_out_of_order(p_file, chunk.begin);
+        }
+        auto const num_entries = m_entries.size();
+        auto const in_order = append_entries(chunk.entries);
+        assert (in_order);
+        (void)in_order;  // silence compiler re. unused variable in release build
+        if (m_entries.size() != num_entries)
+        {
+            m_last_saved_entry_offset = chunk.last_entry_offset;
+        }
+        previous_offset = chunk.final_previous_offset;
+    }
+    m_time_stamp_parser.set_previous_offset(previous_offset);
+    m_file_ends_with_newline = (*(p_end - 1) == '\n');
+    return p_end;
+}
+
+bool
+TimeLog::Impl::reload_tail()
+{
+    if
+    (   !m_file_signature.exists ||
+        (m_num_saved_entries == 0) ||
+        (m_num_unchanged_entries + 1 < m_num_saved_entries) ||
+        (m_last_saved_entry_offset == k_unknown_offset) ||
+        !file_exists_at(m_filepath) ||
+        !manifest_is_current()
+    )
+    {
+        return false;
+    }
+    auto const signature = file_signature(m_filepath);
+    if
+    (   (signature.device != m_file_signature.device) ||
+        (signature.inode != m_file_signature.inode) ||
+        (signature.size < m_file_signature.size)
+    )
+    {
+        return false;
+    }
+    MappedFile const file(m_filepath);
+    auto const old_end = file.begin() + m_file_signature.size;
+    if
+    (   (file.size() < m_file_signature.size) ||
+        (tail_hash(file.begin(), old_end) != m_file_tail_hash)
+    )
+    {
+        return false;
+    }
+
+    // The file has at most been appended to. Discard the last saved entry,
+    // and anything after it, since the lines appended to the file may
+    // continue the line from which it was parsed, or have the same activity.
+    while (m_entries.size() >= m_num_saved_entries)
+    {
+        pop_entry();
+    }
+    m_file_signature = signature;
+    m_file_tail_hash = tail_hash(file.begin(), file.end());
+    try
+    {
+        load_text(file, m_last_saved_entry_offset);
+    }
+    catch (...)
+    {
+        clear_cache();
+        throw;
+    }
+    m_num_saved_entries = m_num_unchanged_entries = m_entries.size();
+    return true;
+}
+
+bool
+TimeLog::Impl::load_index(MappedFile const& p_file)
+{
+    if (!file_exists_at(m_index_filepath))
+    {
+        return false;
+    }
+    try
+    {
+        MappedFile const index_file(m_index_filepath);
+        LogIndexReader reader(index_file.begin(), index_file.end());
+
+        // Check that the index was derived from the log file as it now stands.
+        LogIndexHeader header;
+        if
+        (   !reader.read_header(header) ||
+            (header.manifest_hash != m_manifest_hash) ||
+            (header.segment_ends.size() != m_segments.size()) ||
+            (header.file_signature != m_file_signature) ||
+            (header.file_signature.size != p_file.size()) ||
+            (header.file_tail_hash != m_file_tail_hash) ||
+            (header.settings_hash != settings_hash())
+        )
+        {
+            return false;
+        }
+
+        // Read the activities and the entries, and the rollup, if it is
+        // valid. The activities are numbered in the index by their position
+        // in the activity table.
+        vector<string> activities;
+        Entries entries;
+        assert (m_rollup.empty());
+        if (!reader.read_body(activities, entries, m_rollup))
+        {
+            return false;
+        }
+        assert (m_activity_table.empty());
+        for (auto& activity: activities)
+        {
+            ActivityId const activity_id = m_activity_table.size();
+            m_activity_table.push_back
+            (   ActivityRecord{make_shared<string const>(std::move(activity)), 0}
+            );
+            auto const& name = *m_activity_table.back().name;
+            if (!m_activity_registry.insert(name, activity_id))
+            {
+                return false;
+            }
+            m_activity_trie.insert(name, activity_id);
+        }
+        for (EntryIndex i = 0; i != entries.size(); ++i)
+        {
+            ++m_activity_table[entries.activity_id(i)].reference_count;
+        }
+        for (auto const& record: m_activity_table)
+        {
+            if (record.reference_count == 0)
+            {
+                return false;
+            }
+        }
+        m_entries.swap(entries);
+        m_entries.mark_unmodified();
+        for (decltype(m_segments.size()) i = 0; i != m_segments.size(); ++i)
+        {
+            m_segments[i].end = header.segment_ends[i];
+        }
+
+        // As a final check that the time stamps are being interpreted
+        // consistently with the index (which will not be the case if, for
+        // example, the system time zone has been changed), reparse the time
+        // stamps of the first and last entries in the log file.
+        if (header.file_signature.size != 0)
+        {
+            auto const num_archived_entries =
+                (m_segments.empty()? 0: m_segments.back().end);
+            auto const first = m_entries.time_point(num_archived_entries);
+            auto const last = m_entries.time_point(m_entries.size() - 1);
+            if
+            (   !stamp_matches(p_file, 0, first) ||
+                !stamp_matches(p_file, header.last_saved_entry_offset, last)
+            )
+            {
+                return false;
+            }
+        }
+        m_last_saved_entry_offset = header.last_saved_entry_offset;
+        m_file_ends_with_newline = header.file_ends_with_newline;
+        return true;
+    }
+    catch (runtime_error&)
+    {
+        return false;
+    }
+}
+
+void
+TimeLog::Impl::save_index() const
+{
+    assert (m_complete);
+    if
+    (   (m_entries.size() != num_archived_entries()) &&
+        (m_last_saved_entry_offset == k_unknown_offset)
+    )
+    {
+        return;  // we would not be able to validate the index when reading it
+    }
+    try
+    {
+        LogIndexHeader header;
+        header.file_signature = m_file_signature;
+        header.file_tail_hash = m_file_tail_hash;
+        header.settings_hash = settings_hash();
+        header.last_saved_entry_offset = m_last_saved_entry_offset;
+        header.file_ends_with_newline = m_file_ends_with_newline;
+        header.manifest_hash = m_manifest_hash;
+        for (auto const& segment: m_segments)
+        {
+            header.segment_ends.push_back(segment.end);
+        }
+
+        // The rollup is saved only if it is up to date with the entries.
+        vector<RollupDay> const no_rollup;
+        auto const rollup_is_current = (m_entries.num_unmodified() == m_entries.size());
+        auto const& rollup = (rollup_is_current? m_rollup: no_rollup);
+        AtomicWriter writer(m_index_filepath);
+        writer.append(encode_log_index(header, m_activity_table, m_entries, rollup));
+        writer.commit();
+    }
+    catch (runtime_error&)
+    {
+        // The index will simply be rebuilt next time the log is loaded.
+    }
+}
+
+unsigned long long
+TimeLog::Impl::settings_hash() const
+{
+    // The terminating null character separates the format from the time zone.
+    auto const format = m_time_format.c_str();
+    auto ret = hash_bytes(format, format + m_time_format.size() + 1);
+    auto const time_zone = getenv("TZ");  // non-portable
+    if (time_zone)
+    {
+        ret = hash_bytes(time_zone, time_zone + strlen(time_zone), ret);
+    }
+    return ret;
+}
+
+bool
+TimeLog::Impl::stamp_matches
+(   MappedFile const& p_file,
+    unsigned long long p_offset,
+    TimePoint const& p_time_point
+)
+{
+    if (p_file.size() - p_offset < m_expected_time_stamp_length)
+    {
+        return false;
+    }
+    auto const time_stamp_begin = p_file.begin() + p_offset;
+    auto const time_stamp_end = time_stamp_begin + m_expected_time_stamp_length;
+    return m_time_stamp_parser.parse(time_stamp_begin, time_stamp_end) == p_time_point;
+}
+
+void
+TimeLog::Impl::save()
+{
+    assert_valid();
+    auto const num_entries = m_entries.size();
+    if (can_save_tail())
+    {
+        // Only the entries after m_num_unchanged_entries need to be written.
+        // If the last saved entry has been removed or changed, we overwrite the
+        // file from where that entry began; otherwise we simply append.
+        assert (m_num_unchanged_entries + 1 >= m_num_saved_entries);
+        if
+        (   (m_num_unchanged_entries == m_num_saved_entries) &&
+            (m_num_unchanged_entries == num_entries)
+        )
+        {
+            return;  // nothing has changed
+        }
+        auto const appending = (m_num_unchanged_entries == m_num_saved_entries);
+        auto offset = (appending ? m_file_signature.size : m_last_saved_entry_offset);
+        TailWriter writer(m_filepath, offset);
+        if (appending && !m_file_ends_with_newline)
+        {
+            writer.append("\n");
+            ++offset;
+        }
+        for (auto i = m_num_unchanged_entries; i != num_entries; ++i)
+        {
+            m_last_saved_entry_offset = offset;
+            offset += write_entry(writer, activity_at(i), m_entries.time_point(i));
+        }
+        if (num_entries == m_num_unchanged_entries)
+        {
+            // The entry just before the truncation point is now the last one,
+            // and we don't know where it begins.
+            m_last_saved_entry_offset = k_unknown_offset;
+        }
+        writer.commit();
+    }
+    else
+    {
+        if (!m_complete)
+        {
+            // We cannot rewrite the whole file without having loaded the whole
+            // log. Transaction ensures that this is reached only if the file
+            // has been changed by another process since we loaded it.
+            throw runtime_error
+            (   "The time log was changed by another process. "
+                "No changes have been saved."
+            );
+        }
+        save_segments();
+        AtomicWriter writer(m_filepath);
+        unsigned long long offset = 0;
+        m_last_saved_entry_offset = k_unknown_offset;
+        for (auto i = num_archived_entries(); i != num_entries; ++i)
+        {
+            m_last_saved_entry_offset = offset;
+            offset += write_entry(writer, activity_at(i), m_entries.time_point(i));
+        }
+        writer.commit();
+    }
+    m_file_signature = file_signature(m_filepath);
+    MappedFile const file(m_filepath);
+    m_file_tail_hash = tail_hash(file.begin(), file.end());
+    m_file_ends_with_newline = true;
+    m_num_saved_entries = m_num_unchanged_entries = num_entries;
+    if (m_segmentation != Segmentation::none)
+    {
+        try
+        {
+            rotate_segments();
+        }
+        catch (runtime_error& e)
+        {
+            // The changes have been saved regardless, and the rotation will be
+            // attempted again next time; but the in-memory data structures
+            // cannot be relied on.
+            clear_cache();
+            throw runtime_error
+            (   string("The changes were saved, but older entries could not be "
+                    "moved out of the time log into segments: ") + e.what()
+            );
+        }
+    }
+    if (m_use_index && m_complete)
+    {
+        update_rollup(m_entries, m_rollup);
+        save_index();
+    }
+    assert_valid();
+}
+
+bool
+TimeLog::Impl::can_save_tail() const
+{
+    if (!m_file_signature.exists || (m_num_unchanged_entries + 1 < m_num_saved_entries))
+    {
+        return false;
+    }
+    auto const is_modified = [](Segment const& p_segment) { return p_segment.modified; };
+    if (std::any_of(m_segments.begin(), m_segments.end(), is_modified))
+    {
+        return false;
+    }
+    if
+    (   (m_num_unchanged_entries != m_num_saved_entries) &&
+        (m_last_saved_entry_offset == k_unknown_offset)
+    )
+    {
+        return false;
+    }
+    // If the file has been changed by another process since we last read
+    // or wrote it, then the offsets we have recorded are meaningless.
+    return file_signature(m_filepath) == m_file_signature;
+}
+
+TimeLog::Impl::ActivityId
+TimeLog::Impl::register_activity_reference(string const& p_activity)
+{
+    ActivityId activity_id = 0;
+    if (m_activity_registry.find(p_activity, activity_id))
+    {
+        ++m_activity_table[activity_id].reference_count;
+        return activity_id;
+    }
+    activity_id = m_activity_table.size();
+    if (m_free_activity_ids.empty())
+    {
+        m_activity_table.push_back
+        (   ActivityRecord{make_shared<string const>(p_activity), 1}
+        );
+    }
+    else
+    {
+        activity_id = m_free_activity_ids.back();
+        m_free_activity_ids.pop_back();
+        m_activity_table[activity_id] =
+            ActivityRecord{make_shared<string const>(p_activity), 1};
+    }
+    m_activity_registry.insert(p_activity, activity_id);
+    m_activity_trie.insert(p_activity, activity_id);
+    return activity_id;
+}
+
+void
+TimeLog::Impl::deregister_activity_reference(ActivityId p_activity_id)
+{
+    auto& record = m_activity_table[p_activity_id];
+    assert (record.reference_count > 0);
+    if (--record.reference_count == 0)
+    {
+        m_activity_registry.erase(*record.name);
+        m_activity_trie.erase(*record.name);
+        m_free_activity_ids.push_back(p_activity_id);
+    }
+}
+
+string const&
+TimeLog::Impl::activity_at(EntryIndex p_index) const
+{
+    return id_to_activity(m_entries.activity_id(p_index));
+}
+
+void
+TimeLog::Impl::push_entry(string const& p_activity, TimePoint const& p_time_point)
+{
+    auto const next_activity_id = register_activity_reference(p_activity);
+    if
+    (   !m_entries.empty() &&
+        (next_activity_id == m_entries.activity_id(m_entries.size() - 1))
+    )
+    {
+        // avoid consecutive entries with the same activity
+        deregister_activity_reference(next_activity_id);
+    }
+    else
+    {
+        m_entries.push_back(next_activity_id, time_point_to_seconds(p_time_point));
+    }
 }
 
-pair<string, TimePoint>
-TimeLog::Impl::parse_line(string const& p_entry_string, size_t p_line_number) const
+bool
+TimeLog::Impl::put_entry
+(   string const& p_activity,
+    TimePoint const& p_time_point,
+    EntryIndex p_index
+)
 {
-    if (p_entry_string.size() < m_expected_time_stamp_length)
+    auto const old_activity_id = m_entries.activity_id(p_index);
+    auto const new_activity_id = register_activity_reference(p_activity);
+
+    // prevent consecutive identical activities
+    if ((p_index != 0) && (m_entries.activity_id(p_index - 1) == new_activity_id))
+    {
+        deregister_activity_reference(new_activity_id);
+        return false;
+    }
+    deregister_activity_reference(old_activity_id);
+    auto const seconds = time_point_to_seconds(p_time_point);
+    if
+    (   (m_entries.activity_id(p_index) != new_activity_id) ||
+        (m_entries.seconds(p_index) != seconds)
+    )
     {
-        ostringstream oss;
-        enable_exceptions(oss);
-        oss << "Error parsing the time log at line " << p_line_number << '.';
-        throw runtime_error(oss.str());
+        m_num_unchanged_entries = min(m_num_unchanged_entries, p_index);
+        m_entries.set(p_index, new_activity_id, seconds);
     }
-    auto it = p_entry_string.begin() + m_expected_time_stamp_length;
-    assert (it > p_entry_string.begin());
-    string const time_stamp(p_entry_string.begin(), it);
-    auto const time_point = long_time_stamp_to_point(time_stamp, m_time_format);
-    auto const activity = trim(string(it, p_entry_string.end()));
-    return make_pair(move(activity), move(time_point));
+    return true;
 }
 
 void
+TimeLog::Impl::pop_entry()
+{
+    deregister_activity_reference(m_entries.activity_id(m_entries.size() - 1));
+    m_entries.pop_back();
+    m_num_unchanged_entries = min(m_num_unchanged_entries, m_entries.size());
+
+    // The entry may have been loaded from a closed segment.
+    auto const num_entries = m_entries.size();
+    for
+    (   auto it = m_segments.rbegin();
+        (it != m_segments.rend() - m_num_unloaded_segments) && (it->end > num_entries);
+        ++it
+    )
+    {
+        it->end = num_entries;
+        it->modified = true;
+    }
+}
+
+template <typename Writer>
+string::size_type
 TimeLog::Impl::write_entry
-(   AtomicWriter& p_writer,
+(   Writer& p_writer,
     string const& p_activity,
     TimePoint const& p_time_point
-) const
+)
 {
-    p_writer.append(time_point_to_stamp(p_time_point, m_time_format, m_formatted_buf_len));
+    auto const& time_stamp = m_time_stamp_formatter.format(p_time_point);
+    p_writer.append(time_stamp);
+    auto ret = time_stamp.size() + 1;
     if (!p_activity.empty())
     {
         p_writer.append(" ");
         p_writer.append(p_activity);
+        ret += 1 + p_activity.size();
     }
     p_writer.append("\n");
+    return ret;
 }
 
 string const&
 TimeLog::Impl::id_to_activity(ActivityId p_activity_id) const
 {
-    return p_activity_id->first;
+    return *m_activity_table[p_activity_id].name;
 }
 
-vector<TimeLog::Impl::Entry>::const_iterator
-TimeLog::Impl::find_entry_just_before(TimePoint const& p_time_point)
+TimeLog::Impl::EntryIndex
+TimeLog::Impl::find_entry_just_before(TimePoint const& p_time_point) const
 {
-    load();
-    auto const comp = [](Entry const& lhs, Entry const& rhs)
-    {
-        return lhs.time_point < rhs.time_point;
-    };
-    auto const b = m_entries.begin(), e = m_entries.end();
-    Entry const dummy(0, p_time_point);
-    auto it = upper_bound(b, e, dummy, comp);
-    for ( ; (it != b) && ((it == e) || (it->time_point > p_time_point)); --it)
+    auto const index = m_entries.upper_bound(time_point_to_seconds(p_time_point));
+    return ((index == 0)? 0: (index - 1));
+}
+
+TimeLog::Impl::EntryIndex
+TimeLog::Impl::find_entry_not_before(TimePoint const& p_time_point) const
+{
+    // An entry precedes p_time_point if it is in an earlier second, or in
+    // the same second where p_time_point falls part-way through that second.
+    auto const seconds = time_point_to_seconds(p_time_point);
+    return
+    (   (seconds_to_time_point(seconds) == p_time_point)?
+        m_entries.lower_bound(seconds):
+        m_entries.upper_bound(seconds)
+    );
+}
+
+Interval
+TimeLog::Impl::stint_interval
+(   EntryIndex p_index,
+    TimePoint const* p_begin,
+    TimePoint const* p_end,
+    TimePoint const& p_now
+) const
+{
+    auto tp = m_entries.time_point(p_index);
+    if (p_begin && (tp < *p_begin)) tp = *p_begin;
+    auto const next_index = p_index + 1;
+    auto const done = (next_index == m_entries.size());
+    auto next_tp =
+        (done ? (p_now > tp ? p_now: tp) : m_entries.time_point(next_index));
+    if (p_end && (next_tp > *p_end)) next_tp = *p_end;
+    assert (next_tp >= tp);
+    assert (!p_begin || (tp >= *p_begin));
+    assert (!p_end || (next_tp <= *p_end));
+    auto const seconds = chrono::duration_cast<Seconds>(next_tp - tp);
+    return Interval(tp, seconds, done);
+}
+
+TimeLog::Impl::ActivityStatsTable::ActivityStatsTable
+(   ActivityId p_num_activities
+):
+    m_stats(p_num_activities),
+    m_is_present(p_num_activities, false)
+{
+}
+
+void
+TimeLog::Impl::ActivityStatsTable::add
+(   ActivityId p_activity_id,
+    ActivityStats const& p_stats
+)
+{
+    assert (p_activity_id < m_stats.size());
+    m_stats[p_activity_id] += p_stats;
+    m_is_present[p_activity_id] = true;
+}
+
+bool
+TimeLog::Impl::ActivityStatsTable::contains(ActivityId p_activity_id) const
+{
+    assert (p_activity_id < m_is_present.size());
+    return m_is_present[p_activity_id];
+}
+
+ActivityStats const&
+TimeLog::Impl::ActivityStatsTable::at(ActivityId p_activity_id) const
+{
+    assert (contains(p_activity_id));
+    return m_stats[p_activity_id];
+}
+
+void
+TimeLog::Impl::add_boundary_stints
+(   EpochSeconds p_seconds,
+    FilterMemo& p_filter_memo,
+    ActivityStatsTable& p_activity_stats_table
+) const
+{
+    auto const time_point = seconds_to_time_point(p_seconds);
+    auto const e = m_entries.upper_bound(p_seconds);
+    for (auto i = m_entries.lower_bound(p_seconds); i + 1 < e; ++i)
     {
+        auto const activity_id = m_entries.activity_id(i);
+        if (p_filter_memo.matches(activity_id))
+        {
+            p_activity_stats_table.add
+            (   activity_id,
+                ActivityStats(0, time_point, time_point)
+            );
+        }
     }
-    return it;
 }
 
 #ifndef NDEBUG
     void
     TimeLog::Impl::do_assert_valid() const
     {
-        Entries::size_type ref_counts_total = 0;
-        for (auto const& registry_entry: m_activity_registry)
+        EntryIndex ref_counts_total = 0;
+        for (ActivityId i = 0; i != m_activity_table.size(); ++i)
         {
-            // Elements are deleted from the activity registry when their
+            // Activities are deleted from the activity registry when their
             // reference count reaches 0.
-            auto const reference_count = registry_entry.second;
-            ref_counts_total += reference_count;
-            assert (reference_count > 0);
+            auto const& record = m_activity_table[i];
+            if (record.reference_count > 0)
+            {
+                ActivityId activity_id = 0;
+                auto const found = m_activity_registry.find(*record.name, activity_id);
+                assert (found);
+                assert (activity_id == i);
+                ref_counts_total += record.reference_count;
+            }
         }
         // The number of entries is equal to the sum of the reference counts
         // of the activities.
         assert (ref_counts_total == m_entries.size());
+        assert
+        (   m_activity_registry.size() + m_free_activity_ids.size() ==
+            m_activity_table.size()
+        );
 
         // The reference counts are correct for each entry.
-        unordered_map<string, Entries::size_type> counts;
-        for (auto const& entry: m_entries)
+        vector<EntryIndex> counts(m_activity_table.size());
+        for (EntryIndex i = 0; i != m_entries.size(); ++i)
         {
-            auto const& activity = activity_at(entry);
-            ++counts[activity];
+            ++counts.at(m_entries.activity_id(i));
         }
-        for (auto const& count_entry: counts)
+        for (ActivityId i = 0; i != m_activity_table.size(); ++i)
         {
-            auto const& activity = count_entry.first;
-            auto const check_count = count_entry.second;
-            auto const registry_iter = m_activity_registry.find(activity);
-            assert (registry_iter != m_activity_registry.end());
-            auto const registry_count = registry_iter->second;
-            assert (registry_count == check_count);
+            assert (counts[i] == m_activity_table[i].reference_count);
         }
+
+        // The loaded segments occupy consecutive ranges at the front of
+        // m_entries.
+        EntryIndex previous_end = 0;
+        assert (m_num_unloaded_segments <= m_segments.size());
+        for (auto i = m_num_unloaded_segments; i != m_segments.size(); ++i)
+        {
+            assert (m_segments[i].end >= previous_end);
+            previous_end = m_segments[i].end;
+        }
+        assert (previous_end <= m_entries.size());
     }
 #endif
 
-// Implementation of TimeLog::Impl::Entry
-
-TimeLog::Impl::Entry::Entry(ActivityId p_activity_id, TimePoint const& p_time_point):
-    activity_id(p_activity_id),
-    time_point(p_time_point)
-{
-}
-
 // Implementation of TimeLog::Impl::Transaction
 
-TimeLog::Impl::Transaction::Transaction(TimeLog::Impl& p_time_log_impl):
+TimeLog::Impl::Transaction::Transaction
+(   TimeLog::Impl& p_time_log_impl,
+    bool p_tail_only
+):
     m_time_log_impl(p_time_log_impl)
 {
-    m_time_log_impl.load();
+    if (p_tail_only)
+    {
+        // If only a suffix of the log is loaded, then the changes will have
+        // to be saved by writing just the tail of the file. Make sure this
+        // will be possible, or else load the whole log.
+        m_time_log_impl.load_last(1);
+        if
+        (   !m_time_log_impl.m_complete &&
+            (   !m_time_log_impl.can_save_tail() ||
+                (m_time_log_impl.m_last_saved_entry_offset == k_unknown_offset)
+            )
+        )
+        {
+            m_time_log_impl.load();
+        }
+    }
+    else
+    {
+        m_time_log_impl.load();
+    }
 }
 
 TimeLog::Impl::Transaction::~Transaction()
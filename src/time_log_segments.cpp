@@ -0,0 +1,340 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Implementation of the TimeLog::Impl functions that split the log into
+// segments, and that read and write the segments and their manifest.
+
+#include "time_log_impl.hpp"
+#include "archive.hpp"
+#include "atomic_writer.hpp"
+#include "entries.hpp"
+#include "file_utilities.hpp"
+#include "hash.hpp"
+#include "mapped_file.hpp"
+#include "segment_manifest.hpp"
+#include "time_point.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::runtime_error;
+using std::string;
+using std::vector;
+
+namespace swx
+{
+
+namespace
+{
+    // A new log file is written here while segments are being rotated out of
+    // the log file, and then moved into place.
+    char const k_staging_suffix[] = ".staging";
+
+}  // end anonymous namespace
+
+void
+TimeLog::Impl::load_manifest()
+{
+    assert (m_segments.empty());
+    m_manifest_signature = file_signature(m_manifest_filepath);
+    m_manifest_hash = 0;
+    if (!m_manifest_signature.exists)
+    {
+        return;
+    }
+    auto rotating = false;
+    {
+        MappedFile const file(m_manifest_filepath);
+        m_manifest_hash = hash_bytes(file.begin(), file.end());
+        if (!decode_manifest(file.begin(), file.end(), m_segments, rotating))
+        {
+            throw runtime_error
+            (   "Could not read the time log manifest at " + m_manifest_filepath + "."
+            );
+        }
+    }
+    if (rotating)
+    {
+        // The new log file was staged, but may not have been moved into place.
+        auto const staging_filepath = m_filepath + k_staging_suffix;
+        if (file_exists_at(staging_filepath))
+        {
+            if (std::rename(staging_filepath.c_str(), m_filepath.c_str()) != 0)
+            {
+                throw runtime_error("Could not complete rotation of the time log.");
+            }
+            sync_directory_of(m_filepath);
+        }
+        save_manifest(false);
+    }
+}
+
+void
+TimeLog::Impl::save_manifest(bool p_rotating)
+{
+    auto const buffer = encode_manifest(m_segments, p_rotating);
+    AtomicWriter writer(m_manifest_filepath);
+    writer.append(buffer);
+    writer.commit();
+    m_manifest_signature = file_signature(m_manifest_filepath);
+    m_manifest_hash = hash_bytes(buffer.data(), buffer.data() + buffer.size());
+}
+
+bool
+TimeLog::Impl::manifest_is_current() const
+{
+    return file_signature(m_manifest_filepath) == m_manifest_signature;
+}
+
+string
+TimeLog::Impl::segment_filepath(Segment const& p_segment) const
+{
+    return m_filepath + '.' + p_segment.label;
+}
+
+TimeLog::Impl::EntryIndex
+TimeLog::Impl::num_archived_entries() const
+{
+    return
+    (   (m_num_unloaded_segments == m_segments.size())?
+        0:
+        m_segments.back().end
+    );
+}
+
+void
+TimeLog::Impl::load_segment(Segment& p_segment)
+{
+    auto const filepath = segment_filepath(p_segment);
+    auto const num_entries = m_entries.size();
+    try
+    {
+        MappedFile const file(filepath);
+        if (p_segment.encoding == SegmentEncoding::text)
+        {
+            load_text(file);
+        }
+        else
+        {
+            load_archive(file);
+        }
+    }
+    catch (runtime_error& e)
+    {
+        throw runtime_error("In segment " + filepath + ": " + e.what());
+    }
+    if
+    (   (m_entries.size() == num_entries) ||
+        (m_entries.seconds(m_entries.size() - 1) != p_segment.last_seconds)
+    )
+    {
+        throw runtime_error
+        (   "Segment " + filepath + " does not match the time log manifest."
+        );
+    }
+    p_segment.end = m_entries.size();
+    p_segment.modified = false;
+}
+
+void
+TimeLog::Impl::load_segments()
+{
+    for (auto& segment: m_segments)
+    {
+        load_segment(segment);
+    }
+
+    // The last saved entry, if any, is not in the log file.
+    m_last_saved_entry_offset = k_unknown_offset;
+    m_file_ends_with_newline = true;
+}
+
+void
+TimeLog::Impl::save_segments()
+{
+    assert (m_complete);
+    vector<Segment> segments;
+    auto modified = false;
+    EntryIndex begin = 0;
+    for (auto& segment: m_segments)
+    {
+        if (segment.modified)
+        {
+            modified = true;
+            if (segment.end == begin)
+            {
+                // All its entries have gone.
+                std::remove(segment_filepath(segment).c_str());
+                continue;
+            }
+            write_segment(segment, begin);
+        }
+        begin = segment.end;
+        segments.push_back(std::move(segment));
+    }
+    m_segments = std::move(segments);
+    if (modified)
+    {
+        save_manifest(false);
+    }
+}
+
+void
+TimeLog::Impl::write_segment(Segment& p_segment, EntryIndex p_begin)
+{
+    assert (p_begin < p_segment.end);
+    AtomicWriter writer(segment_filepath(p_segment));
+    vector<bool> is_present(m_activity_table.size(), false);
+    if (p_segment.encoding == SegmentEncoding::text)
+    {
+        for (auto i = p_begin; i != p_segment.end; ++i)
+        {
+            write_entry(writer, activity_at(i), m_entries.time_point(i));
+            is_present[m_entries.activity_id(i)] = true;
+        }
+    }
+    else
+    {
+        // Number the activities in order of their first appearance.
+        ArchivedEntries archived;
+        vector<std::uint32_t> activity_numbers(m_activity_table.size());
+        for (auto i = p_begin; i != p_segment.end; ++i)
+        {
+            auto const activity_id = m_entries.activity_id(i);
+            if (!is_present[activity_id])
+            {
+                is_present[activity_id] = true;
+                activity_numbers[activity_id] = archived.activities.size();
+                archived.activities.push_back(id_to_activity(activity_id));
+            }
+            archived.seconds.push_back(m_entries.seconds(i));
+            archived.activity_numbers.push_back(activity_numbers[activity_id]);
+        }
+        auto const compress = (p_segment.encoding == SegmentEncoding::compressed_archive);
+        writer.append(encode_archive(archived, compress));
+    }
+    writer.commit();
+    p_segment.first_seconds = m_entries.seconds(p_begin);
+    p_segment.last_seconds = m_entries.seconds(p_segment.end - 1);
+    p_segment.num_entries = p_segment.end - p_begin;
+    p_segment.activities.clear();
+    for (ActivityId i = 0; i != is_present.size(); ++i)
+    {
+        if (is_present[i]) p_segment.activities.push_back(id_to_activity(i));
+    }
+    std::sort(p_segment.activities.begin(), p_segment.activities.end());
+    p_segment.modified = false;
+}
+
+void
+TimeLog::Impl::rotate_segments()
+{
+    assert (m_segmentation != Segmentation::none);
+    assert (m_num_saved_entries == m_entries.size());
+    if (m_entries.size() == num_archived_entries())
+    {
+        return;
+    }
+    auto const period_seconds = time_point_to_seconds
+    (   period_begin(m_entries.time_point(m_entries.size() - 1), m_segmentation)
+    );
+
+    // Unless the whole log file has been loaded, check whether it begins
+    // before the period of the last entry without loading it.
+    if (m_suffix_offset != 0)
+    {
+        MappedFile const file(m_filepath);
+        if (file.size() < m_expected_time_stamp_length)
+        {
+            return;
+        }
+        auto const first = m_time_stamp_parser.parse
+        (   file.begin(),
+            file.begin() + m_expected_time_stamp_length
+        );
+        if (time_point_to_seconds(first) >= period_seconds)
+        {
+            return;
+        }
+        while (m_suffix_offset != 0)
+        {
+            extend_suffix();
+        }
+    }
+    auto const num_entries = m_entries.size();
+    auto const begin = num_archived_entries();
+    auto const end = m_entries.lower_bound(period_seconds);
+    if (end <= begin)
+    {
+        return;
+    }
+    assert (end < num_entries);
+
+    // Write a new segment for each period, then stage the new log file; then
+    // record the new segments in the manifest, and only then move the new log
+    // file into place. If this fails before the manifest is written, the new
+    // files are removed, as nothing refers to them; if it is interrupted after
+    // the manifest is written, load_manifest completes it.
+    auto const num_segments = m_segments.size();
+    auto num_written = num_segments;
+    auto const staging_filepath = m_filepath + k_staging_suffix;
+    try
+    {
+        append_period_segments(m_entries, begin, end, m_segmentation, m_segments);
+        auto segment_begin = begin;
+        for ( ; num_written != m_segments.size(); ++num_written)
+        {
+            write_segment(m_segments[num_written], segment_begin);
+            segment_begin = m_segments[num_written].end;
+        }
+        AtomicWriter writer(staging_filepath);
+        unsigned long long offset = 0;
+        for (auto i = end; i != num_entries; ++i)
+        {
+            m_last_saved_entry_offset = offset;
+            offset += write_entry(writer, activity_at(i), m_entries.time_point(i));
+        }
+        writer.commit();
+        save_manifest(true);
+    }
+    catch (...)
+    {
+        for (auto k = num_segments; k != num_written; ++k)
+        {
+            std::remove(segment_filepath(m_segments[k]).c_str());
+        }
+        std::remove(staging_filepath.c_str());
+        m_segments.resize(num_segments);
+        throw;
+    }
+    if (std::rename(staging_filepath.c_str(), m_filepath.c_str()) != 0)
+    {
+        throw runtime_error("Could not move the new time log into place.");
+    }
+    sync_directory_of(m_filepath);
+    save_manifest(false);
+    m_file_signature = file_signature(m_filepath);
+    MappedFile const file(m_filepath);
+    m_file_tail_hash = tail_hash(file.begin(), file.end());
+    m_file_ends_with_newline = true;
+}
+
+}  // namespace swx
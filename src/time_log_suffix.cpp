@@ -0,0 +1,262 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Implementation of the TimeLog::Impl functions that load only a suffix of
+// the log, reading the log file backwards from the end.
+
+#include "time_log_impl.hpp"
+#include "entries.hpp"
+#include "file_utilities.hpp"
+#include "mapped_file.hpp"
+#include "segment_manifest.hpp"
+#include "tail_writer.hpp"
+#include "time_point.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+
+using std::function;
+using std::max;
+using std::runtime_error;
+
+namespace swx
+{
+
+namespace
+{
+    // Number of bytes of the log file that are read at a time, at minimum, when
+    // loading the log backwards from the end.
+    unsigned long long const k_min_block_size = 16 * 1024;
+
+}  // end anonymous namespace
+
+void
+TimeLog::Impl::load_last(EntryIndex p_num)
+{
+    // The first entry loaded may not have begun when it appears to, so we need
+    // one more than p_num.
+    load_suffix([this, p_num]() { return m_entries.size() > p_num; });
+}
+
+void
+TimeLog::Impl::load_since(TimePoint const& p_time_point)
+{
+    load_suffix
+    (   [this, &p_time_point]()
+        {
+            return !m_entries.empty() && (m_entries.time_point(0) <= p_time_point);
+        }
+    );
+}
+
+void
+TimeLog::Impl::load_suffix(function<bool()> const& p_is_sufficient)
+{
+    assert_valid();
+    if (!m_loaded)
+    {
+        TailWriter::recover(m_filepath);
+        if (!reload_tail())
+        {
+            clear_cache();
+            begin_suffix();
+        }
+        m_loaded = true;
+        throw_if_future_dated();
+    }
+    while (!m_complete && !p_is_sufficient())
+    {
+        extend_suffix();
+    }
+    assert_valid();
+}
+
+void
+TimeLog::Impl::begin_suffix()
+{
+    assert (m_entries.empty());
+    load_manifest();
+    m_num_unloaded_segments = m_segments.size();
+    m_suffix_offset = 0;
+    if (file_exists_at(m_filepath))
+    {
+        m_file_signature = file_signature(m_filepath);
+        MappedFile const file(m_filepath);
+        m_file_tail_hash = tail_hash(file.begin(), file.end());
+        m_suffix_offset = file.size();
+        if (m_suffix_offset != 0)
+        {
+            m_complete = false;
+            extend_suffix(file);
+            return;
+        }
+    }
+    m_complete = (m_num_unloaded_segments == 0);
+    if (!m_complete)
+    {
+        extend_suffix_by_segment();
+    }
+}
+
+void
+TimeLog::Impl::extend_suffix()
+{
+    if (m_suffix_offset == 0)
+    {
+        extend_suffix_by_segment();
+        return;
+    }
+    if (file_signature(m_filepath) != m_file_signature)
+    {
+        // The file has been changed by another process, so the offsets we
+        // have recorded are meaningless.
+        mark_cache_as_stale();
+        load();
+        return;
+    }
+    MappedFile const file(m_filepath);
+    extend_suffix(file);
+}
+
+void
+TimeLog::Impl::extend_suffix(MappedFile const& p_file)
+{
+    assert (!m_complete);
+    assert (m_suffix_offset != 0);
+    assert (m_suffix_offset <= p_file.size());
+    assert (m_num_unchanged_entries == m_num_saved_entries);
+    assert (m_num_saved_entries == m_entries.size());
+
+    // Read at least as much again as has already been loaded, so that the
+    // total work done is proportional to the amount eventually loaded.
+    auto const suffix_begin = p_file.begin() + m_suffix_offset;
+    auto const block_size =
+        max<unsigned long long>(k_min_block_size, p_file.size() - m_suffix_offset);
+    auto block_begin = p_file.begin();
+    if (m_suffix_offset > block_size)
+    {
+        // Move back to the beginning of the line. (memrchr is non-portable.)
+        auto const newline = static_cast<char const*>
+        (   memrchr(p_file.begin(), '\n', m_suffix_offset - block_size)
+        );
+        block_begin = (newline ? newline + 1 : p_file.begin());
+    }
+    assert (block_begin < suffix_begin);
+
+    // Parse the block into m_entries, then reattach the entries that were
+    // already loaded. The first of these was parsed from the line at
+    // m_suffix_offset, and if it has the same activity as the last entry
+    // in the block, it is merely a continuation of that entry.
+    Entries suffix;
+    suffix.swap(m_entries);
+    auto const last_saved_entry_offset = m_last_saved_entry_offset;
+    auto const file_ends_with_newline = m_file_ends_with_newline;
+    try
+    {
+        load_text(p_file, block_begin - p_file.begin(), m_suffix_offset);
+        if (!suffix.empty())
+        {
+            assert (!m_entries.empty());
+            auto const last = m_entries.size() - 1;
+            EntryIndex first = 0;
+            if (suffix.seconds(first) < m_entries.seconds(last))
+            {
+                throw_out_of_order(p_file, suffix_begin);
+            }
+            if (suffix.activity_id(first) == m_entries.activity_id(last))
+            {
+                deregister_activity_reference(suffix.activity_id(first));
+                ++first;
+            }
+            m_entries.append(suffix, first);
+            m_last_saved_entry_offset = last_saved_entry_offset;
+            m_file_ends_with_newline = file_ends_with_newline;
+        }
+    }
+    catch (...)
+    {
+        clear_cache();
+        throw;
+    }
+    m_suffix_offset = block_begin - p_file.begin();
+    m_complete = ((m_suffix_offset == 0) && (m_num_unloaded_segments == 0));
+    m_num_saved_entries = m_num_unchanged_entries = m_entries.size();
+}
+
+void
+TimeLog::Impl::extend_suffix_by_segment()
+{
+    assert (!m_complete);
+    assert (m_suffix_offset == 0);
+    assert (m_num_unloaded_segments != 0);
+    assert (m_num_unchanged_entries == m_num_saved_entries);
+    assert (m_num_saved_entries == m_entries.size());
+    if (!manifest_is_current())
+    {
+        // The segments have been changed by another process.
+        mark_cache_as_stale();
+        load();
+        return;
+    }
+
+    // As in extend_suffix, load the segment into m_entries, then reattach the
+    // entries already loaded.
+    auto& segment = m_segments[m_num_unloaded_segments - 1];
+    Entries suffix;
+    suffix.swap(m_entries);
+    auto const last_saved_entry_offset = m_last_saved_entry_offset;
+    auto const file_ends_with_newline = m_file_ends_with_newline;
+    try
+    {
+        load_segment(segment);
+        EntryIndex first = 0;
+        if (!suffix.empty())
+        {
+            auto const last = m_entries.size() - 1;
+            if (suffix.seconds(first) < m_entries.seconds(last))
+            {
+                throw runtime_error
+                (   "Time log entries out of order at the end of segment " +
+                    segment_filepath(segment) + "."
+                );
+            }
+            if (suffix.activity_id(first) == m_entries.activity_id(last))
+            {
+                deregister_activity_reference(suffix.activity_id(first));
+                ++first;
+            }
+            m_entries.append(suffix, first);
+        }
+        for (auto i = m_num_unloaded_segments; i != m_segments.size(); ++i)
+        {
+            m_segments[i].end += segment.end - first;
+        }
+        m_last_saved_entry_offset = last_saved_entry_offset;
+        m_file_ends_with_newline = file_ends_with_newline;
+    }
+    catch (...)
+    {
+        clear_cache();
+        throw;
+    }
+    --m_num_unloaded_segments;
+    m_complete = (m_num_unloaded_segments == 0);
+    m_num_saved_entries = m_num_unchanged_entries = m_entries.size();
+}
+
+}  // namespace swx
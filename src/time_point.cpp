@@ -16,6 +16,7 @@
 
 #include "time_point.hpp"
 #include "config.hpp"
+#include "time_zone.hpp"
 #include <chrono>
 #include <cstring>
 #include <ctime>
@@ -25,9 +26,7 @@
 
 namespace chrono = std::chrono;
 
-using std::localtime;
 using std::memset;
-using std::mktime;
 using std::runtime_error;
 using std::string;
 using std::tm;
@@ -77,17 +76,14 @@ day_end(TimePoint const& p_time_point, int p_days_diff)
 tm
 time_point_to_tm(TimePoint const& p_time_point)
 {
-    time_t const time_time_t = chrono::system_clock::to_time_t(p_time_point);
-    tm* const time_tm_ptr = localtime(&time_time_t);
-    return *time_tm_ptr;
+    return TimeZone::local().to_tm(chrono::system_clock::to_time_t(p_time_point));
 }
 
 TimePoint
 tm_to_time_point(tm const& p_tm)
 {
-    tm time_tm = p_tm;
-    time_t const time_time_t = mktime(&time_tm);
-    return chrono::system_clock::from_time_t(time_time_t);
+    auto const seconds = TimeZone::local().to_seconds(p_tm);
+    return chrono::system_clock::from_time_t(static_cast<time_t>(seconds));
 }
 
 TimePoint
@@ -104,7 +100,7 @@ long_time_stamp_to_point(string const& p_time_stamp, string const& p_format)
         throw runtime_error(errmsg);
     }
 
-    return chrono::system_clock::from_time_t(mktime(&tm));
+    return tm_to_time_point(tm);
 }
 
 TimePoint
@@ -134,7 +130,7 @@ time_stamp_to_point
         }
     }
 
-    return chrono::system_clock::from_time_t(mktime(&tm));
+    return tm_to_time_point(tm);
 }
 
 string
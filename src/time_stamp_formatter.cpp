@@ -0,0 +1,296 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "time_stamp_formatter.hpp"
+#include "time_point.hpp"
+#include <cassert>
+#include <chrono>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace chrono = std::chrono;
+
+using std::runtime_error;
+using std::strftime;
+using std::string;
+using std::tm;
+
+namespace swx
+{
+
+namespace
+{
+    // Not the number of any second we will encounter.
+    long long const k_no_seconds = 1LL << 62;
+
+    long long const k_seconds_per_day = 24 * 60 * 60;
+
+    bool same_offset(tm const& p_lhs, tm const& p_rhs)
+    {
+        // non-portable
+        return (p_lhs.tm_gmtoff == p_rhs.tm_gmtoff) && (p_lhs.tm_isdst == p_rhs.tm_isdst);
+    }
+
+}  // end anonymous namespace
+
+TimeStampFormatter::TimeStampFormatter
+(   string const& p_format,
+    unsigned int p_formatted_buf_len
+):
+    m_format(p_format),
+    m_time_zone(TimeZone::local()),
+    m_formatted_buf_len(p_formatted_buf_len),
+    m_specialized(false),
+    m_hour_position(string::npos),
+    m_minute_position(string::npos),
+    m_second_position(string::npos),
+    m_day_begin(0),
+    m_day_end(0),
+    m_day_formatted(false),
+    m_seconds(k_no_seconds),
+    m_buffer(p_formatted_buf_len)
+{
+    m_specialized = compile(p_format);
+    if (!m_specialized) m_tokens.clear();
+}
+
+TimeStampFormatter::~TimeStampFormatter() = default;
+
+string const&
+TimeStampFormatter::format(TimePoint const& p_time_point)
+{
+    long long const seconds = chrono::system_clock::to_time_t(p_time_point);
+    if (seconds == m_seconds)
+    {
+        return m_result;
+    }
+    if ((seconds < m_day_begin) || (seconds >= m_day_end))
+    {
+        load_day(seconds);
+    }
+    auto const seconds_into_day = seconds - m_day_begin;
+    tm time_tm = m_day_tm;
+    time_tm.tm_hour += static_cast<int>(seconds_into_day / (60 * 60));
+    time_tm.tm_min += static_cast<int>(seconds_into_day / 60 % 60);
+    time_tm.tm_sec += static_cast<int>(seconds_into_day % 60);
+    auto const year = time_tm.tm_year + 1900;
+    if (m_specialized && (year >= 1000) && (year <= 9999))
+    {
+        if (m_day_formatted)
+        {
+            // Only the time of day can have changed.
+            write_digits(m_hour_position, time_tm.tm_hour);
+            write_digits(m_minute_position, time_tm.tm_min);
+            write_digits(m_second_position, time_tm.tm_sec);
+        }
+        else
+        {
+            format_tm(time_tm);
+            m_day_formatted = true;
+        }
+    }
+    else
+    {
+        auto const length =
+            strftime(m_buffer.data(), m_buffer.size(), m_format.c_str(), &time_tm);
+        if (length == 0)
+        {
+            throw runtime_error("Error formatting TimePoint.");
+        }
+        m_result.assign(m_buffer.data(), length);
+    }
+    m_seconds = seconds;
+    return m_result;
+}
+
+bool
+TimeStampFormatter::is_specialized() const
+{
+    return m_specialized;
+}
+
+bool
+TimeStampFormatter::compile(string const& p_format)
+{
+    auto const add = [this](Field p_field, char p_literal)
+    {
+        m_tokens.emplace_back(p_field, p_literal);
+    };
+    for (string::size_type i = 0; i != p_format.size(); ++i)
+    {
+        auto const c = p_format[i];
+        if (c != '%')
+        {
+            add(Field::literal, c);
+            continue;
+        }
+        if (++i == p_format.size())
+        {
+            return false;
+        }
+        switch (p_format[i])
+        {
+        case 'Y': add(Field::year, '\0'); break;
+        case 'm': add(Field::month, '\0'); break;
+        case 'd': add(Field::day, '\0'); break;
+        case 'H': add(Field::hour, '\0'); break;
+        case 'M': add(Field::minute, '\0'); break;
+        case 'S': add(Field::second, '\0'); break;
+        case '%': add(Field::literal, '%'); break;
+        case 'F':
+            add(Field::year, '\0');
+            add(Field::literal, '-');
+            add(Field::month, '\0');
+            add(Field::literal, '-');
+            add(Field::day, '\0');
+            break;
+        case 'T':
+            add(Field::hour, '\0');
+            add(Field::literal, ':');
+            add(Field::minute, '\0');
+            add(Field::literal, ':');
+            add(Field::second, '\0');
+            break;
+        case 'R':
+            add(Field::hour, '\0');
+            add(Field::literal, ':');
+            add(Field::minute, '\0');
+            break;
+        default:
+            return false;
+        }
+    }
+
+    // Each time of day field may appear at most once, so that it can be
+    // rewritten in place.
+    unsigned int counts[static_cast<int>(Field::second) + 1] = {};
+    for (auto const& token: m_tokens)
+    {
+        if ((token.field == Field::hour) || (token.field == Field::minute) ||
+            (token.field == Field::second))
+        {
+            if (++counts[static_cast<int>(token.field)] > 1)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void
+TimeStampFormatter::load_day(long long p_seconds)
+{
+    tm const time_tm = m_time_zone.to_tm(p_seconds);
+    auto const day_begin =
+        p_seconds - (time_tm.tm_hour * 60 * 60 + time_tm.tm_min * 60 + time_tm.tm_sec);
+    tm const begin_tm = m_time_zone.to_tm(day_begin);
+    tm const last_tm = m_time_zone.to_tm(day_begin + k_seconds_per_day - 1);
+
+    // If the offset is the same at the beginning and at the end of the day as
+    // at p_seconds, then it is the same throughout.
+    if (same_offset(begin_tm, time_tm) && same_offset(last_tm, time_tm))
+    {
+        assert (begin_tm.tm_hour == 0);
+        assert (begin_tm.tm_min == 0);
+        assert (begin_tm.tm_sec == 0);
+        m_day_begin = day_begin;
+        m_day_end = day_begin + k_seconds_per_day;
+        m_day_tm = begin_tm;
+    }
+    else
+    {
+        m_day_begin = p_seconds;
+        m_day_end = p_seconds + 1;
+        m_day_tm = time_tm;
+    }
+    m_day_formatted = false;
+}
+
+void
+TimeStampFormatter::format_tm(tm const& p_tm)
+{
+    assert (m_specialized);
+    m_result.clear();
+    for (auto const& token: m_tokens)
+    {
+        auto const position = m_result.size();
+        switch (token.field)
+        {
+        case Field::literal:
+            m_result.push_back(token.literal);
+            break;
+        case Field::year:
+            m_result.append(4, '0');
+            write_digits(position, (p_tm.tm_year + 1900) / 100);
+            write_digits(position + 2, (p_tm.tm_year + 1900) % 100);
+            break;
+        case Field::month:
+            m_result.append(2, '0');
+            write_digits(position, p_tm.tm_mon + 1);
+            break;
+        case Field::day:
+            m_result.append(2, '0');
+            write_digits(position, p_tm.tm_mday);
+            break;
+        case Field::hour:
+            m_result.append(2, '0');
+            m_hour_position = position;
+            write_digits(position, p_tm.tm_hour);
+            break;
+        case Field::minute:
+            m_result.append(2, '0');
+            m_minute_position = position;
+            write_digits(position, p_tm.tm_min);
+            break;
+        case Field::second:
+            m_result.append(2, '0');
+            m_second_position = position;
+            write_digits(position, p_tm.tm_sec);
+            break;
+        }
+    }
+
+    // As with strftime, the result and its terminating null character must
+    // fit within the buffer, and an empty result is an error.
+    if (m_result.empty() || (m_result.size() >= m_formatted_buf_len))
+    {
+        throw runtime_error("Error formatting TimePoint.");
+    }
+}
+
+void
+TimeStampFormatter::write_digits(string::size_type p_position, int p_value)
+{
+    if (p_position == string::npos)
+    {
+        return;
+    }
+    assert (p_value >= 0);
+    assert (p_value < 100);
+    m_result[p_position] = static_cast<char>('0' + p_value / 10);
+    m_result[p_position + 1] = static_cast<char>('0' + p_value % 10);
+}
+
+TimeStampFormatter::Token::Token(Field p_field, char p_literal):
+    field(p_field),
+    literal(p_literal)
+{
+}
+
+}  // namespace swx
@@ -0,0 +1,288 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "time_stamp_parser.hpp"
+#include "time_point.hpp"
+#include "time_zone.hpp"
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace chrono = std::chrono;
+
+using std::memset;
+using std::string;
+using std::time_t;
+using std::tm;
+
+namespace swx
+{
+
+namespace
+{
+    // Not the number of any day we will encounter.
+    long long const k_no_day = 1LL << 62;
+
+    long long const k_seconds_per_day = 24 * 60 * 60;
+
+    long long local_to_epoch
+    (   TimeZone const& p_time_zone,
+        int p_year,
+        int p_month,
+        int p_day,
+        int p_hour,
+        int p_minute,
+        int p_second
+    )
+    {
+        tm time_tm;
+        memset(&time_tm, 0, sizeof(time_tm));
+        time_tm.tm_year = p_year - 1900;
+        time_tm.tm_mon = p_month - 1;
+        time_tm.tm_mday = p_day;
+        time_tm.tm_hour = p_hour;
+        time_tm.tm_min = p_minute;
+        time_tm.tm_sec = p_second;
+        time_tm.tm_isdst = -1;
+        return p_time_zone.to_seconds(time_tm);
+    }
+
+}  // end anonymous namespace
+
+TimeStampParser::TimeStampParser(string const& p_format):
+    m_format(p_format),
+    m_time_zone(TimeZone::local()),
+    m_specialized(false),
+    m_last_day_number(k_no_day),
+    m_previous_offset(0)
+{
+    m_specialized = compile(p_format);
+    if (!m_specialized) m_tokens.clear();
+}
+
+TimeStampParser::~TimeStampParser() = default;
+
+TimePoint
+TimeStampParser::parse(char const* p_begin, char const* p_end)
+{
+    long long result = 0;
+    if (m_specialized && parse_fast(p_begin, p_end, result))
+    {
+        return chrono::system_clock::from_time_t(static_cast<time_t>(result));
+    }
+    return long_time_stamp_to_point(string(p_begin, p_end), m_format);
+}
+
+bool
+TimeStampParser::is_specialized() const
+{
+    return m_specialized;
+}
+
+long long
+TimeStampParser::previous_offset() const
+{
+    return m_previous_offset;
+}
+
+void
+TimeStampParser::set_previous_offset(long long p_offset)
+{
+    m_previous_offset = p_offset;
+}
+
+bool
+TimeStampParser::compile(string const& p_format)
+{
+    auto const add = [this](Field p_field, char p_literal)
+    {
+        m_tokens.emplace_back(p_field, p_literal);
+    };
+    for (string::size_type i = 0; i != p_format.size(); ++i)
+    {
+        auto const c = p_format[i];
+        if (c != '%')
+        {
+            add(Field::literal, c);
+            continue;
+        }
+        if (++i == p_format.size())
+        {
+            return false;
+        }
+        switch (p_format[i])
+        {
+        case 'Y': add(Field::year, '\0'); break;
+        case 'm': add(Field::month, '\0'); break;
+        case 'd': add(Field::day, '\0'); break;
+        case 'H': add(Field::hour, '\0'); break;
+        case 'M': add(Field::minute, '\0'); break;
+        case 'S': add(Field::second, '\0'); break;
+        case '%': add(Field::literal, '%'); break;
+        case 'F':
+            add(Field::year, '\0');
+            add(Field::literal, '-');
+            add(Field::month, '\0');
+            add(Field::literal, '-');
+            add(Field::day, '\0');
+            break;
+        case 'T':
+            add(Field::hour, '\0');
+            add(Field::literal, ':');
+            add(Field::minute, '\0');
+            add(Field::literal, ':');
+            add(Field::second, '\0');
+            break;
+        case 'R':
+            add(Field::hour, '\0');
+            add(Field::literal, ':');
+            add(Field::minute, '\0');
+            break;
+        default:
+            return false;
+        }
+    }
+
+    // Each field may appear at most once, and the date must be complete.
+    unsigned int counts[static_cast<int>(Field::second) + 1] = {};
+    for (auto const& token: m_tokens)
+    {
+        if (token.field != Field::literal && ++counts[static_cast<int>(token.field)] > 1)
+        {
+            return false;
+        }
+    }
+    return
+        counts[static_cast<int>(Field::year)] &&
+        counts[static_cast<int>(Field::month)] &&
+        counts[static_cast<int>(Field::day)];
+}
+
+bool
+TimeStampParser::parse_fast(char const* p_begin, char const* p_end, long long& p_result)
+{
+    assert (m_specialized);
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+    auto it = p_begin;
+    for (auto const& token: m_tokens)
+    {
+        if (token.field == Field::literal)
+        {
+            if ((it == p_end) || (*it != token.literal)) return false;
+            ++it;
+            continue;
+        }
+        auto const width = (token.field == Field::year ? 4 : 2);
+        if (p_end - it < width) return false;
+        int value = 0;
+        for (auto const e = it + width; it != e; ++it)
+        {
+            if ((*it < '0') || (*it > '9')) return false;
+            value = value * 10 + (*it - '0');
+        }
+        switch (token.field)
+        {
+        case Field::year: year = value; break;
+        case Field::month: month = value; break;
+        case Field::day: day = value; break;
+        case Field::hour: hour = value; break;
+        case Field::minute: minute = value; break;
+        case Field::second: second = value; break;
+        default: assert (false);
+        }
+    }
+
+    // Leave anything out of range (and leap seconds) to strptime.
+    if
+    (   (month < 1) || (month > 12) ||
+        (day < 1) || (day > 31) ||
+        (hour > 23) || (minute > 59) || (second > 59)
+    )
+    {
+        return false;
+    }
+    auto const day_number = days_from_civil(year, month, day);
+    auto const local_seconds =
+        day_number * k_seconds_per_day + hour * 60 * 60 + minute * 60 + second;
+    auto const& offsets = utc_offsets_of_day(day_number, year, month, day);
+    auto offset = offsets.first;
+    if (offsets.last != offsets.first)
+    {
+        // The offset changes during this day, so the local time might
+        // fall under either offset, or be ambiguous, or not exist at all.
+        auto const valid = [this, local_seconds](long long p_offset)
+        {
+            return m_time_zone.utc_offset(local_seconds - p_offset) == p_offset;
+        };
+        auto const first_valid = valid(offsets.first);
+        auto const last_valid = valid(offsets.last);
+        if (first_valid != last_valid)
+        {
+            offset = (first_valid ? offsets.first : offsets.last);
+        }
+        else if (m_previous_offset == offsets.last)
+        {
+            // Resolve ambiguity in favour of continuity with the previously
+            // parsed timestamp, as mktime does when called in sequence.
+            offset = offsets.last;
+        }
+    }
+    m_previous_offset = offset;
+    p_result = local_seconds - offset;
+    return true;
+}
+
+TimeStampParser::DayOffsets const&
+TimeStampParser::utc_offsets_of_day
+(   long long p_day_number,
+    int p_year,
+    int p_month,
+    int p_day
+)
+{
+    if (p_day_number != m_last_day_number)
+    {
+        auto it = m_day_offsets.find(p_day_number);
+        if (it == m_day_offsets.end())
+        {
+            // If the offset is the same at the beginning and at the end of the
+            // day, then it is the same throughout.
+            auto const day_start = p_day_number * k_seconds_per_day;
+            DayOffsets offsets;
+            offsets.first =
+                day_start - local_to_epoch(m_time_zone, p_year, p_month, p_day, 0, 0, 0);
+            offsets.last =
+                day_start + k_seconds_per_day - 1 -
+                local_to_epoch(m_time_zone, p_year, p_month, p_day, 23, 59, 59);
+            it = m_day_offsets.emplace(p_day_number, offsets).first;
+        }
+        m_last_day_number = p_day_number;
+        m_last_day_offsets = it->second;
+    }
+    return m_last_day_offsets;
+}
+
+TimeStampParser::Token::Token(Field p_field, char p_literal):
+    field(p_field),
+    literal(p_literal)
+{
+}
+
+}  // namespace swx
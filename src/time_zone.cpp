@@ -0,0 +1,400 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "time_zone.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using std::getenv;
+using std::lock_guard;
+using std::memset;
+using std::mktime;
+using std::mutex;
+using std::string;
+using std::time_t;
+using std::tm;
+using std::unique_ptr;
+using std::unordered_map;
+using std::upper_bound;
+using std::vector;
+
+namespace swx
+{
+
+namespace
+{
+    long long const k_seconds_per_day = 24 * 60 * 60;
+
+    // The table of transitions is built by sampling localtime_r at this
+    // interval, and bisecting wherever the result changes. A change that was
+    // reversed within the interval would be missed, but the time zone
+    // database records none so brief.
+    long long const k_probe_interval = 7 * k_seconds_per_day;
+
+    int const k_table_first_year = 1970;
+    int const k_table_end_year = 2038;
+
+    // Division rounding towards negative infinity, for positive p_divisor.
+    long long floor_divide(long long p_dividend, long long p_divisor)
+    {
+        assert (p_divisor > 0);
+        return (p_dividend >= 0 ? p_dividend : p_dividend - p_divisor + 1) / p_divisor;
+    }
+
+    // Inverse of days_from_civil. (Algorithm due to Howard Hinnant.)
+    void civil_from_days(long long p_days, long long& p_year, int& p_month, int& p_day)
+    {
+        p_days += 719468;
+        long long const era = (p_days >= 0 ? p_days : p_days - 146096) / 146097;
+        long long const day_of_era = p_days - era * 146097;
+        long long const year_of_era =
+            (   day_of_era - day_of_era / 1460 + day_of_era / 36524 -
+                day_of_era / 146096
+            ) / 365;
+        long long const day_of_year =
+            day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+        long long const month_index = (5 * day_of_year + 2) / 153;
+        p_day = static_cast<int>(day_of_year - (153 * month_index + 2) / 5 + 1);
+        p_month = static_cast<int>(month_index < 10 ? month_index + 3 : month_index - 9);
+        p_year = year_of_era + era * 400 + (p_month <= 2);
+    }
+
+    // Guards the TZ environment variable and the static state behind tzset
+    // and mktime, which TimeZone::local and conversions falling outside the
+    // table of transitions both rely on.
+    mutex& zone_mutex()
+    {
+        static mutex s_mutex;
+        return s_mutex;
+    }
+
+    // The caller must hold zone_mutex, unless no other thread can be using it.
+    tm local_tm(long long p_seconds)
+    {
+        // non-portable
+        time_t const time_time_t = static_cast<time_t>(p_seconds);
+        tm time_tm;
+        localtime_r(&time_time_t, &time_tm);
+        return time_tm;
+    }
+
+}  // end anonymous namespace
+
+long long
+days_from_civil(long long p_year, int p_month, int p_day)
+{
+    // Algorithm due to Howard Hinnant.
+    p_year -= (p_month <= 2);
+    long long const era = (p_year >= 0 ? p_year : p_year - 399) / 400;
+    long long const year_of_era = p_year - era * 400;
+    long long const day_of_year =
+        (153 * (p_month > 2 ? p_month - 3 : p_month + 9) + 2) / 5 + p_day - 1;
+    long long const day_of_era =
+        year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+TimeZone const&
+TimeZone::local()
+{
+    static unordered_map<string, unique_ptr<TimeZone>> s_zones;
+    static TimeZone const* s_current = nullptr;
+    static string s_current_key;
+
+    // Distinguish an unset TZ from an empty one.
+    auto const tz = getenv("TZ");
+    string const key = (tz == nullptr ? string() : '=' + string(tz));
+
+    lock_guard<mutex> const lock(zone_mutex());
+    if ((s_current == nullptr) || (key != s_current_key))
+    {
+        // non-portable
+        tzset();
+        auto& zone = s_zones[key];
+        if (!zone)
+        {
+            zone.reset(new TimeZone);
+        }
+        s_current = zone.get();
+        s_current_key = key;
+    }
+    return *s_current;
+}
+
+TimeZone::TimeZone():
+    m_table_begin(days_from_civil(k_table_first_year, 1, 1) * k_seconds_per_day),
+    m_table_end(days_from_civil(k_table_end_year, 1, 1) * k_seconds_per_day)
+{
+    auto const state_at = [this](long long p_seconds)
+    {
+        auto const time_tm = local_tm(p_seconds);
+
+        // non-portable
+        string const abbreviation(time_tm.tm_zone == nullptr ? "" : time_tm.tm_zone);
+        auto it = find(m_abbreviations.begin(), m_abbreviations.end(), abbreviation);
+        if (it == m_abbreviations.end())
+        {
+            it = m_abbreviations.insert(it, abbreviation);
+        }
+        State const state =
+        {   p_seconds,
+            time_tm.tm_gmtoff,
+            (time_tm.tm_isdst > 0),
+            static_cast<vector<string>::size_type>(it - m_abbreviations.begin())
+        };
+        return state;
+    };
+    auto const same = [](State const& p_lhs, State const& p_rhs)
+    {
+        return
+            (p_lhs.offset == p_rhs.offset) &&
+            (p_lhs.is_dst == p_rhs.is_dst) &&
+            (p_lhs.abbreviation == p_rhs.abbreviation);
+    };
+    m_states.push_back(state_at(m_table_begin));
+    for (auto cursor = m_table_begin; cursor < m_table_end; )
+    {
+        auto const next = cursor + k_probe_interval;
+        auto const next_state = state_at(next);
+        if (same(next_state, m_states.back()))
+        {
+            cursor = next;
+            continue;
+        }
+
+        // Bisect to find the first second at which the state changes.
+        auto low = cursor;
+        auto high = next;
+        auto high_state = next_state;
+        while (high - low > 1)
+        {
+            auto const middle = low + (high - low) / 2;
+            auto const middle_state = state_at(middle);
+            if (same(middle_state, m_states.back()))
+            {
+                low = middle;
+            }
+            else
+            {
+                high = middle;
+                high_state = middle_state;
+            }
+        }
+        high_state.begin = high;
+        m_states.push_back(high_state);
+        cursor = high;
+    }
+}
+
+TimeZone::~TimeZone() = default;
+
+tm
+TimeZone::to_tm(long long p_seconds) const
+{
+    if (!in_table(p_seconds))
+    {
+        lock_guard<mutex> const lock(zone_mutex());
+        return local_tm(p_seconds);
+    }
+    auto const& state = m_states[state_index(p_seconds)];
+    auto const local_seconds = p_seconds + state.offset;
+    auto const days = floor_divide(local_seconds, k_seconds_per_day);
+    auto const seconds_into_day = local_seconds - days * k_seconds_per_day;
+    long long year = 0;
+    int month = 0;
+    int day = 0;
+    civil_from_days(days, year, month, day);
+
+    tm ret;
+    memset(&ret, 0, sizeof(ret));
+    ret.tm_year = static_cast<int>(year - 1900);
+    ret.tm_mon = month - 1;
+    ret.tm_mday = day;
+    ret.tm_hour = static_cast<int>(seconds_into_day / (60 * 60));
+    ret.tm_min = static_cast<int>(seconds_into_day / 60 % 60);
+    ret.tm_sec = static_cast<int>(seconds_into_day % 60);
+    ret.tm_wday = static_cast<int>((days % 7 + 11) % 7);  // 1970-01-01 was a Thursday
+    ret.tm_yday = static_cast<int>(days - days_from_civil(year, 1, 1));
+    ret.tm_isdst = (state.is_dst ? 1 : 0);
+
+    // non-portable
+    ret.tm_gmtoff = state.offset;
+    ret.tm_zone = m_abbreviations[state.abbreviation].c_str();
+
+    return ret;
+}
+
+long long
+TimeZone::to_seconds(tm const& p_tm) const
+{
+    auto const year = p_tm.tm_year + 1900LL + floor_divide(p_tm.tm_mon, 12);
+    auto const month = static_cast<int>(p_tm.tm_mon - floor_divide(p_tm.tm_mon, 12) * 12);
+    auto const days = days_from_civil(year, month + 1, 1) + p_tm.tm_mday - 1;
+    auto const local_seconds =
+        days * k_seconds_per_day +
+        p_tm.tm_hour * 60LL * 60LL +
+        p_tm.tm_min * 60LL +
+        p_tm.tm_sec;
+
+    // UTC offsets are always less than a day.
+    if
+    (   !in_table(local_seconds - k_seconds_per_day) ||
+        !in_table(local_seconds + k_seconds_per_day)
+    )
+    {
+        lock_guard<mutex> const lock(zone_mutex());
+        tm time_tm = p_tm;
+        return mktime(&time_tm);
+    }
+    return resolve(local_seconds, p_tm.tm_isdst);
+}
+
+long
+TimeZone::utc_offset(long long p_seconds) const
+{
+    if (!in_table(p_seconds))
+    {
+        lock_guard<mutex> const lock(zone_mutex());
+
+        // non-portable
+        return local_tm(p_seconds).tm_gmtoff;
+    }
+    return m_states[state_index(p_seconds)].offset;
+}
+
+bool
+TimeZone::in_table(long long p_seconds) const
+{
+    return (p_seconds >= m_table_begin) && (p_seconds < m_table_end);
+}
+
+vector<TimeZone::State>::size_type
+TimeZone::state_index(long long p_seconds) const
+{
+    assert (in_table(p_seconds));
+    auto const it = upper_bound
+    (   m_states.begin(),
+        m_states.end(),
+        p_seconds,
+        [](long long p_lhs, State const& p_rhs) { return p_lhs < p_rhs.begin; }
+    );
+    assert (it != m_states.begin());
+    return (it - m_states.begin()) - 1;
+}
+
+long long
+TimeZone::resolve(long long p_local_seconds, int p_isdst) const
+{
+    auto const first = state_index(p_local_seconds - k_seconds_per_day);
+    auto const last = state_index(p_local_seconds + k_seconds_per_day);
+    auto const in_effect = [this](vector<State>::size_type p_index, long long p_seconds)
+    {
+        auto const next = p_index + 1;
+        return
+            (p_seconds >= m_states[p_index].begin) &&
+            ((next == m_states.size()) || (p_seconds < m_states[next].begin));
+    };
+
+    // Find the earliest occurrence of the local time, and the earliest under
+    // a state with the requested daylight saving flag.
+    auto const want_dst = (p_isdst > 0);
+    auto found_any = false;
+    auto found_wanted = false;
+    auto any_index = first;
+    long long any_seconds = 0;
+    long long wanted_seconds = 0;
+    for (auto i = first; i <= last; ++i)
+    {
+        auto const seconds = p_local_seconds - m_states[i].offset;
+        if (!in_effect(i, seconds))
+        {
+            continue;
+        }
+        if (!found_any || (seconds < any_seconds))
+        {
+            found_any = true;
+            any_index = i;
+            any_seconds = seconds;
+        }
+        if
+        (   (m_states[i].is_dst == want_dst) &&
+            (!found_wanted || (seconds < wanted_seconds))
+        )
+        {
+            found_wanted = true;
+            wanted_seconds = seconds;
+        }
+    }
+    if (p_isdst >= 0)
+    {
+        if (found_wanted)
+        {
+            return wanted_seconds;
+        }
+
+        // As with mktime, interpret the local time using the UTC offset of the
+        // nearest state with the requested daylight saving flag, if any.
+        auto const n = m_states.size();
+        for (decltype(m_states.size()) d = 0; (d <= any_index) || (any_index + d < n); ++d)
+        {
+            if ((d <= any_index) && (m_states[any_index - d].is_dst == want_dst))
+            {
+                return p_local_seconds - m_states[any_index - d].offset;
+            }
+            if ((any_index + d < n) && (m_states[any_index + d].is_dst == want_dst))
+            {
+                return p_local_seconds - m_states[any_index + d].offset;
+            }
+        }
+
+        // There is no such state, so, as with mktime, assume that daylight
+        // saving would add one hour.
+        if (found_any)
+        {
+            return any_seconds + (want_dst ? -60 * 60 : 60 * 60);
+        }
+    }
+    if (found_any)
+    {
+        return any_seconds;
+    }
+
+    // The local time falls in a gap, so interpret it using the UTC offset in
+    // effect immediately beforehand, moving it forward past the gap.
+    for (auto i = first; i < last; ++i)
+    {
+        auto const transition = m_states[i + 1].begin;
+        if
+        (   (p_local_seconds - m_states[i].offset >= transition) &&
+            (p_local_seconds - m_states[i + 1].offset < transition)
+        )
+        {
+            return p_local_seconds - m_states[i].offset;
+        }
+    }
+    assert (false);
+    return p_local_seconds - m_states[first].offset;
+}
+
+}  // namespace swx
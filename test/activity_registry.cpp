@@ -0,0 +1,79 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "activity_registry.hpp"
+#include <boost/test/unit_test.hpp>
+#include <map>
+#include <memory>
+#include <string>
+
+using std::make_shared;
+using std::map;
+using std::string;
+using std::to_string;
+using swx::ActivityRecord;
+using swx::ActivityRegistry;
+using swx::ActivityTable;
+
+namespace test
+{
+
+BOOST_AUTO_TEST_CASE(activity_registry_insert_find_erase)
+{
+    ActivityTable activity_table;
+    ActivityRegistry registry(activity_table);
+    ActivityRegistry::ActivityId activity_id = 0;
+    BOOST_CHECK(registry.empty());
+    BOOST_CHECK(!registry.find("anything", activity_id));
+
+    // Enough activities for the table to grow several times, then erase
+    // every third, checking against a map as they go.
+    map<string, ActivityRegistry::ActivityId> expected;
+    for (ActivityRegistry::ActivityId i = 0; i != 500; ++i)
+    {
+        auto const activity = "activity " + to_string(i);
+        activity_table.push_back(ActivityRecord{make_shared<string const>(activity), 1});
+        BOOST_CHECK(registry.insert(activity, i));
+        BOOST_CHECK(!registry.insert(activity, i));
+        expected[activity] = i;
+    }
+    BOOST_CHECK_EQUAL(registry.size(), 500);
+    for (ActivityRegistry::ActivityId i = 0; i < 500; i += 3)
+    {
+        auto const& activity = *activity_table[i].name;
+        registry.erase(activity);
+        expected.erase(activity);
+    }
+    BOOST_CHECK_EQUAL(registry.size(), expected.size());
+    for (auto const& record: activity_table)
+    {
+        auto const it = expected.find(*record.name);
+        auto const found = registry.find(*record.name, activity_id);
+        BOOST_CHECK_EQUAL(found, it != expected.end());
+        if (found && (it != expected.end()))
+        {
+            BOOST_CHECK_EQUAL(activity_id, it->second);
+        }
+    }
+    BOOST_CHECK(!registry.contains("activity 500"));
+    BOOST_CHECK(registry.contains("activity 1"));
+
+    registry.clear();
+    BOOST_CHECK(registry.empty());
+    BOOST_CHECK(!registry.contains("activity 1"));
+}
+
+}  // namespace test
@@ -0,0 +1,171 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "activity_tree.hpp"
+#include "activity_stats.hpp"
+#include <boost/test/unit_test.hpp>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::map;
+using std::ostream;
+using std::ostringstream;
+using std::string;
+using std::to_string;
+using std::vector;
+using swx::ActivityStats;
+using swx::ActivityTree;
+
+namespace test
+{
+
+namespace
+{
+    // Returns a line for each node that p_tree prints to a depth less than
+    // p_depth_limit (or to any depth if it is 0), giving its depth, label
+    // and seconds.
+    vector<string> print(ActivityTree const& p_tree, unsigned int p_depth_limit = 0)
+    {
+        vector<string> ret;
+        ostringstream oss;
+        p_tree.print
+        (   oss,
+            [&ret, p_depth_limit]
+            (   ostream& p_os,
+                unsigned int p_depth,
+                string const& p_label,
+                ActivityStats const& p_stats
+            )
+            {
+                (void)p_os;  // silence compiler warning re. unused param.
+                if (p_depth_limit == 0 || p_depth < p_depth_limit)
+                {
+                    ret.push_back
+                    (   to_string(p_depth) + " [" + p_label + "] " +
+                        to_string(p_stats.seconds)
+                    );
+                }
+            }
+        );
+        return ret;
+    }
+
+    map<string, ActivityStats> stats(map<string, unsigned long long> const& p_seconds)
+    {
+        map<string, ActivityStats> ret;
+        for (auto const& pair: p_seconds)
+        {
+            ret[pair.first] = ActivityStats(pair.second);
+        }
+        return ret;
+    }
+
+}  // end anonymous namespace
+
+BOOST_AUTO_TEST_CASE(activity_tree_folds_single_children)
+{
+    ActivityTree const tree(stats({{"a b c", 1}, {"d", 2}}));
+    BOOST_CHECK
+    (   print(tree) ==
+        (vector<string>{"0 [] 3", "1 [a b c] 1", "1 [d] 2"})
+    );
+    ActivityTree const branching_tree
+    (   stats({{"a b c", 1}, {"a b d", 2}, {"a e", 4}, {"f g h", 8}, {"f g i j", 16}})
+    );
+    BOOST_CHECK
+    (   print(branching_tree) ==
+        (   vector<string>
+            {   "0 [] 31",
+                "1 [a] 7",
+                "2 [b] 3",
+                "3 [c] 1",
+                "3 [d] 2",
+                "2 [e] 4",
+                "1 [f g] 24",
+                "2 [h] 8",
+                "2 [i j] 16"
+            }
+        )
+    );
+}
+
+BOOST_AUTO_TEST_CASE(activity_tree_odd_spacing)
+{
+    // Only a single space separates components: a tab is part of a component,
+    // and doubled or trailing spaces give empty components.
+    ActivityTree const tree(stats({{"a\tb", 1}, {"a  b", 2}, {"a ", 4}, {"a b", 8}}));
+    BOOST_CHECK
+    (   print(tree) ==
+        (   vector<string>
+            {   "0 [] 15",
+                "1 [a] 14",
+                "2 [] 6",
+                "3 [] 4",
+                "3 [b] 2",
+                "2 [b] 8",
+                "1 [a\tb] 1"
+            }
+        )
+    );
+}
+
+BOOST_AUTO_TEST_CASE(activity_tree_unsorted_components)
+{
+    // A tab sorts before a space, so the map does not hold these in the order
+    // of their components.
+    ActivityTree const tree(stats({{"p", 1}, {"p\tq", 2}, {"p q", 4}, {"p!q", 8}}));
+    BOOST_CHECK
+    (   print(tree) ==
+        (   vector<string>
+            {   "0 [] 15",
+                "1 [p] 5",
+                "2 [] 1",
+                "2 [q] 4",
+                "1 [p\tq] 2",
+                "1 [p!q] 8"
+            }
+        )
+    );
+}
+
+BOOST_AUTO_TEST_CASE(activity_tree_depth_limit)
+{
+    auto const activity_stats = stats
+    (   {   {"a b c", 1},
+            {"a b d", 2},
+            {"a e", 4},
+            {"f g h", 8},
+            {"f g i j", 16},
+            {"k", 32}
+        }
+    );
+    ActivityTree const full_tree(activity_stats);
+    for (unsigned int depth_limit: {0, 1, 2})
+    {
+        ActivityTree const tree(activity_stats, depth_limit);
+        BOOST_CHECK(print(tree, depth_limit) == print(full_tree, depth_limit));
+    }
+    ActivityTree const tree(activity_stats, 2);
+    BOOST_CHECK
+    (   print(tree, 2) ==
+        (vector<string>{"0 [] 63", "1 [a] 7", "1 [f g] 24", "1 [k] 32"})
+    );
+    BOOST_CHECK_EQUAL(print(ActivityTree(activity_stats, 1), 1).size(), 1);
+}
+
+}  // namespace test
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "activity_trie.hpp"
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using swx::ActivityTrie;
+using std::sort;
+using std::string;
+using std::vector;
+
+namespace test
+{
+
+namespace
+{
+    vector<ActivityTrie::ActivityId> find_subactivities
+    (   ActivityTrie const& p_trie,
+        string const& p_activity
+    )
+    {
+        vector<ActivityTrie::ActivityId> ret;
+        p_trie.find_subactivities(p_activity, ret);
+        sort(ret.begin(), ret.end());
+        return ret;
+    }
+
+}  // end anonymous namespace
+
+BOOST_AUTO_TEST_CASE(activity_trie_find_subactivities)
+{
+    ActivityTrie trie;
+    trie.insert("", 0);
+    trie.insert("a", 1);
+    trie.insert("a b", 2);
+    trie.insert("a b c", 3);
+    trie.insert("a bc", 4);
+    trie.insert("ab", 5);
+    trie.insert("x a b", 6);
+
+    using Ids = vector<ActivityTrie::ActivityId>;
+    BOOST_CHECK(find_subactivities(trie, "a") == (Ids{1, 2, 3, 4}));
+    BOOST_CHECK(find_subactivities(trie, "a b") == (Ids{2, 3}));
+    BOOST_CHECK(find_subactivities(trie, "a b c") == (Ids{3}));
+    BOOST_CHECK(find_subactivities(trie, "ab") == (Ids{5}));
+    BOOST_CHECK(find_subactivities(trie, "b") == (Ids{}));
+    BOOST_CHECK(find_subactivities(trie, "a b ") == (Ids{}));
+    BOOST_CHECK(find_subactivities(trie, "") == (Ids{0}));
+
+    // Intermediate nodes with no activity of their own contribute nothing.
+    BOOST_CHECK(find_subactivities(trie, "x") == (Ids{6}));
+}
+
+BOOST_AUTO_TEST_CASE(activity_trie_erase)
+{
+    ActivityTrie trie;
+    trie.insert("a", 1);
+    trie.insert("a b", 2);
+    trie.erase("a");
+    trie.erase("nothing");
+    using Ids = vector<ActivityTrie::ActivityId>;
+    BOOST_CHECK(find_subactivities(trie, "a") == (Ids{2}));
+    trie.insert("a", 7);
+    BOOST_CHECK(find_subactivities(trie, "a") == (Ids{2, 7}));
+    trie.clear();
+    BOOST_CHECK(find_subactivities(trie, "a") == (Ids{}));
+}
+
+}  // namespace test
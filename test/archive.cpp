@@ -0,0 +1,119 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "archive.hpp"
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using std::runtime_error;
+using std::string;
+using std::vector;
+using swx::ArchivedEntries;
+using swx::archive_compression_is_available;
+using swx::decode_archive;
+using swx::encode_archive;
+using swx::is_archive;
+using swx::is_compressed_archive;
+
+namespace test
+{
+
+namespace
+{
+    ArchivedEntries sample_entries()
+    {
+        ArchivedEntries ret;
+        ret.activities = vector<string>{"", "proj a", "proj b"};
+        ret.seconds = vector<std::int64_t>{-7200, 0, 0, 1500000000, 1500003600};
+        ret.activity_numbers = vector<std::uint32_t>{1, 0, 2, 1, 0};
+        return ret;
+    }
+
+    void check_round_trip(bool p_compress)
+    {
+        auto const entries = sample_entries();
+        auto const archive = encode_archive(entries, p_compress);
+        auto const begin = archive.data();
+        auto const end = archive.data() + archive.size();
+        BOOST_CHECK(is_archive(begin, end));
+        BOOST_CHECK_EQUAL(is_compressed_archive(begin, end), p_compress);
+        ArchivedEntries decoded;
+        decoded.activities.push_back("left over");
+        decode_archive(begin, end, decoded);
+        BOOST_CHECK(decoded.activities == entries.activities);
+        BOOST_CHECK(decoded.seconds == entries.seconds);
+        BOOST_CHECK(decoded.activity_numbers == entries.activity_numbers);
+    }
+
+}  // end anonymous namespace
+
+BOOST_AUTO_TEST_CASE(archive_round_trip)
+{
+    check_round_trip(false);
+    if (archive_compression_is_available())
+    {
+        check_round_trip(true);
+    }
+    else
+    {
+        BOOST_CHECK_THROW(encode_archive(sample_entries(), true), runtime_error);
+    }
+
+    ArchivedEntries empty;
+    auto const archive = encode_archive(empty, false);
+    ArchivedEntries decoded = sample_entries();
+    decode_archive(archive.data(), archive.data() + archive.size(), decoded);
+    BOOST_CHECK(decoded.activities.empty());
+    BOOST_CHECK(decoded.seconds.empty());
+    BOOST_CHECK(decoded.activity_numbers.empty());
+}
+
+BOOST_AUTO_TEST_CASE(archive_invalid)
+{
+    auto const check_invalid = [](string const& p_bytes)
+    {
+        ArchivedEntries entries;
+        BOOST_CHECK_THROW
+        (   decode_archive(p_bytes.data(), p_bytes.data() + p_bytes.size(), entries),
+            runtime_error
+        );
+    };
+    string const text("2017-01-01T09:00 proj a\n");
+    BOOST_CHECK(!is_archive(text.data(), text.data() + text.size()));
+    check_invalid(text);
+    check_invalid("");
+
+    auto const archive = encode_archive(sample_entries(), false);
+    for (string::size_type i = 0; i != archive.size(); ++i)
+    {
+        check_invalid(archive.substr(0, i));  // truncated
+    }
+    check_invalid(archive + '\0');  // trailing garbage
+
+    auto bad_flag = archive;
+    bad_flag[8] = 7;
+    check_invalid(bad_flag);
+
+    // activity number out of range
+    auto bad_activity = archive;
+    bad_activity[archive.size() - 1] = 3;
+    check_invalid(bad_activity);
+}
+
+}  // namespace test
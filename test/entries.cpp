@@ -0,0 +1,127 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "entries.hpp"
+#include "time_point.hpp"
+#include <boost/test/unit_test.hpp>
+#include <vector>
+
+using std::vector;
+using swx::Entries;
+using swx::EpochSeconds;
+
+namespace test
+{
+
+BOOST_AUTO_TEST_CASE(entries_bounds)
+{
+    Entries entries;
+    BOOST_CHECK(entries.empty());
+    BOOST_CHECK_EQUAL(entries.lower_bound(0), 0);
+    entries.push_back(0, 100);
+    entries.push_back(1, 200);
+    entries.push_back(0, 200);
+    entries.push_back(2, 300);
+    BOOST_CHECK_EQUAL(entries.size(), 4);
+    BOOST_CHECK_EQUAL(entries.seconds(2), 200);
+    BOOST_CHECK_EQUAL(entries.activity_id(3), 2);
+    BOOST_CHECK(entries.time_point(0) == swx::seconds_to_time_point(100));
+    BOOST_CHECK_EQUAL(entries.lower_bound(50), 0);
+    BOOST_CHECK_EQUAL(entries.lower_bound(200), 1);
+    BOOST_CHECK_EQUAL(entries.upper_bound(200), 3);
+    BOOST_CHECK_EQUAL(entries.upper_bound(300), 4);
+}
+
+BOOST_AUTO_TEST_CASE(entries_postings_and_activity_seconds)
+{
+    // Activity 0 has enough entries for the total time spent on it to be
+    // found from a running total, while activities 1 and 2 do not.
+    Entries entries;
+    EpochSeconds seconds = 0;
+    for (int i = 0; i != 300; ++i)
+    {
+        entries.push_back(0, seconds);
+        seconds += i % 7 + 1;
+        entries.push_back(((i % 10 == 0)? 1: 2), seconds);
+        seconds += 5;
+    }
+    auto const& postings = entries.postings(0);
+    BOOST_REQUIRE_EQUAL(postings.size(), 300);
+    BOOST_CHECK_EQUAL(postings[1], 2);
+    BOOST_CHECK_EQUAL(entries.postings(1).size(), 30);
+    BOOST_CHECK(entries.postings(7).empty());
+
+    for (Entries::ActivityId activity_id = 0; activity_id != 3; ++activity_id)
+    {
+        for (Entries::Index b = 0; b < 600; b += 37)
+        {
+            for (auto e = b; e < 600; e += 53)
+            {
+                EpochSeconds expected = 0;
+                for (auto i = b; i != e; ++i)
+                {
+                    if (entries.activity_id(i) == activity_id)
+                    {
+                        expected += entries.seconds(i + 1) - entries.seconds(i);
+                    }
+                }
+                BOOST_CHECK_EQUAL(entries.activity_seconds(activity_id, b, e), expected);
+            }
+        }
+    }
+    BOOST_CHECK_EQUAL(entries.activity_seconds(1, 0, 599), 30 * 5);
+
+    // The posting lists are rebuilt once the entries change.
+    entries.set(1, 0, entries.seconds(1));
+    BOOST_CHECK_EQUAL(entries.postings(0).size(), 301);
+    BOOST_CHECK_EQUAL(entries.postings(1).size(), 29);
+    BOOST_CHECK_EQUAL(entries.activity_seconds(0, 0, 2), 1 + 5);
+}
+
+BOOST_AUTO_TEST_CASE(entries_num_unmodified)
+{
+    Entries entries;
+    for (EpochSeconds i = 0; i != 10; ++i)
+    {
+        entries.push_back(i % 2, i * 60);
+    }
+    BOOST_CHECK_EQUAL(entries.num_unmodified(), 0);
+    entries.mark_unmodified();
+    BOOST_CHECK_EQUAL(entries.num_unmodified(), 10);
+    entries.push_back(0, 600);
+    BOOST_CHECK_EQUAL(entries.num_unmodified(), 10);
+    entries.set(7, 1, 7 * 60);
+    BOOST_CHECK_EQUAL(entries.num_unmodified(), 7);
+    entries.truncate(5);
+    BOOST_CHECK_EQUAL(entries.num_unmodified(), 5);
+    entries.pop_back();
+    BOOST_CHECK_EQUAL(entries.num_unmodified(), 4);
+
+    Entries other;
+    other.append(entries, 2);
+    BOOST_CHECK_EQUAL(other.size(), 2);
+    BOOST_CHECK_EQUAL(other.seconds(0), 120);
+    other.mark_unmodified();
+    entries.swap(other);
+    BOOST_CHECK_EQUAL(entries.size(), 2);
+    BOOST_CHECK_EQUAL(other.size(), 4);
+    BOOST_CHECK_EQUAL(entries.num_unmodified(), 0);
+    BOOST_CHECK_EQUAL(other.num_unmodified(), 0);
+    entries.clear();
+    BOOST_CHECK(entries.empty());
+}
+
+}  // namespace test
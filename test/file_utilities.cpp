@@ -0,0 +1,75 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "file_utilities.hpp"
+#include "temporary_directory.hpp"
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+
+using std::remove;
+using std::rename;
+using swx::FileSignature;
+using swx::file_signature;
+
+namespace test
+{
+
+BOOST_AUTO_TEST_CASE(file_signature_of_missing_file)
+{
+    TemporaryDirectory const directory;
+    auto const signature = file_signature(directory.filepath("missing"));
+    BOOST_CHECK(!signature.exists);
+    BOOST_CHECK(signature == FileSignature());
+    BOOST_CHECK(signature == file_signature(directory.filepath("missing")));
+}
+
+BOOST_AUTO_TEST_CASE(file_signature_of_untouched_file)
+{
+    TemporaryDirectory const directory;
+    directory.write("file", "abc\n");
+    auto const signature = file_signature(directory.filepath("file"));
+    BOOST_CHECK(signature.exists);
+    BOOST_CHECK_EQUAL(signature.size, 4);
+    BOOST_CHECK(signature == file_signature(directory.filepath("file")));
+    BOOST_CHECK(!(signature != file_signature(directory.filepath("file"))));
+}
+
+BOOST_AUTO_TEST_CASE(file_signature_mismatch_after_change)
+{
+    TemporaryDirectory const directory;
+    directory.write("file", "abc\n");
+    auto const original = file_signature(directory.filepath("file"));
+
+    // Modified in place
+    directory.write("file", "abcdef\n");
+    auto const modified = file_signature(directory.filepath("file"));
+    BOOST_CHECK(modified != original);
+
+    // Replaced by another file
+    directory.write("other", "abcdef\n");
+    rename(directory.filepath("other").c_str(), directory.filepath("file").c_str());
+    auto const replaced = file_signature(directory.filepath("file"));
+    BOOST_CHECK(replaced != modified);
+    BOOST_CHECK(replaced.inode != modified.inode);
+
+    // Removed
+    remove(directory.filepath("file").c_str());
+    auto const removed = file_signature(directory.filepath("file"));
+    BOOST_CHECK(removed != replaced);
+    BOOST_CHECK(!removed.exists);
+}
+
+}  // namespace test
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "filter_memo.hpp"
+#include "activity_registry.hpp"
+#include "activity_trie.hpp"
+#include "ordinary_activity_filter.hpp"
+#include "regex_activity_filter.hpp"
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+using std::make_shared;
+using std::sort;
+using std::string;
+using std::vector;
+using swx::ActivityRecord;
+using swx::ActivityTable;
+using swx::ActivityTrie;
+using swx::FilterMemo;
+using swx::OrdinaryActivityFilter;
+using swx::RegexActivityFilter;
+
+namespace test
+{
+
+BOOST_AUTO_TEST_CASE(filter_memo_matching_activity_ids)
+{
+    // The activity "a c" is no longer in use, so is not in the trie, and is
+    // never among the matching activities.
+    ActivityTable activity_table;
+    ActivityTrie activity_trie;
+    vector<string> const names{"a", "a b", "ab", "a c", "b"};
+    for (FilterMemo::ActivityId i = 0; i != names.size(); ++i)
+    {
+        auto const in_use = (names[i] != "a c");
+        activity_table.push_back
+        (   ActivityRecord{make_shared<string const>(names[i]), in_use? 1u: 0u}
+        );
+        if (in_use) activity_trie.insert(names[i], i);
+    }
+
+    // A subactivity filter is resolved through the trie.
+    OrdinaryActivityFilter const ordinary_filter("a");
+    FilterMemo ordinary_memo(activity_table, activity_trie, ordinary_filter);
+    auto ids = ordinary_memo.matching_activity_ids();
+    sort(ids.begin(), ids.end());
+    BOOST_CHECK((ids == vector<FilterMemo::ActivityId>{0, 1}));
+    BOOST_CHECK(ordinary_memo.matches(1));
+    BOOST_CHECK(!ordinary_memo.matches(2));
+    BOOST_CHECK(!ordinary_memo.matches(3));
+
+    // Any other filter is applied to each activity in use.
+    RegexActivityFilter const regex_filter("^a");
+    FilterMemo regex_memo(activity_table, activity_trie, regex_filter);
+    BOOST_CHECK(regex_memo.matches(3));
+    BOOST_CHECK(!regex_memo.matches(4));
+    ids = regex_memo.matching_activity_ids();
+    BOOST_CHECK((ids == vector<FilterMemo::ActivityId>{0, 1, 2}));
+}
+
+}  // namespace test
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hash.hpp"
+#include <boost/test/unit_test.hpp>
+#include <string>
+
+using std::string;
+
+namespace test
+{
+
+BOOST_AUTO_TEST_CASE(hash_bytes)
+{
+    using swx::hash_bytes;
+
+    string const empty;
+    string const a("a");
+    string const foobar("foobar");
+    auto const h = [](string const& s, unsigned long long seed)
+    {
+        return hash_bytes(s.data(), s.data() + s.size(), seed);
+    };
+
+    // published FNV-1a test vectors
+    BOOST_CHECK_EQUAL(hash_bytes(empty.data(), empty.data()), 0xcbf29ce484222325ULL);
+    BOOST_CHECK_EQUAL(hash_bytes(a.data(), a.data() + a.size()), 0xaf63dc4c8601ec8cULL);
+    BOOST_CHECK_EQUAL
+    (   hash_bytes(foobar.data(), foobar.data() + foobar.size()),
+        0x85944171f73967e8ULL
+    );
+
+    // hash can be accumulated over several ranges
+    auto const foo_hash = hash_bytes(foobar.data(), foobar.data() + 3);
+    BOOST_CHECK_EQUAL(h("bar", foo_hash), h("foobar", 0xcbf29ce484222325ULL));
+    BOOST_CHECK(h("foobar", 0xcbf29ce484222325ULL) != h("foobaz", 0xcbf29ce484222325ULL));
+}
+
+}  // namespace test
@@ -0,0 +1,193 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "log_index.hpp"
+#include "activity_registry.hpp"
+#include "entries.hpp"
+#include "rollup.hpp"
+#include <boost/test/unit_test.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+using std::make_shared;
+using std::string;
+using std::vector;
+using swx::ActivityRecord;
+using swx::ActivityTable;
+using swx::Entries;
+using swx::LogIndexHeader;
+using swx::LogIndexReader;
+using swx::RollupDay;
+using swx::RollupRow;
+using swx::encode_log_index;
+
+namespace test
+{
+
+namespace
+{
+    LogIndexHeader sample_header()
+    {
+        LogIndexHeader ret;
+        ret.file_signature.exists = true;
+        ret.file_signature.device = 1;
+        ret.file_signature.inode = 2;
+        ret.file_signature.size = 300;
+        ret.file_signature.modification_seconds = 1500000000;
+        ret.file_signature.modification_nanoseconds = 5;
+        ret.file_tail_hash = 6;
+        ret.settings_hash = 7;
+        ret.last_saved_entry_offset = 250;
+        ret.file_ends_with_newline = false;
+        ret.manifest_hash = 8;
+        ret.segment_ends = vector<Entries::Index>{2};
+        return ret;
+    }
+
+    // The activity at position 1 of the table is unused.
+    void fill_sample(ActivityTable& p_activity_table, Entries& p_entries)
+    {
+        for (auto const name: {"a", "unused", "b"})
+        {
+            p_activity_table.push_back(ActivityRecord{make_shared<string const>(name), 0});
+        }
+        Entries::ActivityId const activity_ids[] = {0, 2, 0, 2};
+        for (int i = 0; i != 4; ++i)
+        {
+            p_entries.push_back(activity_ids[i], 86400 * i);
+            ++p_activity_table[activity_ids[i]].reference_count;
+        }
+    }
+
+    vector<RollupDay> sample_rollup()
+    {
+        RollupDay day;
+        day.begin = 86400;
+        day.end = 2 * 86400;
+        day.has_boundary_stints = true;
+        day.rows.push_back(RollupRow{2, 86400, 86400, 2 * 86400});
+        return vector<RollupDay>{day};
+    }
+
+}  // end anonymous namespace
+
+BOOST_AUTO_TEST_CASE(log_index_round_trip)
+{
+    ActivityTable activity_table;
+    Entries entries;
+    fill_sample(activity_table, entries);
+    auto const header = sample_header();
+    auto const index =
+        encode_log_index(header, activity_table, entries, sample_rollup());
+
+    LogIndexReader reader(index.data(), index.data() + index.size());
+    LogIndexHeader read_header;
+    BOOST_REQUIRE(reader.read_header(read_header));
+    BOOST_CHECK(read_header.file_signature == header.file_signature);
+    BOOST_CHECK_EQUAL(read_header.file_tail_hash, header.file_tail_hash);
+    BOOST_CHECK_EQUAL(read_header.settings_hash, header.settings_hash);
+    BOOST_CHECK_EQUAL
+    (   read_header.last_saved_entry_offset,
+        header.last_saved_entry_offset
+    );
+    BOOST_CHECK(!read_header.file_ends_with_newline);
+    BOOST_CHECK_EQUAL(read_header.manifest_hash, header.manifest_hash);
+    BOOST_CHECK(read_header.segment_ends == header.segment_ends);
+
+    // The unused activity is omitted, and the others renumbered.
+    vector<string> activities;
+    Entries read_entries;
+    vector<RollupDay> rollup;
+    BOOST_REQUIRE(reader.read_body(activities, read_entries, rollup));
+    BOOST_CHECK(activities == (vector<string>{"a", "b"}));
+    BOOST_REQUIRE_EQUAL(read_entries.size(), entries.size());
+    for (Entries::Index i = 0; i != entries.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(read_entries.seconds(i), entries.seconds(i));
+        BOOST_CHECK_EQUAL(read_entries.activity_id(i), i % 2);
+    }
+    BOOST_REQUIRE_EQUAL(rollup.size(), 1);
+    BOOST_CHECK_EQUAL(rollup[0].begin, 86400);
+    BOOST_CHECK(rollup[0].has_boundary_stints);
+    BOOST_REQUIRE_EQUAL(rollup[0].rows.size(), 1);
+    BOOST_CHECK_EQUAL(rollup[0].rows[0].activity_id, 1);
+    BOOST_CHECK_EQUAL(rollup[0].rows[0].seconds, 86400);
+}
+
+BOOST_AUTO_TEST_CASE(log_index_invalid)
+{
+    ActivityTable activity_table;
+    Entries entries;
+    fill_sample(activity_table, entries);
+    auto const index =
+        encode_log_index(sample_header(), activity_table, entries, sample_rollup());
+    auto const read = [](string const& p_index, vector<RollupDay>& p_rollup)
+    {
+        LogIndexReader reader(p_index.data(), p_index.data() + p_index.size());
+        LogIndexHeader header;
+        vector<string> activities;
+        Entries entries;
+        return
+            reader.read_header(header) &&
+            reader.read_body(activities, entries, p_rollup);
+    };
+    vector<RollupDay> rollup;
+    BOOST_CHECK(read(index, rollup));
+    BOOST_CHECK_EQUAL(rollup.size(), 1);
+
+    // A rollup section that has been tampered with is discarded, without
+    // invalidating the rest of the index.
+    auto corrupt_rollup = index;
+    corrupt_rollup[corrupt_rollup.size() - 1] ^= 1;
+    rollup.clear();
+    BOOST_CHECK(read(corrupt_rollup, rollup));
+    BOOST_CHECK(rollup.empty());
+
+    // Anything else is an invalid index.
+    auto bad_tag = index;
+    bad_tag[0] = 'X';
+    rollup.clear();
+    BOOST_CHECK(!read(bad_tag, rollup));
+    for (auto const size: {string::size_type(0), index.size() / 2, index.size() - 1})
+    {
+        rollup.clear();
+        BOOST_CHECK(!read(index.substr(0, size), rollup));
+    }
+    rollup.clear();
+    BOOST_CHECK(!read(index + '\0', rollup));
+
+    // Entries out of order are invalid.
+    auto header = sample_header();
+    header.segment_ends.clear();
+    vector<RollupDay> const no_rollup;
+    Entries ordered;
+    ordered.push_back(0, 50);
+    ordered.push_back(2, 100);
+    rollup.clear();
+    auto const ordered_index =
+        encode_log_index(header, activity_table, ordered, no_rollup);
+    BOOST_CHECK(read(ordered_index, rollup));
+    Entries unordered;
+    unordered.push_back(0, 100);
+    unordered.push_back(2, 50);
+    rollup.clear();
+    auto const unordered_index =
+        encode_log_index(header, activity_table, unordered, no_rollup);
+    BOOST_CHECK(!read(unordered_index, rollup));
+}
+
+}  // namespace test
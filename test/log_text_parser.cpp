@@ -0,0 +1,153 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "log_text_parser.hpp"
+#include "mapped_file.hpp"
+#include "temporary_directory.hpp"
+#include "time_point.hpp"
+#include "time_stamp_parser.hpp"
+#include "time_zone_guard.hpp"
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using std::runtime_error;
+using std::string;
+using std::to_string;
+using std::vector;
+using swx::LogTextParser;
+using swx::MappedFile;
+using swx::ParsedChunk;
+using swx::TimePoint;
+using swx::TimeStampParser;
+using swx::line_number_at;
+using swx::time_point_to_seconds;
+
+namespace test
+{
+
+namespace
+{
+    char const k_time_format[] = "%Y-%m-%dT%H:%M";
+    unsigned int const k_time_stamp_length = 16;
+
+}  // end anonymous namespace
+
+BOOST_AUTO_TEST_CASE(log_text_parser_parse_line)
+{
+    TimeZoneGuard const guard("UTC");
+    TemporaryDirectory const directory;
+    directory.write("log", "2023-04-15T10:30   proj a  \n2023-04-15T11:00\nshort\n");
+    MappedFile const file(directory.filepath("log"));
+    LogTextParser const parser(k_time_format, k_time_stamp_length);
+    TimeStampParser time_stamp_parser(k_time_format);
+    string activity = "left over";
+
+    auto const first = file.begin();
+    auto const second = first + std::strlen("2023-04-15T10:30   proj a  \n");
+    auto const third = second + std::strlen("2023-04-15T11:00\n");
+    auto const time_point =
+        parser.parse_line(time_stamp_parser, file, first, second - 1, activity);
+    BOOST_CHECK_EQUAL(activity, "proj a");
+    BOOST_CHECK
+    (   time_point == swx::long_time_stamp_to_point("2023-04-15T10:30", k_time_format)
+    );
+    parser.parse_line(time_stamp_parser, file, second, third - 1, activity);
+    BOOST_CHECK_EQUAL(activity, "");
+
+    BOOST_CHECK_EQUAL(line_number_at(file, first), 1);
+    BOOST_CHECK_EQUAL(line_number_at(file, third), 3);
+    try
+    {
+        parser.parse_line(time_stamp_parser, file, third, file.end() - 1, activity);
+        BOOST_ERROR("Expected runtime_error.");
+    }
+    catch (runtime_error& e)
+    {
+        BOOST_CHECK_EQUAL(string(e.what()), "Error parsing the time log at line 3.");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(log_text_parser_parse_chunks)
+{
+    TimeZoneGuard const guard("UTC");
+    TemporaryDirectory const directory;
+    string contents;
+    vector<string> activities;
+    for (int i = 0; i != 200; ++i)
+    {
+        auto const minute = to_string(100 + i % 60).substr(1);
+        auto const hour = to_string(100 + i / 60).substr(1);
+        activities.push_back("activity " + to_string(i % 7 / 2));
+        contents += "2023-04-15T" + hour + ':' + minute + ' ' + activities.back() + '\n';
+    }
+    directory.write("log", contents);
+    MappedFile const file(directory.filepath("log"));
+    LogTextParser const parser(k_time_format, k_time_stamp_length);
+
+    // The chunks, taken together, hold every entry, with consecutive
+    // entries of the same activity combined.
+    auto const chunks = parser.parse_chunks(file, file.begin(), file.end(), 3, 0);
+    BOOST_REQUIRE_EQUAL(chunks.size(), 3);
+    BOOST_CHECK(chunks.back().end == file.end());
+    // Consecutive entries of the same activity are combined within a chunk,
+    // but not across chunks.
+    TimeStampParser time_stamp_parser(k_time_format);
+    auto const line_length = k_time_stamp_length + 12;
+    vector<string>::size_type line = 0;
+    for (auto const& chunk: chunks)
+    {
+        BOOST_CHECK(!chunk.failed);
+        BOOST_CHECK(parser.parses_alike(chunk.begin, chunk.end, 0, 0));
+        BOOST_CHECK_EQUAL((chunk.begin - file.begin()) % line_length, 0);
+        auto const begin_line = (chunk.begin - file.begin()) / line_length;
+        auto const end_line =
+            static_cast<vector<string>::size_type>(chunk.end - file.begin()) / line_length;
+        BOOST_CHECK_EQUAL(line, static_cast<vector<string>::size_type>(begin_line));
+        auto const& entries = chunk.entries;
+        for (decltype(entries.seconds.size()) i = 0; i != entries.seconds.size(); ++i)
+        {
+            auto const& activity = entries.activities[entries.activity_numbers[i]];
+            BOOST_REQUIRE(line < end_line);
+            BOOST_CHECK_EQUAL(activity, activities[line]);
+            auto const line_begin = file.begin() + line * line_length;
+            BOOST_CHECK_EQUAL
+            (   entries.seconds[i],
+                time_point_to_seconds
+                (   time_stamp_parser.parse(line_begin, line_begin + k_time_stamp_length)
+                )
+            );
+            while ((line != end_line) && (activities[line] == activity))
+            {
+                ++line;
+            }
+        }
+    }
+    BOOST_CHECK_EQUAL(line, activities.size());
+
+    // A chunk containing a line that cannot be parsed is marked as failed.
+    directory.write("bad", contents + "garbage\n");
+    MappedFile const bad_file(directory.filepath("bad"));
+    auto const bad_chunks =
+        parser.parse_chunks(bad_file, bad_file.begin(), bad_file.end(), 2, 0);
+    BOOST_CHECK(!bad_chunks.front().failed);
+    BOOST_CHECK(bad_chunks.back().failed);
+}
+
+}  // namespace test
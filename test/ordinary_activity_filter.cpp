@@ -52,4 +52,11 @@ BOOST_AUTO_TEST_CASE(ordinary_activity_filter_replace)
     BOOST_CHECK_EQUAL(OrdinaryActivityFilter("a b").replace("a b c  d", " "), "c d");
 }
 
+BOOST_AUTO_TEST_CASE(ordinary_activity_filter_subactivity_root)
+{
+    OrdinaryActivityFilter const filter("hello there");
+    BOOST_REQUIRE(filter.subactivity_root() != nullptr);
+    BOOST_CHECK_EQUAL(*filter.subactivity_root(), "hello there");
+}
+
 }  // namespace test
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rename_command.hpp"
+#include "config.hpp"
+#include "stint.hpp"
+#include "temporary_directory.hpp"
+#include "time_log.hpp"
+#include "true_activity_filter.hpp"
+#include <boost/test/unit_test.hpp>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::ostringstream;
+using std::string;
+using std::vector;
+using swx::Config;
+using swx::RenameCommand;
+using swx::TimeLog;
+using swx::TrueActivityFilter;
+
+namespace test
+{
+
+BOOST_AUTO_TEST_CASE(rename_command_missing_file)
+{
+    TemporaryDirectory const directory;
+    directory.write("log", "2017-01-01T09:00 a\n");
+    Config const config(directory.filepath("config"));
+    TimeLog time_log(directory.filepath("log"), "%Y-%m-%dT%H:%M", 50, false);
+    RenameCommand command("rename", vector<string>(), time_log);
+    auto const renamings_filepath = directory.filepath("missing");
+    ostringstream ordinary_stream;
+    ostringstream error_stream;
+    auto const exit_code = command.process
+    (   config,
+        vector<string>{"-f", renamings_filepath},
+        ordinary_stream,
+        error_stream
+    );
+    BOOST_CHECK_EQUAL(exit_code, EXIT_FAILURE);
+    BOOST_CHECK_EQUAL
+    (   error_stream.str(),
+        "Could not open file at " + renamings_filepath + ".\n"
+    );
+    BOOST_CHECK_EQUAL(ordinary_stream.str(), "");
+    auto const stints = time_log.get_stints(TrueActivityFilter(), nullptr, nullptr);
+    BOOST_REQUIRE_EQUAL(stints.size(), 1);
+    BOOST_CHECK_EQUAL(stints[0].activity(), "a");
+}
+
+}  // namespace test
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rollup.hpp"
+#include "entries.hpp"
+#include "time_point.hpp"
+#include "time_zone_guard.hpp"
+#include <boost/test/unit_test.hpp>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+using swx::Entries;
+using swx::EpochSeconds;
+using swx::RollupDay;
+using swx::long_time_stamp_to_point;
+using swx::time_point_to_seconds;
+using swx::update_rollup;
+
+namespace test
+{
+
+namespace
+{
+    EpochSeconds seconds(string const& p_time_stamp)
+    {
+        return time_point_to_seconds
+        (   long_time_stamp_to_point(p_time_stamp, "%Y-%m-%dT%H:%M")
+        );
+    }
+
+    // Returns the seconds spent on p_activity_id during p_day.
+    EpochSeconds day_seconds(RollupDay const& p_day, Entries::ActivityId p_activity_id)
+    {
+        for (auto const& row: p_day.rows)
+        {
+            if (row.activity_id == p_activity_id) return row.seconds;
+        }
+        return 0;
+    }
+
+}  // end anonymous namespace
+
+BOOST_AUTO_TEST_CASE(rollup_suffix)
+{
+    // The entries begin part-way through a day, as when only a suffix of the
+    // log has been loaded; so the rollup begins at the following midnight.
+    TimeZoneGuard const guard("UTC");
+    Entries entries;
+    entries.push_back(0, seconds("2017-03-01T15:00"));
+    entries.push_back(1, seconds("2017-03-02T06:00"));
+    entries.push_back(2, seconds("2017-03-03T00:00"));
+    entries.push_back(0, seconds("2017-03-03T00:00"));
+    entries.push_back(1, seconds("2017-03-04T12:00"));
+    vector<RollupDay> rollup;
+    update_rollup(entries, rollup);
+    BOOST_CHECK_EQUAL(entries.num_unmodified(), entries.size());
+    BOOST_REQUIRE_EQUAL(rollup.size(), 2);
+    BOOST_CHECK_EQUAL(rollup[0].begin, seconds("2017-03-02T00:00"));
+    BOOST_CHECK_EQUAL(rollup[0].end, seconds("2017-03-03T00:00"));
+    BOOST_CHECK_EQUAL(rollup[1].end, seconds("2017-03-04T00:00"));
+    BOOST_CHECK_EQUAL(day_seconds(rollup[0], 0), 6 * 60 * 60);
+    BOOST_CHECK_EQUAL(day_seconds(rollup[0], 1), 18 * 60 * 60);
+    BOOST_CHECK(!rollup[0].has_boundary_stints);
+    BOOST_CHECK_EQUAL(day_seconds(rollup[1], 0), 24 * 60 * 60);
+    BOOST_CHECK_EQUAL(day_seconds(rollup[1], 2), 0);
+    BOOST_CHECK(rollup[1].has_boundary_stints);
+    BOOST_CHECK_EQUAL(rollup[1].rows.size(), 1);
+    BOOST_CHECK_EQUAL(rollup[1].rows[0].beginning, seconds("2017-03-03T00:00"));
+
+    // When earlier entries are loaded, the entries are replaced, and the
+    // rollup is rebuilt from the new first entry.
+    Entries suffix;
+    suffix.swap(entries);
+    entries.push_back(1, seconds("2017-02-28T20:00"));
+    entries.append(suffix, 0);
+    update_rollup(entries, rollup);
+    BOOST_REQUIRE_EQUAL(rollup.size(), 3);
+    BOOST_CHECK_EQUAL(rollup[0].begin, seconds("2017-03-01T00:00"));
+    BOOST_CHECK_EQUAL(day_seconds(rollup[0], 1), 15 * 60 * 60);
+    BOOST_CHECK_EQUAL(day_seconds(rollup[0], 0), 9 * 60 * 60);
+    BOOST_CHECK_EQUAL(day_seconds(rollup[2], 0), 24 * 60 * 60);
+
+    // A later change discards only the days that may be affected by it.
+    entries.set(4, 0, seconds("2017-03-03T18:00"));
+    update_rollup(entries, rollup);
+    BOOST_REQUIRE_EQUAL(rollup.size(), 3);
+    BOOST_CHECK_EQUAL(rollup[2].begin, seconds("2017-03-03T00:00"));
+    BOOST_CHECK_EQUAL(day_seconds(rollup[2], 2), 18 * 60 * 60);
+    BOOST_CHECK_EQUAL(day_seconds(rollup[2], 0), 6 * 60 * 60);
+    BOOST_CHECK(!rollup[2].has_boundary_stints);
+}
+
+}  // namespace test
@@ -0,0 +1,175 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "segment_manifest.hpp"
+#include "entries.hpp"
+#include "time_point.hpp"
+#include "time_zone_guard.hpp"
+#include <boost/test/unit_test.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using std::runtime_error;
+using std::string;
+using std::vector;
+using swx::Entries;
+using swx::Segment;
+using swx::SegmentEncoding;
+using swx::Segmentation;
+using swx::append_period_segments;
+using swx::decode_manifest;
+using swx::encode_manifest;
+using swx::long_time_stamp_to_point;
+using swx::parse_segmentation;
+using swx::period_begin;
+using swx::period_label;
+using swx::time_point_to_seconds;
+
+namespace test
+{
+
+namespace
+{
+    swx::EpochSeconds seconds(string const& p_time_stamp)
+    {
+        return time_point_to_seconds
+        (   long_time_stamp_to_point(p_time_stamp, "%Y-%m-%dT%H:%M")
+        );
+    }
+
+}  // end anonymous namespace
+
+BOOST_AUTO_TEST_CASE(segment_manifest_periods)
+{
+    TimeZoneGuard const guard("UTC");
+    BOOST_CHECK(parse_segmentation("none") == Segmentation::none);
+    BOOST_CHECK(parse_segmentation("yearly") == Segmentation::yearly);
+    BOOST_CHECK(parse_segmentation("monthly") == Segmentation::monthly);
+    BOOST_CHECK_THROW(parse_segmentation("weekly"), runtime_error);
+
+    auto const time_point = swx::seconds_to_time_point(seconds("2023-04-15T10:30"));
+    BOOST_CHECK_EQUAL(period_label(time_point, Segmentation::yearly), "2023");
+    BOOST_CHECK_EQUAL(period_label(time_point, Segmentation::monthly), "2023-04");
+    BOOST_CHECK_EQUAL
+    (   time_point_to_seconds(period_begin(time_point, Segmentation::yearly)),
+        seconds("2023-01-01T00:00")
+    );
+    BOOST_CHECK_EQUAL
+    (   time_point_to_seconds(period_begin(time_point, Segmentation::monthly)),
+        seconds("2023-04-01T00:00")
+    );
+}
+
+BOOST_AUTO_TEST_CASE(segment_manifest_append_period_segments)
+{
+    TimeZoneGuard const guard("UTC");
+    Entries entries;
+    for
+    (   auto const time_stamp:
+        {   "2022-12-31T23:00",
+            "2023-01-01T00:00",
+            "2023-01-15T08:00",
+            "2023-03-02T09:00",
+            "2023-03-03T09:00"
+        }
+    )
+    {
+        entries.push_back(entries.size() % 2, seconds(time_stamp));
+    }
+
+    // The label of a period that already has a segment is made unique.
+    vector<Segment> segments(1);
+    segments[0].label = "2023-01";
+    append_period_segments(entries, 0, 4, Segmentation::monthly, segments);
+    BOOST_REQUIRE_EQUAL(segments.size(), 4);
+    BOOST_CHECK_EQUAL(segments[1].label, "2022-12");
+    BOOST_CHECK_EQUAL(segments[1].end, 1);
+    BOOST_CHECK_EQUAL(segments[2].label, "2023-01_2");
+    BOOST_CHECK_EQUAL(segments[2].end, 3);
+    BOOST_CHECK_EQUAL(segments[3].label, "2023-03");
+    BOOST_CHECK_EQUAL(segments[3].end, 4);
+    BOOST_CHECK(segments[3].encoding == SegmentEncoding::text);
+
+    segments.clear();
+    append_period_segments(entries, 1, 5, Segmentation::yearly, segments);
+    BOOST_REQUIRE_EQUAL(segments.size(), 1);
+    BOOST_CHECK_EQUAL(segments[0].label, "2023");
+    BOOST_CHECK_EQUAL(segments[0].end, 5);
+}
+
+BOOST_AUTO_TEST_CASE(segment_manifest_round_trip)
+{
+    vector<Segment> segments(2);
+    segments[0].label = "2022";
+    segments[0].first_seconds = 100;
+    segments[0].last_seconds = 200;
+    segments[0].num_entries = 3;
+    segments[0].activities = vector<string>{"a", "b"};
+    segments[0].encoding = SegmentEncoding::compressed_archive;
+    segments[1].label = "2023";
+    segments[1].first_seconds = 300;
+    segments[1].last_seconds = 300;
+    segments[1].num_entries = 1;
+    segments[1].activities = vector<string>{""};
+    segments[1].encoding = SegmentEncoding::text;
+
+    for (auto const rotating: {false, true})
+    {
+        auto const manifest = encode_manifest(segments, rotating);
+        auto const begin = manifest.data();
+        auto const end = begin + manifest.size();
+        vector<Segment> decoded;
+        auto decoded_rotating = !rotating;
+        BOOST_REQUIRE(decode_manifest(begin, end, decoded, decoded_rotating));
+        BOOST_CHECK_EQUAL(decoded_rotating, rotating);
+        BOOST_REQUIRE_EQUAL(decoded.size(), segments.size());
+        for (vector<Segment>::size_type i = 0; i != segments.size(); ++i)
+        {
+            BOOST_CHECK_EQUAL(decoded[i].label, segments[i].label);
+            BOOST_CHECK_EQUAL(decoded[i].first_seconds, segments[i].first_seconds);
+            BOOST_CHECK_EQUAL(decoded[i].last_seconds, segments[i].last_seconds);
+            BOOST_CHECK_EQUAL(decoded[i].num_entries, segments[i].num_entries);
+            BOOST_CHECK(decoded[i].activities == segments[i].activities);
+            BOOST_CHECK(decoded[i].encoding == segments[i].encoding);
+            BOOST_CHECK_EQUAL(decoded[i].end, 0);
+        }
+
+        // Truncated or altered manifests are rejected.
+        BOOST_CHECK(!decode_manifest(begin, end - 1, decoded, decoded_rotating));
+        auto bad_tag = manifest;
+        bad_tag[0] = 'X';
+        auto const bad_begin = bad_tag.data();
+        auto const bad_end = bad_begin + bad_tag.size();
+        BOOST_CHECK(!decode_manifest(bad_begin, bad_end, decoded, decoded_rotating));
+    }
+
+    // A segment must have at least one entry.
+    segments[1].num_entries = 0;
+    auto const manifest = encode_manifest(segments, false);
+    vector<Segment> decoded;
+    auto rotating = false;
+    BOOST_CHECK
+    (   !decode_manifest
+        (   manifest.data(),
+            manifest.data() + manifest.size(),
+            decoded,
+            rotating
+        )
+    );
+}
+
+}  // namespace test
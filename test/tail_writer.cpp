@@ -0,0 +1,139 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tail_writer.hpp"
+#include "file_utilities.hpp"
+#include "hash.hpp"
+#include "temporary_directory.hpp"
+#include <boost/test/unit_test.hpp>
+#include <string>
+
+using std::string;
+using std::to_string;
+using swx::TailWriter;
+using swx::file_exists_at;
+using swx::hash_bytes;
+
+namespace test
+{
+
+namespace
+{
+    string const k_original = "2017-01-01T09:00 a\n2017-01-01T10:00 b\n";
+    unsigned long long const k_offset = 19;  // the beginning of the second line
+    string const k_tail = "2017-01-01T10:30 c\n2017-01-01T11:00 d\n";
+
+    string journal_header(unsigned long long p_offset, string const& p_tail)
+    {
+        return
+            "swx-journal " + to_string(p_offset) + ' ' + to_string(p_tail.size()) +
+            ' ' + to_string(hash_bytes(p_tail.data(), p_tail.data() + p_tail.size())) +
+            '\n';
+    }
+
+}  // end anonymous namespace
+
+BOOST_AUTO_TEST_CASE(tail_writer_commit)
+{
+    TemporaryDirectory const directory;
+    directory.write("log", k_original);
+    // anonymous scope
+    {
+        TailWriter writer(directory.filepath("log"), k_offset);
+        writer.append(k_tail.substr(0, 19));
+        writer.append(k_tail.substr(19));
+        BOOST_CHECK_EQUAL(directory.read("log"), k_original);
+        writer.commit();
+    }
+    BOOST_CHECK_EQUAL(directory.read("log"), k_original.substr(0, k_offset) + k_tail);
+    BOOST_CHECK(!file_exists_at(directory.filepath("log.journal")));
+
+    // Replacing the tail with something shorter truncates the file.
+    TailWriter writer(directory.filepath("log"), 0);
+    writer.append("x\n");
+    writer.commit();
+    BOOST_CHECK_EQUAL(directory.read("log"), "x\n");
+}
+
+BOOST_AUTO_TEST_CASE(tail_writer_recover_without_journal)
+{
+    TemporaryDirectory const directory;
+    directory.write("log", k_original);
+    TailWriter::recover(directory.filepath("log"));
+    BOOST_CHECK_EQUAL(directory.read("log"), k_original);
+}
+
+BOOST_AUTO_TEST_CASE(tail_writer_recover_complete_journal)
+{
+    TemporaryDirectory const directory;
+    directory.write("log", k_original);
+    directory.write("log.journal", journal_header(k_offset, k_tail) + k_tail);
+    TailWriter::recover(directory.filepath("log"));
+    BOOST_CHECK_EQUAL(directory.read("log"), k_original.substr(0, k_offset) + k_tail);
+    BOOST_CHECK(!file_exists_at(directory.filepath("log.journal")));
+
+    // Replaying the same journal again changes nothing further.
+    directory.write("log.journal", journal_header(k_offset, k_tail) + k_tail);
+    TailWriter::recover(directory.filepath("log"));
+    BOOST_CHECK_EQUAL(directory.read("log"), k_original.substr(0, k_offset) + k_tail);
+}
+
+BOOST_AUTO_TEST_CASE(tail_writer_recover_incomplete_journal)
+{
+    TemporaryDirectory const directory;
+    directory.write("log", k_original);
+    auto const journal = journal_header(k_offset, k_tail) + k_tail;
+
+    // Truncated within the tail
+    directory.write("log.journal", journal.substr(0, journal.size() - 1));
+    TailWriter::recover(directory.filepath("log"));
+    BOOST_CHECK_EQUAL(directory.read("log"), k_original);
+    BOOST_CHECK(!file_exists_at(directory.filepath("log.journal")));
+
+    // Truncated within the header
+    directory.write("log.journal", journal.substr(0, 15));
+    TailWriter::recover(directory.filepath("log"));
+    BOOST_CHECK_EQUAL(directory.read("log"), k_original);
+    BOOST_CHECK(!file_exists_at(directory.filepath("log.journal")));
+
+    // Empty
+    directory.write("log.journal", "");
+    TailWriter::recover(directory.filepath("log"));
+    BOOST_CHECK_EQUAL(directory.read("log"), k_original);
+    BOOST_CHECK(!file_exists_at(directory.filepath("log.journal")));
+}
+
+BOOST_AUTO_TEST_CASE(tail_writer_recover_bad_checksum)
+{
+    TemporaryDirectory const directory;
+    directory.write("log", k_original);
+    auto corrupted_tail = k_tail;
+    corrupted_tail[0] = '3';
+    directory.write("log.journal", journal_header(k_offset, k_tail) + corrupted_tail);
+    TailWriter::recover(directory.filepath("log"));
+    BOOST_CHECK_EQUAL(directory.read("log"), k_original);
+    BOOST_CHECK(!file_exists_at(directory.filepath("log.journal")));
+
+    // A journal with the wrong tag is discarded likewise.
+    auto header = journal_header(k_offset, k_tail);
+    header[0] = 'S';
+    directory.write("log.journal", header + k_tail);
+    TailWriter::recover(directory.filepath("log"));
+    BOOST_CHECK_EQUAL(directory.read("log"), k_original);
+    BOOST_CHECK(!file_exists_at(directory.filepath("log.journal")));
+}
+
+}  // namespace test
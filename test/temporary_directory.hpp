@@ -0,0 +1,131 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_temporary_directory_hpp_6584662129125487
+#define GUARD_temporary_directory_hpp_6584662129125487
+
+#include <dirent.h>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <stdexcept>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// NOTE This is non-portable. POSIX is assumed.
+
+namespace test
+{
+
+/**
+ * Creates an empty directory for the lifetime of the object, removing it,
+ * along with any files created in it, on destruction. Subdirectories are
+ * not supported.
+ */
+class TemporaryDirectory
+{
+// special member functions
+public:
+    TemporaryDirectory()
+    {
+        std::string const pattern = "/tmp/swx_test_XXXXXX";
+        std::vector<char> path_template(pattern.begin(), pattern.end());
+        path_template.push_back('\0');
+        if (mkdtemp(path_template.data()) == nullptr)
+        {
+            throw std::runtime_error("Could not create temporary directory.");
+        }
+        m_path = path_template.data();
+    }
+    TemporaryDirectory(TemporaryDirectory const& rhs) = delete;
+    TemporaryDirectory(TemporaryDirectory&& rhs) = delete;
+    TemporaryDirectory& operator=(TemporaryDirectory const& rhs) = delete;
+    TemporaryDirectory& operator=(TemporaryDirectory&& rhs) = delete;
+    ~TemporaryDirectory()
+    {
+        auto const directory = opendir(m_path.c_str());
+        if (directory)
+        {
+            for (auto entry = readdir(directory); entry; entry = readdir(directory))
+            {
+                std::string const name = entry->d_name;
+                if ((name != ".") && (name != ".."))
+                {
+                    unlink(filepath(name).c_str());
+                }
+            }
+            closedir(directory);
+        }
+        rmdir(m_path.c_str());
+    }
+
+// ordinary member functions
+public:
+
+    /**
+     * @returns the path of the file named \e p_name within the directory.
+     */
+    std::string filepath(std::string const& p_name) const
+    {
+        return m_path + '/' + p_name;
+    }
+
+    /**
+     * Creates or overwrites the file named \e p_name within the directory,
+     * giving it the contents \e p_contents.
+     */
+    void write(std::string const& p_name, std::string const& p_contents) const
+    {
+        std::ofstream outfile
+        (   filepath(p_name).c_str(),
+            std::ios_base::out | std::ios_base::binary | std::ios_base::trunc
+        );
+        outfile << p_contents;
+        if (!outfile.flush())
+        {
+            throw std::runtime_error("Could not write file at " + filepath(p_name) + ".");
+        }
+    }
+
+    /**
+     * @returns the contents of the file named \e p_name within the directory.
+     */
+    std::string read(std::string const& p_name) const
+    {
+        std::ifstream infile
+        (   filepath(p_name).c_str(),
+            std::ios_base::in | std::ios_base::binary
+        );
+        if (!infile)
+        {
+            throw std::runtime_error("Could not open file at " + filepath(p_name) + ".");
+        }
+        return std::string
+        (   std::istreambuf_iterator<char>(infile),
+            std::istreambuf_iterator<char>()
+        );
+    }
+
+// member variables
+private:
+    std::string m_path;
+};
+
+}  // namespace test
+
+#endif  // GUARD_temporary_directory_hpp_6584662129125487
@@ -0,0 +1,888 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "time_log.hpp"
+#include "activity_filter.hpp"
+#include "activity_stats.hpp"
+#include "archive.hpp"
+#include "exact_activity_filter.hpp"
+#include "file_utilities.hpp"
+#include "hash.hpp"
+#include "log_text_parser.hpp"
+#include "regex_activity_filter.hpp"
+#include "segment_manifest.hpp"
+#include "stint.hpp"
+#include "temporary_directory.hpp"
+#include "time_point.hpp"
+#include "time_zone_guard.hpp"
+#include "true_activity_filter.hpp"
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using std::map;
+using std::pair;
+using std::runtime_error;
+using std::string;
+using std::to_string;
+using std::vector;
+using swx::ActivityFilter;
+using swx::ActivityStats;
+using swx::ExactActivityFilter;
+using swx::LogTextParser;
+using swx::RegexActivityFilter;
+using swx::Segment;
+using swx::Stint;
+using swx::TimeLog;
+using swx::TimePoint;
+using swx::TrueActivityFilter;
+using swx::archive_compression_is_available;
+using swx::decode_manifest;
+using swx::encode_manifest;
+using swx::file_signature;
+using swx::file_exists_at;
+using swx::hash_bytes;
+using swx::is_archive;
+using swx::is_compressed_archive;
+using swx::long_time_stamp_to_point;
+using swx::now;
+using swx::time_point_to_stamp;
+
+namespace test
+{
+
+namespace
+{
+    char const k_time_format[] = "%Y-%m-%dT%H:%M";
+
+    TimePoint time_point(string const& p_time_stamp)
+    {
+        return long_time_stamp_to_point(p_time_stamp, k_time_format);
+    }
+
+    vector<string> activities(TimeLog& p_time_log)
+    {
+        vector<string> ret;
+        auto const stints = p_time_log.get_stints(TrueActivityFilter(), nullptr, nullptr);
+        for (auto const& stint: stints)
+        {
+            ret.push_back(stint.activity());
+        }
+        return ret;
+    }
+
+    // Returns the number of seconds spent on each activity between p_begin
+    // and p_end.
+    map<string, unsigned long long> activity_seconds
+    (   TimeLog& p_time_log,
+        string const& p_begin,
+        string const& p_end
+    )
+    {
+        map<string, unsigned long long> ret;
+        auto const begin = time_point(p_begin);
+        auto const end = time_point(p_end);
+        auto const stats =
+            p_time_log.get_activity_stats(TrueActivityFilter(), &begin, &end);
+        for (auto const& pair: stats)
+        {
+            ret[pair.first] = pair.second.seconds;
+        }
+        return ret;
+    }
+
+    // Returns a description of each of p_stints, for comparison.
+    vector<string> describe(vector<Stint> const& p_stints)
+    {
+        vector<string> ret;
+        for (auto const& stint: p_stints)
+        {
+            auto const interval = stint.interval();
+            ret.push_back
+            (   stint.activity() + ' ' +
+                to_string(interval.beginning().time_since_epoch().count()) + ' ' +
+                to_string(interval.duration().count())
+            );
+        }
+        return ret;
+    }
+
+    // Returns the text of a log with an entry for each of p_activities, the
+    // first at p_first, and each of the others p_minutes after the one before.
+    string log_text
+    (   vector<string> const& p_activities,
+        string const& p_first,
+        int p_minutes
+    )
+    {
+        string ret;
+        auto stamp_time = time_point(p_first);
+        for (auto const& activity: p_activities)
+        {
+            ret += time_point_to_stamp(stamp_time, k_time_format, 50);
+            ret += (activity.empty() ? "" : " " + activity) + '\n';
+            stamp_time += std::chrono::minutes(p_minutes);
+        }
+        return ret;
+    }
+
+    // Returns the combined ActivityStats of those of p_stints that are not
+    // inactive.
+    ActivityStats total_stats(vector<Stint> const& p_stints)
+    {
+        ActivityStats ret;
+        for (auto const& stint: p_stints)
+        {
+            if (stint.activity().empty()) continue;
+            auto const interval = stint.interval();
+            ret += ActivityStats
+            (   interval.duration().count(),
+                interval.beginning(),
+                interval.ending()
+            );
+        }
+        return ret;
+    }
+
+    // Makes LogTextParser divide even a small log into p_num_chunks chunks
+    // for the lifetime of the object, as if there were as many processors.
+    class ChunkingGuard
+    {
+    public:
+        explicit ChunkingGuard(unsigned int p_num_chunks)
+        {
+            LogTextParser::set_chunking(p_num_chunks, 1);
+        }
+        ChunkingGuard(ChunkingGuard const& rhs) = delete;
+        ChunkingGuard(ChunkingGuard&& rhs) = delete;
+        ChunkingGuard& operator=(ChunkingGuard const& rhs) = delete;
+        ChunkingGuard& operator=(ChunkingGuard&& rhs) = delete;
+        ~ChunkingGuard()
+        {
+            LogTextParser::set_chunking(0, 0);
+        }
+    };
+
+    // Returns the message of the exception thrown on loading the log at
+    // p_filepath, or an empty string if none is thrown.
+    string load_error(string const& p_filepath)
+    {
+        try
+        {
+            TimeLog time_log(p_filepath, k_time_format, 50, false);
+            time_log.get_stints(TrueActivityFilter(), nullptr, nullptr);
+        }
+        catch (runtime_error& e)
+        {
+            return e.what();
+        }
+        return string();
+    }
+
+    // Returns "text", "archive" or "compressed" according to the encoding of
+    // the file named p_name in p_directory.
+    string encoding(TemporaryDirectory const& p_directory, string const& p_name)
+    {
+        auto const contents = p_directory.read(p_name);
+        auto const begin = contents.data();
+        auto const end = contents.data() + contents.size();
+        if (is_compressed_archive(begin, end)) return "compressed";
+        if (is_archive(begin, end)) return "archive";
+        return "text";
+    }
+
+}  // end anonymous namespace
+
+BOOST_AUTO_TEST_CASE(time_log_replays_journal_on_load)
+{
+    TemporaryDirectory const directory;
+    directory.write("log", "2017-01-01T09:00 a\n2017-01-01T10:00 b\n");
+
+    // As left by a save that was interrupted after its journal was written
+    string const tail = "2017-01-01T10:30 c\n";
+    directory.write
+    (   "log.journal",
+        "swx-journal 19 " + to_string(tail.size()) + ' ' +
+            to_string(hash_bytes(tail.data(), tail.data() + tail.size())) + '\n' + tail
+    );
+    TimeLog time_log(directory.filepath("log"), k_time_format, 50, false);
+    BOOST_CHECK((activities(time_log) == vector<string>{"a", "c"}));
+    BOOST_CHECK_EQUAL(directory.read("log"), "2017-01-01T09:00 a\n" + tail);
+    BOOST_CHECK(!file_exists_at(directory.filepath("log.journal")));
+}
+
+BOOST_AUTO_TEST_CASE(time_log_discards_incomplete_journal_on_load)
+{
+    TemporaryDirectory const directory;
+    string const original = "2017-01-01T09:00 a\n2017-01-01T10:00 b\n";
+    directory.write("log", original);
+    string const tail = "2017-01-01T10:30 c\n";
+    directory.write
+    (   "log.journal",
+        "swx-journal 19 " + to_string(tail.size()) + ' ' +
+            to_string(hash_bytes(tail.data(), tail.data() + tail.size())) + '\n' +
+            tail.substr(0, 10)
+    );
+    TimeLog time_log(directory.filepath("log"), k_time_format, 50, false);
+    BOOST_CHECK((activities(time_log) == vector<string>{"a", "b"}));
+    BOOST_CHECK_EQUAL(directory.read("log"), original);
+    BOOST_CHECK(!file_exists_at(directory.filepath("log.journal")));
+}
+
+BOOST_AUTO_TEST_CASE(time_log_saves_tail)
+{
+    TemporaryDirectory const directory;
+    directory.write("log", "2017-01-01T09:00 a\n2017-01-01T10:00 b");
+    // anonymous scope
+    {
+        TimeLog time_log(directory.filepath("log"), k_time_format, 50, false);
+        time_log.append_entry("c", time_point("2017-01-01T11:00"));
+    }
+    BOOST_CHECK_EQUAL
+    (   directory.read("log"),
+        "2017-01-01T09:00 a\n2017-01-01T10:00 b\n2017-01-01T11:00 c\n"
+    );
+    BOOST_CHECK(!file_exists_at(directory.filepath("log.journal")));
+    // anonymous scope
+    {
+        TimeLog time_log(directory.filepath("log"), k_time_format, 50, false);
+        time_log.amend_last("d", time_point("2017-01-01T11:30"));
+    }
+    BOOST_CHECK_EQUAL
+    (   directory.read("log"),
+        "2017-01-01T09:00 a\n2017-01-01T10:00 b\n2017-01-01T11:30 d\n"
+    );
+    BOOST_CHECK(!file_exists_at(directory.filepath("log.journal")));
+}
+
+BOOST_AUTO_TEST_CASE(time_log_compact_keeps_compression)
+{
+    TemporaryDirectory const directory;
+    directory.write("log", "2015-06-01T09:00 a\n2016-06-01T09:00 b\n");
+    TimeLog time_log(directory.filepath("log"), k_time_format, 50, false, "yearly");
+
+    // Saving an entry from a later year moves the earlier ones into segments.
+    time_log.append_entry("c", time_point("2017-06-01T09:00"));
+    BOOST_CHECK_EQUAL(encoding(directory, "log.2015"), "text");
+    BOOST_CHECK_EQUAL(encoding(directory, "log.2016"), "text");
+
+    BOOST_CHECK_EQUAL(time_log.compact(TimeLog::Compression::unchanged), 2);
+    BOOST_CHECK_EQUAL(encoding(directory, "log.2015"), "archive");
+    BOOST_CHECK_EQUAL(encoding(directory, "log.2016"), "archive");
+    BOOST_CHECK_EQUAL(time_log.compact(TimeLog::Compression::unchanged), 0);
+    if (archive_compression_is_available())
+    {
+        BOOST_CHECK_EQUAL(time_log.compact(TimeLog::Compression::compressed), 2);
+        BOOST_CHECK_EQUAL(encoding(directory, "log.2015"), "compressed");
+        BOOST_CHECK_EQUAL(time_log.compact(TimeLog::Compression::unchanged), 0);
+        BOOST_CHECK_EQUAL(encoding(directory, "log.2015"), "compressed");
+        BOOST_CHECK_EQUAL(encoding(directory, "log.2016"), "compressed");
+        BOOST_CHECK_EQUAL(time_log.compact(TimeLog::Compression::uncompressed), 2);
+        BOOST_CHECK_EQUAL(encoding(directory, "log.2015"), "archive");
+        BOOST_CHECK_EQUAL(encoding(directory, "log.2016"), "archive");
+    }
+    else
+    {
+        BOOST_CHECK_THROW
+        (   time_log.compact(TimeLog::Compression::compressed),
+            runtime_error
+        );
+    }
+    BOOST_CHECK((activities(time_log) == vector<string>{"a", "b", "c"}));
+}
+
+BOOST_AUTO_TEST_CASE(time_log_index_survives_invalid_rollup)
+{
+    TemporaryDirectory const directory;
+    directory.write
+    (   "log",
+        "2017-03-01T09:00 a\n2017-03-02T10:00 b\n2017-03-03T11:00 a\n"
+            "2017-03-04T12:00 c\n"
+    );
+    string const begin = "2017-03-01T00:00";
+    string const end = "2017-03-05T00:00";
+    map<string, unsigned long long> const expected
+    {   {"a", (25 + 25) * 60 * 60},
+        {"b", 25 * 60 * 60},
+        {"c", 12 * 60 * 60}
+    };
+    // anonymous scope
+    {
+        TimeLog time_log(directory.filepath("log"), k_time_format, 50, true);
+        BOOST_CHECK((activities(time_log) == vector<string>{"a", "b", "a", "c"}));
+        BOOST_CHECK(activity_seconds(time_log, begin, end) == expected);
+    }
+    auto const index = directory.read("log.index");
+
+    // If only the rollup section is corrupt, then the rest of the index is
+    // still used, and it is not rewritten.
+    auto corrupted = index;
+    corrupted[corrupted.size() - 1] ^= 1;
+    directory.write("log.index", corrupted);
+    auto const signature = file_signature(directory.filepath("log.index"));
+    // anonymous scope
+    {
+        TimeLog time_log(directory.filepath("log"), k_time_format, 50, true);
+        BOOST_CHECK((activities(time_log) == vector<string>{"a", "b", "a", "c"}));
+        BOOST_CHECK(activity_seconds(time_log, begin, end) == expected);
+    }
+    BOOST_CHECK(file_signature(directory.filepath("log.index")) == signature);
+
+    // If the rest of the index is corrupt, then it is rebuilt.
+    corrupted = index;
+    corrupted[0] ^= 1;
+    directory.write("log.index", corrupted);
+    // anonymous scope
+    {
+        TimeLog time_log(directory.filepath("log"), k_time_format, 50, true);
+        BOOST_CHECK((activities(time_log) == vector<string>{"a", "b", "a", "c"}));
+        BOOST_CHECK(activity_seconds(time_log, begin, end) == expected);
+    }
+    BOOST_CHECK_EQUAL(directory.read("log.index"), index);
+}
+
+BOOST_AUTO_TEST_CASE(time_log_activity_stats_on_suffix)
+{
+    // The log is long enough that a query over its last few weeks loads only
+    // a suffix of it, and summarises the whole days in that suffix from the
+    // rollup. There are entries of zero duration at each midnight.
+    auto const two_digits = [](int p_n)
+    {
+        return string(p_n < 10 ? "0" : "") + to_string(p_n);
+    };
+    string const activity_names[] = {"a", "b", "c", "d", "e"};
+    string contents;
+    for (int month = 3; month != 6; ++month)
+    {
+        for (int day = 1; day != 29; ++day)
+        {
+            auto const date = "2017-" + two_digits(month) + "-" + two_digits(day);
+            contents += date + "T00:00 e\n";
+            contents += date + "T00:00 " + activity_names[day % 5] + "\n";
+            for (int hour = 1; hour != 24; ++hour)
+            {
+                contents +=
+                    date + "T" + two_digits(hour) + ":17 " +
+                    activity_names[(day + hour) % 5] + "\n";
+            }
+        }
+    }
+    TemporaryDirectory const directory;
+    directory.write("log", contents);
+    vector<pair<string, string>> const ranges
+    {   {"2017-05-20T00:00", "2017-05-28T00:00"},
+        {"2017-05-18T09:30", "2017-05-26T15:00"},
+        {"2017-05-22T00:00", "2017-05-22T00:00"},
+        {"2017-05-15T00:00", "2017-05-28T23:00"}
+    };
+    TimeLog full_time_log(directory.filepath("log"), k_time_format, 50, false);
+    BOOST_CHECK(!activities(full_time_log).empty());
+    TimeLog suffix_time_log(directory.filepath("log"), k_time_format, 50, false);
+    for (auto const& range: ranges)
+    {
+        auto const begin = time_point(range.first);
+        auto const end = time_point(range.second);
+        auto const expected =
+            full_time_log.get_activity_stats(TrueActivityFilter(), &begin, &end);
+        auto const actual =
+            suffix_time_log.get_activity_stats(TrueActivityFilter(), &begin, &end);
+        BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+        for (auto const& pair: expected)
+        {
+            auto const it = actual.find(pair.first);
+            BOOST_REQUIRE(it != actual.end());
+            ActivityStats const& stats = it->second;
+            BOOST_CHECK_EQUAL(stats.seconds, pair.second.seconds);
+            BOOST_CHECK(stats.beginning == pair.second.beginning);
+            BOOST_CHECK(stats.ending == pair.second.ending);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(time_log_total_stats)
+{
+    // "common" has enough entries for its time to be found from running
+    // totals, and "rare" too few; and some stints are inactive.
+    vector<string> log_activities;
+    for (int i = 0; i != 600; ++i)
+    {
+        if (i % 3 == 0) log_activities.push_back("common");
+        else if (i % 50 == 7) log_activities.push_back("rare");
+        else if (i % 7 == 1) log_activities.push_back("");
+        else log_activities.push_back("other " + to_string(i % 4));
+    }
+    TemporaryDirectory const directory;
+    directory.write("log", log_text(log_activities, "2016-01-01T09:00", 37));
+    TimeLog time_log(directory.filepath("log"), k_time_format, 50, false);
+
+    // When the range has no end, the last stint is still open, so the total
+    // is checked against totals found just before and just after the stints.
+    auto const check = [&time_log]
+    (   ActivityFilter const& p_filter,
+        TimePoint const* p_begin,
+        TimePoint const* p_end
+    )
+    {
+        auto const before = time_log.get_total_stats(p_filter, p_begin, p_end);
+        auto const expected =
+            total_stats(time_log.get_stints(p_filter, p_begin, p_end));
+        auto const after = time_log.get_total_stats(p_filter, p_begin, p_end);
+        BOOST_CHECK(before.beginning == expected.beginning);
+        BOOST_CHECK(after.beginning == expected.beginning);
+        BOOST_CHECK_LE(before.seconds, expected.seconds);
+        BOOST_CHECK_LE(expected.seconds, after.seconds);
+        BOOST_CHECK(before.ending <= expected.ending);
+        BOOST_CHECK(expected.ending <= after.ending);
+        if (p_end)
+        {
+            BOOST_CHECK_EQUAL(before.seconds, expected.seconds);
+            BOOST_CHECK(before.ending == expected.ending);
+        }
+    };
+    vector<pair<string, string>> const ranges
+    {   {"2015-12-31T00:00", "2016-01-20T00:00"},
+        {"2016-01-03T10:10", "2016-01-09T17:45"},
+        {"2016-01-05T00:00", "2016-01-05T00:50"},
+        {"2016-01-05T00:00", "2016-01-05T00:00"},
+        {"2016-01-08T00:00", ""},
+        {"", ""}
+    };
+    TrueActivityFilter const all;
+    ExactActivityFilter const common("common");
+    ExactActivityFilter const rare("rare");
+    ExactActivityFilter const inactive("");
+    RegexActivityFilter const sparse("^(rare|other 1)$");
+    RegexActivityFilter const active("^(common|rare|other .)$");
+    vector<ActivityFilter const*> const filters
+    {   &all,
+        &common,
+        &rare,
+        &inactive,
+        &sparse,
+        &active
+    };
+    for (auto const& range: ranges)
+    {
+        auto const begin = (range.first.empty() ? TimePoint() : time_point(range.first));
+        auto const end = (range.second.empty() ? TimePoint() : time_point(range.second));
+        auto const begin_ptr = (range.first.empty() ? nullptr : &begin);
+        auto const end_ptr = (range.second.empty() ? nullptr : &end);
+        for (auto const filter: filters)
+        {
+            check(*filter, begin_ptr, end_ptr);
+        }
+    }
+    BOOST_CHECK_EQUAL(time_log.get_total_stats(inactive, nullptr, nullptr).seconds, 0);
+}
+
+BOOST_AUTO_TEST_CASE(time_log_stints_of_rare_activities)
+{
+    // The "rare" activities account for too few of the entries for every
+    // entry in the range to be scanned, so they are visited by merging their
+    // posting lists. The last entry is not rare, so every rare stint is
+    // closed.
+    vector<string> log_activities;
+    for (int i = 0; i != 400; ++i)
+    {
+        if (i % 23 == 5) log_activities.push_back("rare a");
+        else if (i % 31 == 9) log_activities.push_back("rare b");
+        else if (i % 97 == 0) log_activities.push_back("rare c");
+        else log_activities.push_back("often " + to_string(i % 5));
+    }
+    TemporaryDirectory const directory;
+    directory.write("log", log_text(log_activities, "2016-01-01T09:00", 45));
+    TimeLog time_log(directory.filepath("log"), k_time_format, 50, false);
+    RegexActivityFilter const rare("^rare");
+    vector<pair<string, string>> const ranges
+    {   {"2015-12-31T00:00", "2016-02-01T00:00"},
+        {"2016-01-03T10:10", "2016-01-09T17:45"},
+        {"2016-01-04T03:00", "2016-01-05T03:00"},
+        {"2016-01-08T00:20", ""}
+    };
+    for (auto const& range: ranges)
+    {
+        auto const begin = time_point(range.first);
+        auto const end = (range.second.empty() ? TimePoint() : time_point(range.second));
+        auto const end_ptr = (range.second.empty() ? nullptr : &end);
+        vector<Stint> expected;
+        for (auto const& stint: time_log.get_stints(TrueActivityFilter(), &begin, end_ptr))
+        {
+            if (stint.activity().substr(0, 4) == "rare") expected.push_back(stint);
+        }
+        vector<Stint> visited;
+        time_log.for_each_stint
+        (   rare,
+            &begin,
+            end_ptr,
+            [&visited](Stint const& p_stint) { visited.push_back(p_stint); }
+        );
+        auto const stints = time_log.get_stints(rare, &begin, end_ptr);
+        BOOST_CHECK(!stints.empty());
+        BOOST_CHECK(describe(stints) == describe(expected));
+        BOOST_CHECK(describe(visited) == describe(expected));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(time_log_reloads_tail)
+{
+    // Each case gives the log as last loaded, and the log as it is then
+    // changed by another process. A failed append leaves the cache stale, so
+    // the next query reloads the log, reading only what has been appended if
+    // it can.
+    vector<pair<string, string>> const cases
+    {   // The appended lines repeat the last activity.
+        {   "2017-01-01T09:00 a\n2017-01-01T10:00 b\n",
+            "2017-01-01T09:00 a\n2017-01-01T10:00 b\n2017-01-01T10:30 b\n"
+                "2017-01-01T11:00 c\n"
+        },
+        // The last line is continued.
+        {   "2017-01-01T09:00 a\n2017-01-01T10:00 b",
+            "2017-01-01T09:00 a\n2017-01-01T10:00 bcd\n2017-01-01T11:00 b\n"
+        },
+        // The log is truncated.
+        {   "2017-01-01T09:00 a\n2017-01-01T10:00 b\n2017-01-01T11:00 c\n",
+            "2017-01-01T09:00 a\n2017-01-01T10:00 b\n"
+        },
+        // The log is rewritten, and then appended to.
+        {   "2017-01-01T09:00 a\n2017-01-01T10:00 b\n",
+            "2017-01-01T09:00 e\n2017-01-01T10:00 b\n2017-01-01T11:00 c\n"
+        }
+    };
+    auto const end = time_point("2017-01-02T00:00");
+    for (auto const& c: cases)
+    {
+        TemporaryDirectory const directory;
+        directory.write("log", c.first);
+        TimeLog time_log(directory.filepath("log"), k_time_format, 50, false);
+        auto const before = time_log.get_stints(TrueActivityFilter(), nullptr, &end);
+        BOOST_CHECK(!before.empty());
+        BOOST_CHECK_THROW
+        (   time_log.append_entry("z", now() + std::chrono::hours(1)),
+            runtime_error
+        );
+        directory.write("log", c.second);
+        TimeLog fresh_time_log(directory.filepath("log"), k_time_format, 50, false);
+        BOOST_CHECK
+        (   describe(time_log.get_stints(TrueActivityFilter(), nullptr, &end)) ==
+            describe(fresh_time_log.get_stints(TrueActivityFilter(), nullptr, &end))
+        );
+        BOOST_CHECK(time_log.last_activities(5) == fresh_time_log.last_activities(5));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(time_log_loads_text_in_chunks)
+{
+    // Each activity runs for several lines, so that runs of repeated
+    // activities span the boundaries between chunks.
+    TimeZoneGuard const guard("UTC");
+    vector<string> log_activities;
+    for (int i = 0; i != 60; ++i)
+    {
+        log_activities.push_back("a" + to_string(i / 7 % 3));
+    }
+    TemporaryDirectory const directory;
+    directory.write("log", log_text(log_activities, "2016-01-01T09:00", 10));
+    auto const end = time_point("2016-01-02T00:00");
+    TimeLog sequential_time_log(directory.filepath("log"), k_time_format, 50, false);
+    auto const expected =
+        describe(sequential_time_log.get_stints(TrueActivityFilter(), nullptr, &end));
+    BOOST_CHECK_EQUAL(expected.size(), 9);
+    for (unsigned int num_chunks = 2; num_chunks != 9; ++num_chunks)
+    {
+        ChunkingGuard const chunking_guard(num_chunks);
+        TimeLog time_log(directory.filepath("log"), k_time_format, 50, false);
+        BOOST_CHECK
+        (   describe(time_log.get_stints(TrueActivityFilter(), nullptr, &end)) ==
+            expected
+        );
+    }
+}
+
+BOOST_AUTO_TEST_CASE(time_log_reports_disorder_between_chunks)
+{
+    // Split in two, the log divides just before line 22, which is out of
+    // order with the line before it, but not with those after it.
+    TimeZoneGuard const guard("UTC");
+    vector<string> log_activities;
+    for (int i = 0; i != 40; ++i)
+    {
+        log_activities.push_back("a" + to_string(i % 3));
+    }
+    auto contents = log_text(log_activities, "2016-01-01T09:00", 10);
+    string const line_length = "2016-01-01T09:00 a0\n";
+    auto const position = 21 * line_length.size();
+    BOOST_REQUIRE_EQUAL(contents.substr(position, 16), "2016-01-01T12:30");
+    contents.replace(position, 16, "2016-01-01T12:15");
+    TemporaryDirectory const directory;
+    directory.write("log", contents);
+    string const expected = "Time log entries out of order at line 22.";
+    BOOST_CHECK_EQUAL(load_error(directory.filepath("log")), expected);
+    for (unsigned int num_chunks = 2; num_chunks != 6; ++num_chunks)
+    {
+        ChunkingGuard const chunking_guard(num_chunks);
+        BOOST_CHECK_EQUAL(load_error(directory.filepath("log")), expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(time_log_loads_chunks_across_fold)
+{
+    // The log runs through the hour that is repeated when daylight saving
+    // ends, but records only its first pass, which is how it is resolved when
+    // parsed in sequence. A chunk that begins within that hour is parsed as
+    // though in its second pass, so must be parsed again in sequence.
+    vector<string> log_activities;
+    for (int i = 0; i != 66; ++i)
+    {
+        log_activities.push_back("a" + to_string(i % 3));
+    }
+    TemporaryDirectory const directory;
+    // anonymous scope
+    {
+        // The time stamps run evenly through the hour, with no repeats.
+        TimeZoneGuard const guard("UTC");
+        directory.write("log", log_text(log_activities, "2016-10-29T20:00", 10));
+    }
+    TimeZoneGuard const guard("Europe/London");
+    auto const end = time_point("2016-10-31T00:00");
+    TimeLog sequential_time_log(directory.filepath("log"), k_time_format, 50, false);
+    auto const expected =
+        describe(sequential_time_log.get_stints(TrueActivityFilter(), nullptr, &end));
+    BOOST_CHECK_EQUAL(expected.size(), 66);
+    for (unsigned int num_chunks = 2; num_chunks != 13; ++num_chunks)
+    {
+        ChunkingGuard const chunking_guard(num_chunks);
+        TimeLog time_log(directory.filepath("log"), k_time_format, 50, false);
+        BOOST_CHECK
+        (   describe(time_log.get_stints(TrueActivityFilter(), nullptr, &end)) ==
+            expected
+        );
+    }
+}
+
+BOOST_AUTO_TEST_CASE(time_log_stints_outlive_time_log)
+{
+    TemporaryDirectory const directory;
+    directory.write("log", "2017-01-01T09:00 a\n2017-01-01T10:00 b\n");
+    auto const end = time_point("2017-01-01T11:00");
+    vector<Stint> stints;
+    vector<Stint> visited;
+    vector<string> expected;
+    // anonymous scope
+    {
+        TimeLog time_log(directory.filepath("log"), k_time_format, 50, false);
+        stints = time_log.get_stints(TrueActivityFilter(), nullptr, &end);
+        time_log.for_each_stint
+        (   TrueActivityFilter(),
+            nullptr,
+            &end,
+            [&visited](Stint const& p_stint) { visited.push_back(p_stint); }
+        );
+        expected = describe(stints);
+    }
+    BOOST_REQUIRE_EQUAL(stints.size(), 2);
+    BOOST_REQUIRE_EQUAL(visited.size(), 2);
+    BOOST_CHECK_EQUAL(stints[0].activity(), "a");
+    BOOST_CHECK_EQUAL(stints[1].activity(), "b");
+    BOOST_CHECK(describe(stints) == expected);
+    BOOST_CHECK(describe(visited) == expected);
+
+    // Now that the TimeLog has gone, each name is owned only by the Stints.
+    BOOST_CHECK(stints[0].activity_name() == visited[0].activity_name());
+    BOOST_CHECK_EQUAL(stints[0].activity_name().use_count(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(time_log_survives_failed_rotation)
+{
+    TemporaryDirectory const directory;
+    string const original = "2015-06-01T09:00 a\n2016-06-01T09:00 b\n";
+    directory.write("log", original);
+
+    // The segment for 2015 can be written, but not that for 2016, as a
+    // directory is in its way.
+    auto const blocked_filepath = directory.filepath("log.2016");
+    BOOST_REQUIRE_EQUAL(mkdir(blocked_filepath.c_str(), S_IRWXU), 0);
+    // anonymous scope
+    {
+        TimeLog time_log(directory.filepath("log"), k_time_format, 50, false, "yearly");
+        BOOST_CHECK_THROW
+        (   time_log.append_entry("c", time_point("2017-06-01T09:00")),
+            runtime_error
+        );
+        BOOST_CHECK((activities(time_log) == vector<string>{"a", "b", "c"}));
+    }
+    BOOST_CHECK_EQUAL(directory.read("log"), original + "2017-06-01T09:00 c\n");
+    BOOST_CHECK(!file_exists_at(directory.filepath("log.2015")));
+    BOOST_CHECK(!file_exists_at(directory.filepath("log.manifest")));
+    BOOST_CHECK(!file_exists_at(directory.filepath("log.staging")));
+    // anonymous scope
+    {
+        TimeLog time_log(directory.filepath("log"), k_time_format, 50, false, "yearly");
+        BOOST_CHECK((activities(time_log) == vector<string>{"a", "b", "c"}));
+    }
+
+    // Once the way is clear, the rotation succeeds on the next save.
+    BOOST_REQUIRE_EQUAL(rmdir(blocked_filepath.c_str()), 0);
+    // anonymous scope
+    {
+        TimeLog time_log(directory.filepath("log"), k_time_format, 50, false, "yearly");
+        time_log.append_entry("d", time_point("2017-06-01T10:00"));
+    }
+    BOOST_CHECK_EQUAL
+    (   directory.read("log"),
+        "2017-06-01T09:00 c\n2017-06-01T10:00 d\n"
+    );
+    BOOST_CHECK_EQUAL(directory.read("log.2015"), "2015-06-01T09:00 a\n");
+    BOOST_CHECK_EQUAL(directory.read("log.2016"), "2016-06-01T09:00 b\n");
+    TimeLog time_log(directory.filepath("log"), k_time_format, 50, false, "yearly");
+    BOOST_CHECK((activities(time_log) == vector<string>{"a", "b", "c", "d"}));
+}
+
+BOOST_AUTO_TEST_CASE(time_log_reports_errors_in_skipped_history)
+{
+    // A query of recent activity reads only the end of the log, so does not
+    // see an error early in it; but a query of the whole history does.
+    vector<string> log_activities;
+    for (int i = 0; i != 2000; ++i)
+    {
+        log_activities.push_back("a" + to_string(i % 3));
+    }
+    auto const contents = log_text(log_activities, "2016-01-01T09:00", 10);
+    string const line = "2016-01-01T09:00 a0\n";
+    auto const position = 4 * line.size();
+    vector<pair<string, string>> const cases
+    {   {   "2016-01-01T09:25 a1\n",
+            "Time log entries out of order at line 5."
+        },
+        {   "a1\n",
+            "Error parsing the time log at line 5."
+        }
+    };
+    for (auto const& c: cases)
+    {
+        auto damaged = contents;
+        damaged.replace(position, line.size(), c.first);
+        TemporaryDirectory const directory;
+        directory.write("log", damaged);
+        TimeLog time_log(directory.filepath("log"), k_time_format, 50, false);
+        auto const begin = time_point("2016-01-14T00:00");
+        BOOST_CHECK_EQUAL(time_log.last_activities(1).size(), 1);
+        BOOST_CHECK(!time_log.get_stints(TrueActivityFilter(), &begin, nullptr).empty());
+        string error;
+        try
+        {
+            time_log.get_stints(TrueActivityFilter(), nullptr, nullptr);
+        }
+        catch (runtime_error& e)
+        {
+            error = e.what();
+        }
+        BOOST_CHECK_EQUAL(error, c.second);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(time_log_completes_interrupted_rotation)
+{
+    TemporaryDirectory const directory;
+    string const original = "2015-06-01T09:00 a\n2016-06-01T09:00 b\n";
+    directory.write("log", original);
+    // anonymous scope
+    {
+        TimeLog time_log(directory.filepath("log"), k_time_format, 50, false, "yearly");
+        time_log.append_entry("c", time_point("2017-06-01T09:00"));
+    }
+    auto const rotated = directory.read("log");
+    BOOST_CHECK_EQUAL(rotated, "2017-06-01T09:00 c\n");
+
+    // As left by a rotation that was interrupted after the manifest was
+    // written, but before the new log file was moved into place
+    auto const manifest = directory.read("log.manifest");
+    vector<Segment> segments;
+    auto rotating = false;
+    BOOST_REQUIRE
+    (   decode_manifest
+        (   manifest.data(),
+            manifest.data() + manifest.size(),
+            segments,
+            rotating
+        )
+    );
+    BOOST_CHECK(!rotating);
+    BOOST_CHECK_EQUAL(segments.size(), 2);
+    directory.write("log.manifest", encode_manifest(segments, true));
+    directory.write("log.staging", rotated);
+    directory.write("log", original + "2017-06-01T09:00 c\n");
+
+    TimeLog time_log(directory.filepath("log"), k_time_format, 50, false, "yearly");
+    BOOST_CHECK((activities(time_log) == vector<string>{"a", "b", "c"}));
+    BOOST_CHECK_EQUAL(directory.read("log"), rotated);
+    BOOST_CHECK_EQUAL(directory.read("log.manifest"), manifest);
+    BOOST_CHECK(!file_exists_at(directory.filepath("log.staging")));
+}
+
+BOOST_AUTO_TEST_CASE(time_log_loads_suffix_across_segments)
+{
+    // Entries every ten hours over three years, so that the last year is read
+    // from the log file in more than one block, and the earlier years from
+    // their segments.
+    string contents;
+    vector<string>::size_type const num_activities = 1500;
+    auto stamp_time = long_time_stamp_to_point("2015-01-01T00:00", k_time_format);
+    for (vector<string>::size_type i = 0; i != 2600; ++i)
+    {
+        contents +=
+            time_point_to_stamp(stamp_time, k_time_format, 50) + " task " +
+            to_string(i % num_activities) + '\n';
+        stamp_time += std::chrono::hours(10);
+    }
+    TemporaryDirectory const directory;
+    directory.write("log", contents);
+    // anonymous scope
+    {
+        TimeLog time_log(directory.filepath("log"), k_time_format, 50, false, "yearly");
+        time_log.append_entry("done", stamp_time);
+    }
+    BOOST_CHECK(file_exists_at(directory.filepath("log.2015")));
+    BOOST_CHECK(file_exists_at(directory.filepath("log.2016")));
+    BOOST_CHECK_EQUAL(directory.read("log").substr(0, 4), "2017");
+
+    TimeLog full_time_log(directory.filepath("log"), k_time_format, 50, false, "yearly");
+    auto const stints = full_time_log.get_stints(TrueActivityFilter(), nullptr, nullptr);
+    BOOST_CHECK_EQUAL(stints.size(), 2601);
+    TimeLog suffix_time_log(directory.filepath("log"), k_time_format, 50, false, "yearly");
+    for (auto const num: {1, 10, 1000, 1499})
+    {
+        BOOST_CHECK
+        (   suffix_time_log.last_activities(num) ==
+            full_time_log.last_activities(num)
+        );
+    }
+    for (auto const& time_stamp: {"2017-11-01T00:00", "2016-03-01T12:00"})
+    {
+        auto const begin = long_time_stamp_to_point(time_stamp, k_time_format);
+        BOOST_CHECK
+        (   describe(suffix_time_log.get_stints(TrueActivityFilter(), &begin, nullptr)) ==
+            describe(full_time_log.get_stints(TrueActivityFilter(), &begin, nullptr))
+        );
+    }
+}
+
+}  // namespace test
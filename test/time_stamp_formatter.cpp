@@ -0,0 +1,105 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "time_stamp_formatter.hpp"
+#include "time_point.hpp"
+#include "time_zone_guard.hpp"
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+using swx::TimePoint;
+using swx::TimeStampFormatter;
+using swx::long_time_stamp_to_point;
+using swx::time_point_to_stamp;
+
+namespace test
+{
+
+BOOST_AUTO_TEST_CASE(time_stamp_formatter_is_specialized)
+{
+    BOOST_CHECK(TimeStampFormatter("%Y-%m-%dT%H:%M", 50).is_specialized());
+    BOOST_CHECK(TimeStampFormatter("%F %T", 50).is_specialized());
+    BOOST_CHECK(TimeStampFormatter("%d/%m/%Y %R %%", 50).is_specialized());
+    BOOST_CHECK(TimeStampFormatter("%H:%M", 50).is_specialized());
+    BOOST_CHECK(!TimeStampFormatter("%Y-%m-%dT%H:%M %Z", 50).is_specialized());
+    BOOST_CHECK(!TimeStampFormatter("%b %d %Y %H:%M", 50).is_specialized());
+    BOOST_CHECK(!TimeStampFormatter("%H:%M %H", 50).is_specialized());
+    BOOST_CHECK(!TimeStampFormatter("%Y-%m-%d %", 50).is_specialized());
+}
+
+BOOST_AUTO_TEST_CASE(time_stamp_formatter_matches_strftime)
+{
+    vector<char const*> const zones
+    {   "UTC",
+        "Australia/Melbourne",
+        "Australia/Lord_Howe",
+        "America/New_York",
+        "Europe/London"
+    };
+    vector<string> const formats
+    {   "%Y-%m-%dT%H:%M",
+        "%F %T",
+        "%d/%m/%Y %R",
+        "%a %b %d %Y %H:%M %Z"  // not specialized
+    };
+    for (auto const zone: zones)
+    {
+        TimeZoneGuard const guard(zone);
+        for (auto const& format: formats)
+        {
+            TimeStampFormatter formatter(format, 50);
+
+            // At irregular intervals across 2 years, which includes several
+            // daylight saving transitions in each zone that has them, and
+            // including repeated and backwards steps.
+            auto const start = long_time_stamp_to_point("2015-01-01T00:00", "%Y-%m-%dT%H:%M");
+            for (int i = 0; i < 2 * 365 * 24 * 60 / 7; i += (i % 11 == 0 ? 0 : 29))
+            {
+                TimePoint const tp =
+                    start + std::chrono::minutes(7 * i) + std::chrono::seconds(i % 61);
+                auto const expected = time_point_to_stamp(tp, format, 50);
+                BOOST_CHECK_EQUAL(formatter.format(tp), expected);
+                BOOST_CHECK_EQUAL(formatter.format(tp), expected);
+                if (i % 11 == 0)
+                {
+                    ++i;
+                    auto const earlier = tp - std::chrono::hours(30);
+                    auto const earlier_expected = time_point_to_stamp(earlier, format, 50);
+                    BOOST_CHECK_EQUAL(formatter.format(earlier), earlier_expected);
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(time_stamp_formatter_errors)
+{
+    TimeZoneGuard const guard("Australia/Melbourne");
+    auto const tp = long_time_stamp_to_point("2016-04-03T02:30", "%Y-%m-%dT%H:%M");
+    TimeStampFormatter short_formatter("%Y-%m-%dT%H:%M", 16);
+    BOOST_CHECK_THROW(short_formatter.format(tp), std::runtime_error);
+    TimeStampFormatter long_enough_formatter("%Y-%m-%dT%H:%M", 17);
+    BOOST_CHECK_EQUAL(long_enough_formatter.format(tp), "2016-04-03T02:30");
+    TimeStampFormatter empty_formatter("", 50);
+    BOOST_CHECK_THROW(empty_formatter.format(tp), std::runtime_error);
+}
+
+}  // namespace test
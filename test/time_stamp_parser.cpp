@@ -0,0 +1,122 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "time_stamp_parser.hpp"
+#include "time_point.hpp"
+#include "time_zone_guard.hpp"
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+using swx::TimePoint;
+using swx::TimeStampParser;
+using swx::long_time_stamp_to_point;
+using swx::time_point_to_stamp;
+
+namespace test
+{
+
+namespace
+{
+    void check_parse(TimeStampParser& p_parser, string const& p_stamp, string const& p_format)
+    {
+        auto const expected = long_time_stamp_to_point(p_stamp, p_format);
+        auto const actual = p_parser.parse(p_stamp.data(), p_stamp.data() + p_stamp.size());
+
+        // During the hour that is repeated when daylight saving ends, the
+        // stamp is ambiguous, and which interpretation mktime chooses depends
+        // on its previous calls. Either interpretation is then acceptable.
+        BOOST_CHECK_MESSAGE
+        (   (actual == expected) ||
+                (time_point_to_stamp(actual, p_format, 50) == p_stamp),
+            "mismatch parsing " + p_stamp
+        );
+    }
+
+}  // end anonymous namespace
+
+BOOST_AUTO_TEST_CASE(time_stamp_parser_is_specialized)
+{
+    BOOST_CHECK(TimeStampParser("%Y-%m-%dT%H:%M").is_specialized());
+    BOOST_CHECK(TimeStampParser("%F %T").is_specialized());
+    BOOST_CHECK(TimeStampParser("%d/%m/%Y %R").is_specialized());
+    BOOST_CHECK(TimeStampParser("%Y%m%d").is_specialized());
+    BOOST_CHECK(!TimeStampParser("%H:%M").is_specialized());
+    BOOST_CHECK(!TimeStampParser("%Y-%m-%dT%H:%M %Z").is_specialized());
+    BOOST_CHECK(!TimeStampParser("%b %d %Y %H:%M").is_specialized());
+    BOOST_CHECK(!TimeStampParser("%Y-%m-%d %Y").is_specialized());
+    BOOST_CHECK(!TimeStampParser("%Y-%m-%d %").is_specialized());
+}
+
+BOOST_AUTO_TEST_CASE(time_stamp_parser_matches_strptime)
+{
+    vector<char const*> const zones
+    {   "UTC",
+        "Australia/Melbourne",
+        "Australia/Lord_Howe",
+        "America/New_York",
+        "Europe/London"
+    };
+    vector<string> const formats
+    {   "%Y-%m-%dT%H:%M",
+        "%F %T",
+        "%d/%m/%Y %H:%M",
+        "%b %d %Y %H:%M"  // not specialized
+    };
+    for (auto const zone: zones)
+    {
+        TimeZoneGuard const guard(zone);
+        for (auto const& format: formats)
+        {
+            TimeStampParser parser(format);
+
+            // Every 7 minutes across 2 years, which includes several daylight
+            // saving transitions in each zone that has them.
+            auto const start = long_time_stamp_to_point("2015-01-01T00:00", "%Y-%m-%dT%H:%M");
+            for (int i = 0; i < 2 * 365 * 24 * 60 / 7; i += 1 + (i % 13 == 0 ? 0 : 60))
+            {
+                TimePoint const tp = start + std::chrono::minutes(7 * i);
+                check_parse(parser, time_point_to_stamp(tp, format, 50), format);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(time_stamp_parser_falls_back)
+{
+    TimeZoneGuard const guard("Australia/Melbourne");
+    string const format("%Y-%m-%dT%H:%M");
+    TimeStampParser parser(format);
+
+    // not zero-padded, overflowing the month, and ambiguous
+    check_parse(parser, "2016-1-05T09:30", format);
+    check_parse(parser, "2016-04-31T09:30", format);
+    check_parse(parser, "2016-02-30T23:59", format);
+    check_parse(parser, "2016-04-03T02:30", format);
+    BOOST_CHECK_THROW(parser.parse(nullptr, nullptr), std::runtime_error);
+    string const bad("2016-13-01T09:30");
+    BOOST_CHECK_THROW(parser.parse(bad.data(), bad.data() + bad.size()), std::runtime_error);
+    string const garbage("blah");
+    BOOST_CHECK_THROW
+    (   parser.parse(garbage.data(), garbage.data() + garbage.size()),
+        std::runtime_error
+    );
+}
+
+}  // namespace test
@@ -0,0 +1,206 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "time_zone.hpp"
+#include "time_zone_guard.hpp"
+#include <boost/test/unit_test.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::memset;
+using std::string;
+using std::thread;
+using std::time_t;
+using std::tm;
+using std::vector;
+using swx::TimeZone;
+
+namespace test
+{
+
+namespace
+{
+    vector<char const*> const k_zones
+    {   "UTC",
+        "Australia/Melbourne",
+        "Australia/Lord_Howe",
+        "America/New_York",
+        "Europe/London",
+        "Africa/Casablanca"
+    };
+
+    tm make_tm(int p_year, int p_month, int p_day, int p_hour, int p_minute, int p_isdst)
+    {
+        tm ret;
+        memset(&ret, 0, sizeof(ret));
+        ret.tm_year = p_year - 1900;
+        ret.tm_mon = p_month - 1;
+        ret.tm_mday = p_day;
+        ret.tm_hour = p_hour;
+        ret.tm_min = p_minute;
+        ret.tm_isdst = p_isdst;
+        return ret;
+    }
+
+}  // end anonymous namespace
+
+BOOST_AUTO_TEST_CASE(time_zone_to_tm_matches_localtime)
+{
+    for (auto const zone: k_zones)
+    {
+        TimeZoneGuard const guard(zone);
+        auto const& time_zone = TimeZone::local();
+
+        // At irregular intervals from before 1970 until after 2037.
+        for (auto seconds = -400000000LL; seconds < 2300000000LL; seconds += 259234)
+        {
+            auto const actual = time_zone.to_tm(seconds);
+            time_t const time_time_t = static_cast<time_t>(seconds);
+            tm expected;
+            localtime_r(&time_time_t, &expected);
+            BOOST_CHECK_EQUAL(actual.tm_year, expected.tm_year);
+            BOOST_CHECK_EQUAL(actual.tm_mon, expected.tm_mon);
+            BOOST_CHECK_EQUAL(actual.tm_mday, expected.tm_mday);
+            BOOST_CHECK_EQUAL(actual.tm_hour, expected.tm_hour);
+            BOOST_CHECK_EQUAL(actual.tm_min, expected.tm_min);
+            BOOST_CHECK_EQUAL(actual.tm_sec, expected.tm_sec);
+            BOOST_CHECK_EQUAL(actual.tm_wday, expected.tm_wday);
+            BOOST_CHECK_EQUAL(actual.tm_yday, expected.tm_yday);
+            BOOST_CHECK_EQUAL(actual.tm_isdst, expected.tm_isdst);
+            BOOST_CHECK_EQUAL(actual.tm_gmtoff, expected.tm_gmtoff);
+            BOOST_CHECK_EQUAL(string(actual.tm_zone), string(expected.tm_zone));
+            BOOST_CHECK_EQUAL(time_zone.utc_offset(seconds), expected.tm_gmtoff);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(time_zone_to_seconds_matches_mktime)
+{
+    for (auto const zone: k_zones)
+    {
+        TimeZoneGuard const guard(zone);
+        auto const& time_zone = TimeZone::local();
+
+        // Every 5 hours and 7 minutes across 2 years, including fields beyond
+        // their normal ranges, and each daylight saving flag.
+        for (int i = 0; i != 2 * 365 * 24 * 60 / (5 * 60 + 7); ++i)
+        {
+            for (int isdst = -1; isdst <= 1; ++isdst)
+            {
+                auto time_tm = make_tm(2015, 1, 1, 0, i * (5 * 60 + 7), isdst);
+                auto const actual = time_zone.to_seconds(time_tm);
+                auto const expected = static_cast<long long>(std::mktime(&time_tm));
+                if ((isdst < 0) && (actual != expected))
+                {
+                    // mktime's choice between two occurrences of an ambiguous
+                    // local time depends on its previous calls.
+                    auto const actual_tm = time_zone.to_tm(actual);
+                    BOOST_CHECK_EQUAL(actual_tm.tm_hour, time_tm.tm_hour);
+                    BOOST_CHECK_EQUAL(actual_tm.tm_min, time_tm.tm_min);
+                    auto const difference = (actual_tm.tm_isdst ? -3600 : 3600);
+                    BOOST_CHECK_EQUAL(actual - expected, difference);
+                }
+                else
+                {
+                    BOOST_CHECK_EQUAL(actual, expected);
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(time_zone_beyond_table)
+{
+    for (auto const zone: k_zones)
+    {
+        TimeZoneGuard const guard(zone);
+        auto const& time_zone = TimeZone::local();
+
+        // Every 5 hours and 7 minutes across 2040, converted to seconds and
+        // back from several threads at once, as when a log is parsed in
+        // parallel.
+        int const num_samples = 365 * 24 * 60 / (5 * 60 + 7);
+        vector<long long> expected;
+        for (int i = 0; i != num_samples; ++i)
+        {
+            auto time_tm = make_tm(2040, 1, 1, 0, i * (5 * 60 + 7), 0);
+            time_t const time_time_t = std::mktime(&time_tm);
+            tm local_tm;
+            localtime_r(&time_time_t, &local_tm);
+            expected.push_back(static_cast<long long>(time_time_t));
+            expected.push_back(local_tm.tm_gmtoff);
+        }
+        vector<vector<long long>> actual(4);
+        vector<thread> threads;
+        for (auto& results: actual)
+        {
+            threads.emplace_back
+            (   [&time_zone, &results, num_samples]()
+                {
+                    for (int i = 0; i != num_samples; ++i)
+                    {
+                        auto const time_tm = make_tm(2040, 1, 1, 0, i * (5 * 60 + 7), 0);
+                        auto const seconds = time_zone.to_seconds(time_tm);
+                        results.push_back(seconds);
+                        results.push_back(time_zone.to_tm(seconds).tm_gmtoff);
+                    }
+                }
+            );
+        }
+        for (auto& t: threads) t.join();
+        for (auto const& results: actual)
+        {
+            BOOST_CHECK(results == expected);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(time_zone_resolves_transitions)
+{
+    TimeZoneGuard const guard("Australia/Melbourne");
+    auto const& time_zone = TimeZone::local();
+    auto const check = [&time_zone](tm const& p_tm, long long p_expected)
+    {
+        BOOST_CHECK_EQUAL(time_zone.to_seconds(p_tm), p_expected);
+    };
+
+    // 2016-04-03 02:30 occurs twice; the earlier (daylight saving) occurrence is
+    // preferred unless standard time is requested.
+    check(make_tm(2016, 4, 3, 2, 30, -1), 1459611000);
+    check(make_tm(2016, 4, 3, 2, 30, 1), 1459611000);
+    check(make_tm(2016, 4, 3, 2, 30, 0), 1459614600);
+
+    // 2016-10-02 02:30 does not occur, and is read forward as 03:30 unless
+    // daylight saving is requested.
+    check(make_tm(2016, 10, 2, 2, 30, -1), 1475339400);
+    check(make_tm(2016, 10, 2, 2, 30, 0), 1475339400);
+    check(make_tm(2016, 10, 2, 2, 30, 1), 1475335800);
+
+    // overflowing and negative fields
+    auto const normalized = [&time_zone](tm const& p_tm)
+    {
+        return time_zone.to_seconds(p_tm);
+    };
+    check(make_tm(2016, 1, 32, 0, 0, -1), normalized(make_tm(2016, 2, 1, 0, 0, -1)));
+    check(make_tm(2016, 13, 1, -1, 0, -1), normalized(make_tm(2016, 12, 31, 23, 0, -1)));
+    check(make_tm(2016, -1, 1, 48, 0, -1), normalized(make_tm(2015, 11, 3, 0, 0, -1)));
+}
+
+}  // namespace test
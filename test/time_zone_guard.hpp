@@ -0,0 +1,62 @@
+/*
+ * Copyright 2017 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_time_zone_guard_hpp_6444853961052912
+#define GUARD_time_zone_guard_hpp_6444853961052912
+
+#include <cstdlib>
+#include <ctime>
+#include <string>
+
+namespace test
+{
+
+/**
+ * Sets the TZ environment variable for the lifetime of the object,
+ * restoring its original value, or lack of one, on destruction.
+ */
+class TimeZoneGuard
+{
+// special member functions
+public:
+    explicit TimeZoneGuard(char const* p_zone)
+    {
+        auto const original = std::getenv("TZ");
+        m_had_original = (original != nullptr);
+        if (m_had_original) m_original = original;
+        setenv("TZ", p_zone, 1);  // non-portable
+        tzset();  // non-portable
+    }
+    TimeZoneGuard(TimeZoneGuard const& rhs) = delete;
+    TimeZoneGuard(TimeZoneGuard&& rhs) = delete;
+    TimeZoneGuard& operator=(TimeZoneGuard const& rhs) = delete;
+    TimeZoneGuard& operator=(TimeZoneGuard&& rhs) = delete;
+    ~TimeZoneGuard()
+    {
+        if (m_had_original) setenv("TZ", m_original.c_str(), 1);  // non-portable
+        else unsetenv("TZ");  // non-portable
+        tzset();  // non-portable
+    }
+
+// member variables
+private:
+    bool m_had_original;
+    std::string m_original;
+};
+
+}  // namespace test
+
+#endif  // GUARD_time_zone_guard_hpp_6444853961052912